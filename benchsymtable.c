@@ -0,0 +1,225 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtable.c                                                    */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef S_SPLINT_S
+#include <sys/resource.h>
+#endif
+
+/* number of timed lookups per table size */
+enum {LOOKUP_COUNT = 1000000};
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 24};
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Puts the bindings "0" through "uCount - 1" into oSymTable. Returns 1
+(TRUE) if successful and 0 (FALSE) if there is insufficient
+memory. */
+static int fillTable(SymTable_T oSymTable, size_t uCount) {
+    char acKey[MAX_KEY_LENGTH];
+    size_t u;
+
+    for(u = 0; u < uCount; u++) {
+        sprintf(acKey, "%lu", (unsigned long)u);
+        if(!SymTable_put(oSymTable, acKey, oSymTable)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Times LOOKUP_COUNT successful SymTable_get calls for random keys in
+a table of uCount bindings, for uCount = 10^3, 10^4, ... up to
+uMaxCount. Keys are generated before the clock starts, so only the
+lookups are timed. Returns 0 if successful and 1 if not. */
+static int benchLookup(size_t uMaxCount) {
+    SymTable_T oSymTable;
+    char *pcKeys;
+    size_t uCount;
+    size_t uState = 217;
+    size_t u;
+    size_t uFound;
+    double dStart;
+    double dPut;
+    double dGet;
+
+    pcKeys = (char *)malloc((size_t)LOOKUP_COUNT * MAX_KEY_LENGTH);
+    if(pcKeys == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        return 1;
+    }
+
+    printf("%12s %14s %14s\n", "bindings", "put ns/op", "get ns/op");
+    for(uCount = 1000; uCount <= uMaxCount; uCount *= 10) {
+        oSymTable = SymTable_new();
+        dStart = cpuSeconds();
+        if(oSymTable == NULL || !fillTable(oSymTable, uCount)) {
+            fprintf(stderr, "insufficient memory at %lu bindings\n",
+            (unsigned long)uCount);
+            if(oSymTable != NULL) {
+                SymTable_free(oSymTable);
+            }
+            free(pcKeys);
+            return 1;
+        }
+        dPut = cpuSeconds() - dStart;
+
+        for(u = 0; u < LOOKUP_COUNT; u++) {
+            sprintf(pcKeys + u * MAX_KEY_LENGTH, "%lu",
+            (unsigned long)(nextRandom(&uState) % uCount));
+        }
+
+        uFound = 0;
+        dStart = cpuSeconds();
+        for(u = 0; u < LOOKUP_COUNT; u++) {
+            if(SymTable_get(oSymTable, pcKeys + u * MAX_KEY_LENGTH)
+            != NULL) {
+                uFound++;
+            }
+        }
+        dGet = cpuSeconds() - dStart;
+
+        if(uFound != LOOKUP_COUNT) {
+            fprintf(stderr, "lookup failed at %lu bindings\n",
+            (unsigned long)uCount);
+        }
+        printf("%12lu %14.1f %14.1f\n", (unsigned long)uCount,
+        dPut * 1e9 / (double)uCount, dGet * 1e9 / LOOKUP_COUNT);
+        fflush(stdout);
+
+        SymTable_free(oSymTable);
+    }
+
+    free(pcKeys);
+    return 0;
+}
+
+/* Returns the peak resident set size of the process so far, in
+kilobytes, or 0 where it cannot be measured. */
+static long peakKilobytes(void) {
+#ifndef S_SPLINT_S
+    struct rusage sUsage;
+    if(getrusage(RUSAGE_SELF, &sUsage) == 0) {
+        return (long)sUsage.ru_maxrss;
+    }
+#endif
+    return 0;
+}
+
+/* Measures the memory used per binding by a table of uCount bindings,
+and the cost of LOOKUP_COUNT successful SymTable_get calls on it.
+Everything else the benchmark needs is allocated before the first
+measurement, so the growth of the peak resident set size is the
+table's. Returns 0 if successful and 1 if not. */
+static int benchMemory(size_t uCount) {
+    SymTable_T oSymTable;
+    char *pcKeys;
+    size_t uState = 217;
+    size_t u;
+    size_t uFound = 0;
+    long lBefore;
+    long lAfter;
+    double dStart;
+    double dGet;
+
+    if(uCount == 0) {
+        fprintf(stderr, "count must be positive\n");
+        return 1;
+    }
+    pcKeys = (char *)malloc((size_t)LOOKUP_COUNT * MAX_KEY_LENGTH);
+    if(pcKeys == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        return 1;
+    }
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        sprintf(pcKeys + u * MAX_KEY_LENGTH, "%lu",
+        (unsigned long)(nextRandom(&uState) % uCount));
+    }
+
+    lBefore = peakKilobytes();
+    oSymTable = SymTable_new();
+    if(oSymTable == NULL || !fillTable(oSymTable, uCount)) {
+        fprintf(stderr, "insufficient memory\n");
+        if(oSymTable != NULL) {
+            SymTable_free(oSymTable);
+        }
+        free(pcKeys);
+        return 1;
+    }
+    lAfter = peakKilobytes();
+
+    dStart = cpuSeconds();
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        if(SymTable_get(oSymTable, pcKeys + u * MAX_KEY_LENGTH)
+        != NULL) {
+            uFound++;
+        }
+    }
+    dGet = cpuSeconds() - dStart;
+    if(uFound != LOOKUP_COUNT) {
+        fprintf(stderr, "lookup failed\n");
+    }
+
+    printf("%12s %14s %14s\n", "bindings", "bytes/binding",
+    "get ns/op");
+    printf("%12lu %14.1f %14.1f\n", (unsigned long)uCount,
+    (double)(lAfter - lBefore) * 1024.0 / (double)uCount,
+    dGet * 1e9 / LOOKUP_COUNT);
+
+    SymTable_free(oSymTable);
+    free(pcKeys);
+    return 0;
+}
+
+/* Runs the benchmark named by argv[1]. argv[2], if present, is the
+table size to measure. Writes the results to stdout. Returns
+0 if successful and EXIT_FAILURE if not.
+
+   lookup [maxcount]   put and get cost from 10^3 bindings up to
+                       maxcount (default 10^7) bindings
+   memory [count]      bytes per binding and get cost for a table of
+                       count (default 10^7) bindings */
+int main(int argc, char *argv[]) {
+    unsigned long ulCount = 10000000;
+
+    if(argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s lookup|memory [count]\n",
+        argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc == 3 && sscanf(argv[2], "%lu", &ulCount) != 1) {
+        fprintf(stderr, "count must be numeric\n");
+        return EXIT_FAILURE;
+    }
+
+    if(!strcmp(argv[1], "lookup")) {
+        return benchLookup((size_t)ulCount) ? EXIT_FAILURE : 0;
+    }
+
+    if(!strcmp(argv[1], "memory")) {
+        return benchMemory((size_t)ulCount) ? EXIT_FAILURE : 0;
+    }
+
+    fprintf(stderr, "unknown benchmark: %s\n", argv[1]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,333 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtableconc.c                                                */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime and pthread_rwlock_t are POSIX.1-2001 */
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include "symtableconc.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* number of distinct keys the operations choose from. Half of them
+are in the table when a run starts. */
+enum {KEY_COUNT = 1 << 20};
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 16};
+
+/* most threads a run can use */
+enum {MAX_THREADS = 64};
+
+/* A Mix is the share of operations of a run, in tenths of a percent,
+that are gets and puts; the rest are removes. Puts and removes are
+balanced, so the table stays about half full. */
+struct Mix
+{
+    const char *pcName;
+    int iGetPermille;
+    int iPutPermille;
+};
+
+static const struct Mix asMixes[] = {
+    {"99/.5/.5", 990, 5},
+    {"90/5/5", 900, 50},
+    {"50/25/25", 500, 250},
+    {"10/45/45", 100, 450}
+};
+
+/* A Target is a table under test, reached through the same calls
+whatever its implementation. */
+struct Target
+{
+    const char *pcName;
+    void *(*pfNew)(void);
+    void (*pfFree)(void *pvTable);
+    void *(*pfGet)(void *pvTable, const char *pcKey);
+    int (*pfPut)(void *pvTable, const char *pcKey, const void *pvValue);
+    void *(*pfRemove)(void *pvTable, const char *pcKey);
+};
+
+/* A LockedTable is a SymTable_T object behind one mutex, which is how
+threads share a table without SymTableConc_T. */
+struct LockedTable
+{
+    pthread_mutex_t sMutex;
+    SymTable_T oSymTable;
+};
+
+static void *lockedNew(void) {
+    struct LockedTable *psTable;
+
+    psTable = (struct LockedTable *)malloc(sizeof(struct LockedTable));
+    if(psTable == NULL) {
+        return NULL;
+    }
+    psTable->oSymTable = SymTable_new();
+    if(psTable->oSymTable == NULL
+    || pthread_mutex_init(&psTable->sMutex, NULL) != 0) {
+        if(psTable->oSymTable != NULL) {
+            SymTable_free(psTable->oSymTable);
+        }
+        free(psTable);
+        return NULL;
+    }
+    return psTable;
+}
+
+static void lockedFree(void *pvTable) {
+    struct LockedTable *psTable = (struct LockedTable *)pvTable;
+
+    pthread_mutex_destroy(&psTable->sMutex);
+    SymTable_free(psTable->oSymTable);
+    free(psTable);
+}
+
+static void *lockedGet(void *pvTable, const char *pcKey) {
+    struct LockedTable *psTable = (struct LockedTable *)pvTable;
+    void *pvValue;
+
+    pthread_mutex_lock(&psTable->sMutex);
+    pvValue = SymTable_get(psTable->oSymTable, pcKey);
+    pthread_mutex_unlock(&psTable->sMutex);
+    return pvValue;
+}
+
+static int lockedPut(void *pvTable, const char *pcKey,
+const void *pvValue) {
+    struct LockedTable *psTable = (struct LockedTable *)pvTable;
+    int iSuccessful;
+
+    pthread_mutex_lock(&psTable->sMutex);
+    iSuccessful = SymTable_put(psTable->oSymTable, pcKey, pvValue);
+    pthread_mutex_unlock(&psTable->sMutex);
+    return iSuccessful;
+}
+
+static void *lockedRemove(void *pvTable, const char *pcKey) {
+    struct LockedTable *psTable = (struct LockedTable *)pvTable;
+    void *pvValue;
+
+    pthread_mutex_lock(&psTable->sMutex);
+    pvValue = SymTable_remove(psTable->oSymTable, pcKey);
+    pthread_mutex_unlock(&psTable->sMutex);
+    return pvValue;
+}
+
+static void *concNew(void) {
+    return SymTableConc_new();
+}
+
+static void concFree(void *pvTable) {
+    SymTableConc_free((SymTableConc_T)pvTable);
+}
+
+static void *lockFreeNew(void) {
+    return SymTableConc_newLockFreeReads();
+}
+
+static void *concGet(void *pvTable, const char *pcKey) {
+    return SymTableConc_get((SymTableConc_T)pvTable, pcKey);
+}
+
+static int concPut(void *pvTable, const char *pcKey,
+const void *pvValue) {
+    return SymTableConc_put((SymTableConc_T)pvTable, pcKey, pvValue);
+}
+
+static void *concRemove(void *pvTable, const char *pcKey) {
+    return SymTableConc_remove((SymTableConc_T)pvTable, pcKey);
+}
+
+static const struct Target asTargets[] = {
+    {"mutex", lockedNew, lockedFree, lockedGet, lockedPut,
+    lockedRemove},
+    {"striped", concNew, concFree, concGet, concPut, concRemove},
+    {"lock-free", lockFreeNew, concFree, concGet, concPut, concRemove}
+};
+
+enum {TARGET_COUNT = sizeof(asTargets) / sizeof(asTargets[0])};
+
+/* A Worker is the share of one thread of a run. */
+struct Worker
+{
+    const struct Target *psTarget;
+    void *pvTable;
+    const struct Mix *psMix;
+    /* keys, KEY_COUNT of them, MAX_KEY_LENGTH bytes apart */
+    const char *pcKeys;
+    size_t uOps;
+    size_t uSeed;
+};
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. rand() is not thread-safe, so each thread keeps its own
+state. */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns the time elapsed on a clock that only moves forward, in
+seconds. The threads of a run share the CPU, so wall time, not CPU
+time, measures throughput. */
+static double wallSeconds(void) {
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+    return (double)sNow.tv_sec + (double)sNow.tv_nsec / 1e9;
+}
+
+/* Performs the operations of the Worker pvWorker: random gets, puts,
+and removes of random keys in the proportions of its mix. Returns
+NULL. */
+static void *runWorker(void *pvWorker) {
+    struct Worker *psWorker = (struct Worker *)pvWorker;
+    const struct Target *psTarget = psWorker->psTarget;
+    const char *pcKey;
+    size_t uState = psWorker->uSeed;
+    size_t u;
+    int iPermille;
+
+    for(u = 0; u < psWorker->uOps; u++) {
+        pcKey = psWorker->pcKeys
+        + (nextRandom(&uState) % KEY_COUNT) * MAX_KEY_LENGTH;
+        iPermille = (int)(nextRandom(&uState) % 1000);
+        if(iPermille < psWorker->psMix->iGetPermille) {
+            (*psTarget->pfGet)(psWorker->pvTable, pcKey);
+        }
+        else if(iPermille < psWorker->psMix->iGetPermille
+        + psWorker->psMix->iPutPermille) {
+            (*psTarget->pfPut)(psWorker->pvTable, pcKey, pcKey);
+        }
+        else {
+            (*psTarget->pfRemove)(psWorker->pvTable, pcKey);
+        }
+    }
+    return NULL;
+}
+
+/* Runs uTotalOps operations of psMix on a new table of psTarget,
+divided among iThreads threads, and returns the throughput in
+millions of operations per second, or a negative number if a table or
+thread cannot be created. The table starts with every other key. */
+static double runMix(const struct Target *psTarget,
+const struct Mix *psMix, const char *pcKeys, int iThreads,
+size_t uTotalOps) {
+    struct Worker asWorkers[MAX_THREADS];
+    pthread_t aThreads[MAX_THREADS];
+    void *pvTable;
+    const char *pcKey;
+    double dStart;
+    double dSeconds;
+    size_t u;
+    int iThread;
+    int iStarted;
+
+    pvTable = (*psTarget->pfNew)();
+    if(pvTable == NULL) {
+        return -1.0;
+    }
+    for(u = 0; u < KEY_COUNT; u += 2) {
+        pcKey = pcKeys + u * MAX_KEY_LENGTH;
+        if(!(*psTarget->pfPut)(pvTable, pcKey, pcKey)) {
+            (*psTarget->pfFree)(pvTable);
+            return -1.0;
+        }
+    }
+
+    for(iThread = 0; iThread < iThreads; iThread++) {
+        asWorkers[iThread].psTarget = psTarget;
+        asWorkers[iThread].pvTable = pvTable;
+        asWorkers[iThread].psMix = psMix;
+        asWorkers[iThread].pcKeys = pcKeys;
+        asWorkers[iThread].uOps = uTotalOps / (size_t)iThreads;
+        asWorkers[iThread].uSeed = 217 + (size_t)iThread;
+    }
+
+    dStart = wallSeconds();
+    for(iStarted = 0; iStarted < iThreads; iStarted++) {
+        if(pthread_create(&aThreads[iStarted], NULL, runWorker,
+        &asWorkers[iStarted]) != 0) {
+            break;
+        }
+    }
+    for(iThread = 0; iThread < iStarted; iThread++) {
+        pthread_join(aThreads[iThread], NULL);
+    }
+    dSeconds = wallSeconds() - dStart;
+
+    (*psTarget->pfFree)(pvTable);
+    if(iStarted < iThreads) {
+        return -1.0;
+    }
+    return dSeconds > 0
+    ? (double)(uTotalOps / (size_t)iThreads * (size_t)iThreads)
+    / dSeconds / 1e6 : 0.0;
+}
+
+/* Measures the throughput of a table shared by 1, 2, 4, ... up to
+argv[1] (default 64) threads, for each mix of gets, puts, and removes,
+for a SymTable_T object behind one mutex and for SymTableConc_T
+objects with locked and with lock-free reads. argv[2], if present, is
+the number of operations of each run (default 4 * 10^6). Writes the
+results to stdout. Returns 0 if successful and EXIT_FAILURE if not. */
+int main(int argc, char *argv[]) {
+    unsigned long ulMaxThreads = MAX_THREADS;
+    unsigned long ulTotalOps = 4000000;
+    double adMops[TARGET_COUNT];
+    char *pcKeys;
+    size_t uMix;
+    size_t uTarget;
+    size_t u;
+    int iThreads;
+
+    if(argc > 3
+    || (argc > 1 && sscanf(argv[1], "%lu", &ulMaxThreads) != 1)
+    || (argc > 2 && sscanf(argv[2], "%lu", &ulTotalOps) != 1)
+    || ulMaxThreads < 1 || ulMaxThreads > MAX_THREADS) {
+        fprintf(stderr, "Usage: %s [maxthreads (1-%d)] [ops]\n",
+        argv[0], MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    pcKeys = (char *)malloc((size_t)KEY_COUNT * MAX_KEY_LENGTH);
+    if(pcKeys == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        return EXIT_FAILURE;
+    }
+    for(u = 0; u < KEY_COUNT; u++) {
+        sprintf(pcKeys + u * MAX_KEY_LENGTH, "%lu", (unsigned long)u);
+    }
+
+    printf("%10s %8s %14s %14s %16s\n", "get/put/rm", "threads",
+    "mutex Mops/s", "striped Mops/s", "lock-free Mops/s");
+    for(uMix = 0; uMix < sizeof(asMixes) / sizeof(asMixes[0]);
+    uMix++) {
+        for(iThreads = 1; iThreads <= (int)ulMaxThreads;
+        iThreads *= 2) {
+            for(uTarget = 0; uTarget < TARGET_COUNT; uTarget++) {
+                adMops[uTarget] = runMix(&asTargets[uTarget],
+                &asMixes[uMix], pcKeys, iThreads, (size_t)ulTotalOps);
+                if(adMops[uTarget] < 0) {
+                    fprintf(stderr, "cannot run %s with %d threads\n",
+                    asTargets[uTarget].pcName, iThreads);
+                    free(pcKeys);
+                    return EXIT_FAILURE;
+                }
+            }
+            printf("%10s %8d %14.2f %14.2f %16.2f\n",
+            asMixes[uMix].pcName, iThreads, adMops[0], adMops[1],
+            adMops[2]);
+            fflush(stdout);
+        }
+    }
+
+    free(pcKeys);
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtableflood.c                                               */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Measures the hash table under keys crafted to share one bucket, as
+an attacker who knows the hash function can choose them, against
+ordinary keys, with the compiled-in hash function and with a random
+seed (SymTable_seed). The keys are decimal numbers, like the ones
+testCollisions uses: for each table size, the crafted keys are the
+first numbers whose hash code falls in the same bucket of a table of
+that size. Crafting assumes the default build of symtablehash.c, which
+takes the code modulo the bucket count. */
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 24};
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Adds 1 to the count at pvExtra, for SymTable_mapSlice. */
+static void countBinding(const char *pcKey, void *pvValue,
+void *pvExtra) {
+    (void)pcKey;
+    (void)pvValue;
+    (*(size_t *)pvExtra)++;
+}
+
+/* Returns the number of bindings in the longest chain of oSymTable,
+counted slice by slice. */
+static size_t longestChain(SymTable_T oSymTable) {
+    size_t uSlices;
+    size_t uChain;
+    size_t uLongest = 0;
+    size_t u;
+
+    uSlices = SymTable_getSliceCount(oSymTable);
+    for(u = 0; u < uSlices; u++) {
+        uChain = 0;
+        SymTable_mapSlice(oSymTable, u, u + 1, countBinding, &uChain);
+        if(uChain > uLongest) {
+            uLongest = uChain;
+        }
+    }
+    return uLongest;
+}
+
+/* Puts the uCount keys in pcKeys into a new table, seeded at random if
+iSeeded, then times uCount gets of random keys among them. The gets
+also finish any resize the puts left under way. Writes the time per
+put and per get and the longest chain to stdout, as row pcName of
+uCount keys. Returns the number of buckets of the table, or 0 if
+insufficient memory is available. */
+static size_t benchTable(const char *pcKeys, size_t uCount,
+int iSeeded, const char *pcName) {
+    SymTable_T oSymTable;
+    size_t uState = 217;
+    size_t uFound = 0;
+    size_t uBuckets;
+    size_t u;
+    double dStart;
+    double dPut;
+    double dGet;
+
+    oSymTable = SymTable_new();
+    if(oSymTable == NULL || (iSeeded && !SymTable_seed(oSymTable,
+    NULL))) {
+        fprintf(stderr, "insufficient memory\n");
+        if(oSymTable != NULL) {
+            SymTable_free(oSymTable);
+        }
+        return 0;
+    }
+
+    dStart = cpuSeconds();
+    for(u = 0; u < uCount; u++) {
+        if(!SymTable_put(oSymTable, pcKeys + u * MAX_KEY_LENGTH,
+        oSymTable)) {
+            fprintf(stderr, "insufficient memory\n");
+            SymTable_free(oSymTable);
+            return 0;
+        }
+    }
+    dPut = cpuSeconds() - dStart;
+
+    dStart = cpuSeconds();
+    for(u = 0; u < uCount; u++) {
+        if(SymTable_get(oSymTable, pcKeys + (nextRandom(&uState)
+        % uCount) * MAX_KEY_LENGTH) != NULL) {
+            uFound++;
+        }
+    }
+    dGet = cpuSeconds() - dStart;
+    if(uFound != uCount) {
+        fprintf(stderr, "lookup failed\n");
+    }
+
+    uBuckets = SymTable_getSliceCount(oSymTable);
+    printf("%8lu %-10s %-8s %12.1f %12.1f %8lu\n",
+    (unsigned long)uCount, pcName, iSeeded ? "seeded" : "fixed",
+    dPut * 1e9 / (double)uCount, dGet * 1e9 / (double)uCount,
+    (unsigned long)longestChain(oSymTable));
+    fflush(stdout);
+
+    SymTable_free(oSymTable);
+    return uBuckets;
+}
+
+/* Writes to pcCrafted the first uCount decimal numbers whose hash
+codes, under the compiled-in function, fall in the same bucket of a
+table of uBuckets buckets as the code of "0". */
+static void craftKeys(char *pcCrafted, size_t uCount,
+size_t uBuckets, SymTable_T oSymTable) {
+    char acKey[MAX_KEY_LENGTH];
+    unsigned long ulNumber;
+    size_t uLength;
+    size_t uTarget;
+    size_t u = 0;
+
+    uTarget = SymTable_hashKey(oSymTable, "0", 1) % uBuckets;
+    for(ulNumber = 0; u < uCount; ulNumber++) {
+        uLength = (size_t)sprintf(acKey, "%lu", ulNumber);
+        if(SymTable_hashKey(oSymTable, acKey, uLength) % uBuckets
+        == uTarget) {
+            strcpy(pcCrafted + u * MAX_KEY_LENGTH, acKey);
+            u++;
+        }
+    }
+}
+
+/* Runs the benchmark for tables of 1000, 4000, ... up to argv[1]
+keys (default 16000). Crafting the keys takes about the number of keys
+times the number of buckets hashes. Writes the time per put and per
+get and the longest chain of each table to stdout. Returns 0 if
+successful and EXIT_FAILURE if not. */
+int main(int argc, char *argv[]) {
+    unsigned long ulMaxCount = 16000;
+    SymTable_T oSymTable;
+    char *pcOrdinary;
+    char *pcCrafted;
+    size_t uBuckets;
+    size_t uCount;
+    size_t u;
+    int iFailed = 0;
+
+    if(argc > 2) {
+        fprintf(stderr, "Usage: %s [maxcount]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc == 2 && sscanf(argv[1], "%lu", &ulMaxCount) != 1) {
+        fprintf(stderr, "maxcount must be numeric\n");
+        return EXIT_FAILURE;
+    }
+
+    pcOrdinary = (char *)malloc((size_t)ulMaxCount * MAX_KEY_LENGTH);
+    pcCrafted = (char *)malloc((size_t)ulMaxCount * MAX_KEY_LENGTH);
+    oSymTable = SymTable_new();
+    if(pcOrdinary == NULL || pcCrafted == NULL || oSymTable == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(pcOrdinary);
+        free(pcCrafted);
+        if(oSymTable != NULL) {
+            SymTable_free(oSymTable);
+        }
+        return EXIT_FAILURE;
+    }
+    for(u = 0; u < ulMaxCount; u++) {
+        sprintf(pcOrdinary + u * MAX_KEY_LENGTH, "%lu",
+        (unsigned long)u);
+    }
+
+    printf("%8s %-10s %-8s %12s %12s %8s\n", "keys", "keys are",
+    "hash", "put ns/op", "get ns/op", "longest");
+    for(uCount = 1000; uCount <= ulMaxCount && !iFailed; uCount *= 4) {
+        /* the ordinary keys show how many buckets a table of uCount
+        keys ends with, which the crafted keys then aim at */
+        uBuckets = benchTable(pcOrdinary, uCount, 0, "ordinary");
+        iFailed = uBuckets == 0
+        || benchTable(pcOrdinary, uCount, 1, "ordinary") == 0;
+        if(!iFailed) {
+            craftKeys(pcCrafted, uCount, uBuckets, oSymTable);
+            iFailed = benchTable(pcCrafted, uCount, 0, "crafted") == 0
+            || benchTable(pcCrafted, uCount, 1, "crafted") == 0;
+        }
+    }
+
+    SymTable_free(oSymTable);
+    free(pcOrdinary);
+    free(pcCrafted);
+    return iFailed ? EXIT_FAILURE : 0;
+}
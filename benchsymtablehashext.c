@@ -0,0 +1,242 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablehashext.c                                             */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* number of timed lookups per table size */
+enum {LOOKUP_COUNT = 1000000};
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 24};
+
+/* number of keys resolved by each SymTable_getMany call */
+enum {BATCH_SIZE = 128};
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Puts the bindings "0" through "uCount - 1" into oSymTable. Returns 1
+(TRUE) if successful and 0 (FALSE) if there is insufficient
+memory. */
+static int fillTable(SymTable_T oSymTable, size_t uCount) {
+    char acKey[MAX_KEY_LENGTH];
+    size_t u;
+
+    for(u = 0; u < uCount; u++) {
+        sprintf(acKey, "%lu", (unsigned long)u);
+        if(!SymTable_put(oSymTable, acKey, oSymTable)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Times LOOKUP_COUNT successful lookups of random keys, first as a
+loop of SymTable_get calls and then as SymTable_getMany calls of
+BATCH_SIZE keys each, in a table of uCount bindings, for uCount =
+10^3, 10^4, ... up to uMaxCount. Keys are generated before the clock
+starts, so only the lookups are timed. Returns 0 if successful and 1
+if not. */
+static int benchGetMany(size_t uMaxCount) {
+    SymTable_T oSymTable;
+    char *pcKeys;
+    const char **ppcKeys;
+    void *apvValues[BATCH_SIZE];
+    size_t uCount;
+    size_t uState = 217;
+    size_t u;
+    size_t uFound;
+    size_t uBatchFound;
+    double dStart;
+    double dGet;
+    double dGetMany;
+
+    pcKeys = (char *)malloc((size_t)LOOKUP_COUNT * MAX_KEY_LENGTH);
+    ppcKeys = (const char **)malloc(LOOKUP_COUNT * sizeof(char *));
+    if(pcKeys == NULL || ppcKeys == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(pcKeys);
+        free(ppcKeys);
+        return 1;
+    }
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        ppcKeys[u] = pcKeys + u * MAX_KEY_LENGTH;
+    }
+
+    printf("%12s %14s %14s %10s\n", "bindings", "get ns/op",
+    "getMany ns/op", "speedup");
+    for(uCount = 1000; uCount <= uMaxCount; uCount *= 10) {
+        oSymTable = SymTable_new();
+        if(oSymTable == NULL || !fillTable(oSymTable, uCount)) {
+            fprintf(stderr, "insufficient memory at %lu bindings\n",
+            (unsigned long)uCount);
+            if(oSymTable != NULL) {
+                SymTable_free(oSymTable);
+            }
+            free(pcKeys);
+            free(ppcKeys);
+            return 1;
+        }
+
+        for(u = 0; u < LOOKUP_COUNT; u++) {
+            sprintf(pcKeys + u * MAX_KEY_LENGTH, "%lu",
+            (unsigned long)(nextRandom(&uState) % uCount));
+        }
+
+        uFound = 0;
+        dStart = cpuSeconds();
+        for(u = 0; u < LOOKUP_COUNT; u++) {
+            if(SymTable_get(oSymTable, ppcKeys[u]) != NULL) {
+                uFound++;
+            }
+        }
+        dGet = cpuSeconds() - dStart;
+
+        uBatchFound = 0;
+        dStart = cpuSeconds();
+        for(u = 0; u < LOOKUP_COUNT; u += BATCH_SIZE) {
+            uBatchFound += SymTable_getMany(oSymTable, ppcKeys + u,
+            LOOKUP_COUNT - u < BATCH_SIZE ? LOOKUP_COUNT - u
+            : BATCH_SIZE, apvValues);
+        }
+        dGetMany = cpuSeconds() - dStart;
+
+        if(uFound != LOOKUP_COUNT || uBatchFound != LOOKUP_COUNT) {
+            fprintf(stderr, "lookup failed at %lu bindings\n",
+            (unsigned long)uCount);
+        }
+        printf("%12lu %14.1f %14.1f %9.2fx\n", (unsigned long)uCount,
+        dGet * 1e9 / LOOKUP_COUNT, dGetMany * 1e9 / LOOKUP_COUNT,
+        dGetMany > 0 ? dGet / dGetMany : 0.0);
+        fflush(stdout);
+
+        SymTable_free(oSymTable);
+    }
+
+    free(pcKeys);
+    free(ppcKeys);
+    return 0;
+}
+
+/* Times loading uCount bindings "0" through "uCount - 1" into a new
+table in three ways: a loop of SymTable_put calls on a table from
+SymTable_new, the same loop on a table from SymTable_newWithCapacity,
+and a single SymTable_putBulk call with unique keys. Keys are
+generated before the clock starts. Returns 0 if successful and 1 if
+not. */
+static int benchBulk(size_t uCount) {
+    SymTable_T oSymTable;
+    char *pcKeys;
+    const char **ppcKeys;
+    double adSeconds[3];
+    double dStart;
+    size_t u;
+    int iWay;
+    int iSuccessful;
+
+    if(uCount == 0) {
+        fprintf(stderr, "count must be positive\n");
+        return 1;
+    }
+    pcKeys = (char *)malloc(uCount * MAX_KEY_LENGTH);
+    ppcKeys = (const char **)malloc(uCount * sizeof(char *));
+    if(pcKeys == NULL || ppcKeys == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(pcKeys);
+        free(ppcKeys);
+        return 1;
+    }
+    for(u = 0; u < uCount; u++) {
+        ppcKeys[u] = pcKeys + u * MAX_KEY_LENGTH;
+        sprintf(pcKeys + u * MAX_KEY_LENGTH, "%lu", (unsigned long)u);
+    }
+
+    for(iWay = 0; iWay < 3; iWay++) {
+        dStart = cpuSeconds();
+        oSymTable = iWay == 0 ? SymTable_new()
+        : SymTable_newWithCapacity(uCount);
+        iSuccessful = oSymTable != NULL;
+        if(iWay < 2) {
+            for(u = 0; iSuccessful && u < uCount; u++) {
+                iSuccessful = SymTable_put(oSymTable, ppcKeys[u],
+                ppcKeys[u]);
+            }
+        }
+        else if(iSuccessful) {
+            /* the keys double as values */
+            iSuccessful = SymTable_putBulk(oSymTable, ppcKeys,
+            (const void *const *)ppcKeys, uCount, 1);
+        }
+        adSeconds[iWay] = cpuSeconds() - dStart;
+
+        if(oSymTable != NULL) {
+            SymTable_free(oSymTable);
+        }
+        if(!iSuccessful) {
+            fprintf(stderr, "insufficient memory\n");
+            free(pcKeys);
+            free(ppcKeys);
+            return 1;
+        }
+    }
+
+    printf("%12s %14s %14s %14s\n", "bindings", "put ns/op",
+    "presized ns/op", "putBulk ns/op");
+    printf("%12lu %14.1f %14.1f %14.1f\n", (unsigned long)uCount,
+    adSeconds[0] * 1e9 / (double)uCount,
+    adSeconds[1] * 1e9 / (double)uCount,
+    adSeconds[2] * 1e9 / (double)uCount);
+
+    free(pcKeys);
+    free(ppcKeys);
+    return 0;
+}
+
+/* Runs the benchmark named by argv[1]. argv[2], if present, is the
+table size to measure. Writes the results to stdout. Returns
+0 if successful and EXIT_FAILURE if not.
+
+   getmany [maxcount]  get and getMany cost from 10^3 bindings up to
+                       maxcount (default 10^7) bindings
+   bulk [count]        cost per binding of loading count (default
+                       10^7) bindings with put, into a presized
+                       table, and with putBulk */
+int main(int argc, char *argv[]) {
+    unsigned long ulCount = 10000000;
+
+    if(argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s getmany|bulk [count]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc == 3 && sscanf(argv[2], "%lu", &ulCount) != 1) {
+        fprintf(stderr, "count must be numeric\n");
+        return EXIT_FAILURE;
+    }
+
+    if(!strcmp(argv[1], "getmany")) {
+        return benchGetMany((size_t)ulCount) ? EXIT_FAILURE : 0;
+    }
+
+    if(!strcmp(argv[1], "bulk")) {
+        return benchBulk((size_t)ulCount) ? EXIT_FAILURE : 0;
+    }
+
+    fprintf(stderr, "unknown benchmark: %s\n", argv[1]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,227 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablehashfn.c                                              */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Measures the hash function the hash implementation was compiled
+with (see SYMTABLE_HASH in symtablehash.c): how fast it hashes keys of
+several shapes, and how evenly its codes spread those keys over the
+buckets. Linking the program with each build of symtablehash.c
+compares the functions on the same keys. */
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 64};
+
+/* number of timed hashes, and of timed lookups, per corpus */
+enum {HASH_COUNT = 10000000};
+enum {LOOKUP_COUNT = 1000000};
+
+/* longest chain the histogram counts on its own; longer chains are
+counted together */
+enum {MAX_CHAIN = 5};
+
+/* the shapes of keys: decimal numbers, flat C identifiers, and file
+paths */
+enum {CORPUS_COUNT = 3};
+static const char *const apcCorpusNames[] = {"decimal", "identifier",
+    "path"};
+
+/* the words that identifiers and paths are made of */
+static const char *const apcWords[] = {"buffer", "parse", "token",
+    "scope", "alloc", "stream", "node", "table", "type", "expr"};
+
+/* Returns the number of elements of array a. */
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns a random word of apcWords. */
+static const char *pickWord(size_t *puState) {
+    return apcWords[nextRandom(puState) % COUNT(apcWords)];
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Writes to pcKey key number uNumber of corpus iCorpus. The number
+is part of every key, so distinct numbers make distinct keys. */
+static void makeKey(char *pcKey, int iCorpus, size_t uNumber,
+size_t *puState) {
+    switch(iCorpus) {
+        case 0:
+            sprintf(pcKey, "%lu", (unsigned long)uNumber);
+            break;
+        case 1:
+            sprintf(pcKey, "%s_%s_%lu", pickWord(puState),
+            pickWord(puState), (unsigned long)uNumber);
+            break;
+        default:
+            sprintf(pcKey, "src/%s/%s/%s_%lu.c", pickWord(puState),
+            pickWord(puState), pickWord(puState),
+            (unsigned long)uNumber);
+            break;
+    }
+}
+
+/* Adds 1 to the count at pvExtra, for SymTable_mapSlice. */
+static void countBinding(const char *pcKey, void *pvValue,
+void *pvExtra) {
+    (void)pcKey;
+    (void)pvValue;
+    (*(size_t *)pvExtra)++;
+}
+
+/* Measures corpus iCorpus of uCount keys, made in pcKeys: the time of
+HASH_COUNT calls of SymTable_hashKey over the keys, of uCount puts,
+and of LOOKUP_COUNT successful gets, then the lengths of the chains
+of the table, slice by slice. The chains are counted after the gets,
+which finish any resize the puts left under way. Returns 0 if
+successful and 1 if not. */
+static int benchCorpus(int iCorpus, size_t uCount, char *pcKeys) {
+    SymTable_T oSymTable;
+    size_t auHistogram[MAX_CHAIN + 1];
+    size_t *puLengths;
+    size_t uState = 217;
+    size_t uBytes = 0;
+    size_t uFound = 0;
+    size_t uSink = 0;
+    size_t uSlices;
+    size_t uChain;
+    size_t uMaxChain = 0;
+    size_t u;
+    double dStart;
+    double dHash;
+    double dPut;
+    double dGet;
+
+    puLengths = (size_t *)malloc(uCount * sizeof(size_t));
+    oSymTable = SymTable_new();
+    if(puLengths == NULL || oSymTable == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(puLengths);
+        if(oSymTable != NULL) {
+            SymTable_free(oSymTable);
+        }
+        return 1;
+    }
+    for(u = 0; u < uCount; u++) {
+        makeKey(pcKeys + u * MAX_KEY_LENGTH, iCorpus, u, &uState);
+        puLengths[u] = strlen(pcKeys + u * MAX_KEY_LENGTH);
+    }
+
+    dStart = cpuSeconds();
+    for(u = 0; u < HASH_COUNT; u++) {
+        uSink += SymTable_hashKey(oSymTable,
+        pcKeys + (u % uCount) * MAX_KEY_LENGTH, puLengths[u % uCount]);
+        uBytes += puLengths[u % uCount];
+    }
+    dHash = cpuSeconds() - dStart;
+
+    dStart = cpuSeconds();
+    for(u = 0; u < uCount; u++) {
+        if(!SymTable_put(oSymTable, pcKeys + u * MAX_KEY_LENGTH,
+        pcKeys)) {
+            fprintf(stderr, "insufficient memory\n");
+            SymTable_free(oSymTable);
+            free(puLengths);
+            return 1;
+        }
+    }
+    dPut = cpuSeconds() - dStart;
+
+    dStart = cpuSeconds();
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        if(SymTable_get(oSymTable, pcKeys + (nextRandom(&uState)
+        % uCount) * MAX_KEY_LENGTH) != NULL) {
+            uFound++;
+        }
+    }
+    dGet = cpuSeconds() - dStart;
+    if(uFound != LOOKUP_COUNT) {
+        fprintf(stderr, "lookup failed\n");
+    }
+
+    memset(auHistogram, 0, sizeof(auHistogram));
+    uSlices = SymTable_getSliceCount(oSymTable);
+    for(u = 0; u < uSlices; u++) {
+        uChain = 0;
+        SymTable_mapSlice(oSymTable, u, u + 1, countBinding, &uChain);
+        auHistogram[uChain < MAX_CHAIN ? uChain : MAX_CHAIN]++;
+        if(uChain > uMaxChain) {
+            uMaxChain = uChain;
+        }
+    }
+
+    printf("%-10s %10.2f %10.1f %10.1f %10.1f", apcCorpusNames[iCorpus],
+    dHash * 1e9 / HASH_COUNT, (double)uBytes / dHash / 1e6,
+    dPut * 1e9 / (double)uCount, dGet * 1e9 / LOOKUP_COUNT);
+    printf(" %9lu", (unsigned long)uSlices);
+    for(u = 0; u <= MAX_CHAIN; u++) {
+        printf(" %6.1f", 100.0 * (double)auHistogram[u]
+        / (double)uSlices);
+    }
+    printf(" %5lu\n", (unsigned long)uMaxChain);
+    fflush(stdout);
+
+    /* keeps the compiler from dropping the hashes */
+    if(uSink == 1) {
+        printf(" \n");
+    }
+    SymTable_free(oSymTable);
+    free(puLengths);
+    return 0;
+}
+
+/* Runs the benchmark on every corpus, with argv[1] keys (default
+10^6) each. Writes to stdout the time per hash, the bytes hashed per
+second, the time per put and per get, and the number of buckets with
+the percentage of them whose chain has 0, 1, ... MAX_CHAIN or more
+keys, and the longest chain. Returns 0 if successful and EXIT_FAILURE
+if not. */
+int main(int argc, char *argv[]) {
+    unsigned long ulCount = 1000000;
+    char *pcKeys;
+    int iCorpus;
+    int iFailed = 0;
+
+    if(argc > 2) {
+        fprintf(stderr, "Usage: %s [count]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc == 2 && (sscanf(argv[1], "%lu", &ulCount) != 1
+    || ulCount == 0)) {
+        fprintf(stderr, "count must be a positive number\n");
+        return EXIT_FAILURE;
+    }
+
+    pcKeys = (char *)malloc((size_t)ulCount * MAX_KEY_LENGTH);
+    if(pcKeys == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-10s %10s %10s %10s %10s", "corpus", "hash ns",
+    "hash MB/s", "put ns/op", "get ns/op");
+    printf(" %9s %6s %6s %6s %6s %6s %6s %5s\n", "buckets", "0", "1",
+    "2", "3", "4", "5+", "max");
+    for(iCorpus = 0; iCorpus < CORPUS_COUNT && !iFailed; iCorpus++) {
+        iFailed = benchCorpus(iCorpus, (size_t)ulCount, pcKeys);
+    }
+
+    free(pcKeys);
+    return iFailed ? EXIT_FAILURE : 0;
+}
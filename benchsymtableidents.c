@@ -0,0 +1,225 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtableidents.c                                              */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef S_SPLINT_S
+#include <sys/resource.h>
+#endif
+
+/* Measures a table of identifiers like those a compiler or linker
+keeps: qualified C++ names, which share long namespace and class
+prefixes, or flat C names, which share shorter module prefixes. The
+keys are made from a fixed vocabulary by a fixed pseudo-random
+sequence, so every implementation sees the same corpus. */
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 80};
+
+/* number of timed lookups of each kind */
+enum {LOOKUP_COUNT = 1000000};
+
+/* the words that names are made of */
+static const char *const apcNamespaces[] = {"std", "boost", "llvm",
+    "clang", "absl", "folly", "grpc", "proto"};
+static const char *const apcInner[] = {"detail", "impl", "internal",
+    "chrono", "filesystem", "ranges", "io", "sema"};
+static const char *const apcWords[] = {"Basic", "String", "Vector",
+    "Map", "Node", "Buffer", "Parser", "Token", "Stream", "Alloc",
+    "Hash", "Table", "Type", "Decl", "Expr", "Scope"};
+static const char *const apcMembers[] = {"get", "set", "size", "begin",
+    "end", "insert", "erase", "find", "reset", "swap", "data", "value"};
+
+/* Returns the number of elements of array a. */
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns a random element of the array of uCount words
+ppcWords. */
+static const char *pickWord(const char *const *ppcWords, size_t uCount,
+size_t *puState) {
+    return ppcWords[nextRandom(puState) % uCount];
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Returns the peak resident set size of the process so far, in
+kilobytes, or 0 where it cannot be measured. */
+static long peakKilobytes(void) {
+#ifndef S_SPLINT_S
+    struct rusage sUsage;
+    if(getrusage(RUSAGE_SELF, &sUsage) == 0) {
+        return (long)sUsage.ru_maxrss;
+    }
+#endif
+    return 0;
+}
+
+/* Writes to pcKey identifier number uNumber, a qualified C++ name if
+iQualified and a flat C name if not. The number ends the name, so
+distinct numbers make distinct names. */
+static void makeIdentifier(char *pcKey, int iQualified, size_t uNumber,
+size_t *puState) {
+    if(iQualified) {
+        sprintf(pcKey, "%s::%s::%s%s::%s_%lu",
+        pickWord(apcNamespaces, COUNT(apcNamespaces), puState),
+        pickWord(apcInner, COUNT(apcInner), puState),
+        pickWord(apcWords, COUNT(apcWords), puState),
+        pickWord(apcWords, COUNT(apcWords), puState),
+        pickWord(apcMembers, COUNT(apcMembers), puState),
+        (unsigned long)uNumber);
+    }
+    else {
+        sprintf(pcKey, "%s_%s_%lu",
+        pickWord(apcInner, COUNT(apcInner), puState),
+        pickWord(apcMembers, COUNT(apcMembers), puState),
+        (unsigned long)uNumber);
+    }
+}
+
+/* Times putting uCount identifiers into a new table, LOOKUP_COUNT
+successful and LOOKUP_COUNT unsuccessful SymTable_get calls, and
+measures the memory the table takes per binding. The keys are made
+before the first measurement, so the growth of the peak resident set
+size is the table's. Returns 0 if successful and 1 if not. */
+static int benchIdentifiers(int iQualified, size_t uCount) {
+    SymTable_T oSymTable;
+    char *pcKeys;
+    char *pcMisses;
+    size_t uState = 217;
+    size_t uFound = 0;
+    size_t uTotal = 0;
+    size_t u;
+    long lBefore;
+    long lAfter;
+    double dStart;
+    double dPut;
+    double dHit;
+    double dMiss;
+
+    if(uCount == 0) {
+        fprintf(stderr, "count must be positive\n");
+        return 1;
+    }
+    pcKeys = (char *)malloc(uCount * MAX_KEY_LENGTH);
+    pcMisses = (char *)malloc((size_t)LOOKUP_COUNT * MAX_KEY_LENGTH);
+    if(pcKeys == NULL || pcMisses == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(pcKeys);
+        free(pcMisses);
+        return 1;
+    }
+    for(u = 0; u < uCount; u++) {
+        makeIdentifier(pcKeys + u * MAX_KEY_LENGTH, iQualified, u,
+        &uState);
+        uTotal += strlen(pcKeys + u * MAX_KEY_LENGTH);
+    }
+
+    /* misses share the shape and prefixes of the keys */
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        makeIdentifier(pcMisses + u * MAX_KEY_LENGTH, iQualified,
+        uCount + u, &uState);
+    }
+
+    lBefore = peakKilobytes();
+    dStart = cpuSeconds();
+    oSymTable = SymTable_new();
+    if(oSymTable == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(pcKeys);
+        free(pcMisses);
+        return 1;
+    }
+    for(u = 0; u < uCount; u++) {
+        if(!SymTable_put(oSymTable, pcKeys + u * MAX_KEY_LENGTH,
+        oSymTable)) {
+            fprintf(stderr, "insufficient memory\n");
+            SymTable_free(oSymTable);
+            free(pcKeys);
+            free(pcMisses);
+            return 1;
+        }
+    }
+    dPut = cpuSeconds() - dStart;
+    lAfter = peakKilobytes();
+
+    dStart = cpuSeconds();
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        if(SymTable_get(oSymTable,
+        pcKeys + nextRandom(&uState) % uCount * MAX_KEY_LENGTH)
+        != NULL) {
+            uFound++;
+        }
+    }
+    dHit = cpuSeconds() - dStart;
+
+    dStart = cpuSeconds();
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        if(SymTable_get(oSymTable, pcMisses + u * MAX_KEY_LENGTH)
+        != NULL) {
+            uFound++;
+        }
+    }
+    dMiss = cpuSeconds() - dStart;
+    if(uFound != LOOKUP_COUNT) {
+        fprintf(stderr, "lookup failed\n");
+    }
+
+    printf("%12s %10s %14s %14s %14s %14s\n", "bindings", "key bytes",
+    "bytes/binding", "put ns/op", "hit ns/op", "miss ns/op");
+    printf("%12lu %10.1f %14.1f %14.1f %14.1f %14.1f\n",
+    (unsigned long)uCount, (double)uTotal / (double)uCount,
+    (double)(lAfter - lBefore) * 1024.0 / (double)uCount,
+    dPut * 1e9 / (double)uCount, dHit * 1e9 / LOOKUP_COUNT,
+    dMiss * 1e9 / LOOKUP_COUNT);
+
+    SymTable_free(oSymTable);
+    free(pcKeys);
+    free(pcMisses);
+    return 0;
+}
+
+/* Runs the benchmark for the corpus named by argv[1], "qualified" or
+"flat". argv[2], if present, is the number of identifiers (default
+10^6). Writes the results to stdout. Returns 0 if successful and
+EXIT_FAILURE if not. Each run measures one table, since the peak
+resident set size only grows. */
+int main(int argc, char *argv[]) {
+    unsigned long ulCount = 1000000;
+
+    if(argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s qualified|flat [count]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc == 3 && sscanf(argv[2], "%lu", &ulCount) != 1) {
+        fprintf(stderr, "count must be numeric\n");
+        return EXIT_FAILURE;
+    }
+
+    if(!strcmp(argv[1], "qualified")) {
+        return benchIdentifiers(1, (size_t)ulCount) ? EXIT_FAILURE : 0;
+    }
+
+    if(!strcmp(argv[1], "flat")) {
+        return benchIdentifiers(0, (size_t)ulCount) ? EXIT_FAILURE : 0;
+    }
+
+    fprintf(stderr, "unknown corpus: %s\n", argv[1]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,245 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtableordered.c                                             */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef SYMTABLE_BTREE
+#include "symtablebtree.h"
+#endif
+
+/* Measures point lookups and sorted prefix scans. Built with
+-DSYMTABLE_BTREE and linked with symtablebtree.o, a scan is one
+SymTable_mapPrefix call. Linked with any other implementation, a scan
+is what a caller of symtable.h has to do: SymTable_map over the whole
+table to collect the matching keys, then qsort them. */
+
+/* number of timed lookups per table size */
+enum {LOOKUP_COUNT = 1000000};
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 24};
+
+/* number of keys a table is scanned for in all, which sets the number
+of scans per table size */
+enum {SCANNED_KEYS = 10000000};
+
+/* A Matches is the result of a scan: the keys found, in order once
+the scan is over. */
+struct Matches
+{
+    /* prefix the keys start with */
+    const char *pcPrefix;
+
+    /* length of pcPrefix */
+    size_t uPrefixLength;
+
+    /* the keys */
+    const char **ppcKeys;
+
+    /* number of keys */
+    size_t uCount;
+
+    /* number of keys ppcKeys has room for */
+    size_t uCapacity;
+};
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Puts the bindings "0" through "uCount - 1" into oSymTable. Returns 1
+(TRUE) if successful and 0 (FALSE) if there is insufficient
+memory. */
+static int fillTable(SymTable_T oSymTable, size_t uCount) {
+    char acKey[MAX_KEY_LENGTH];
+    size_t u;
+
+    for(u = 0; u < uCount; u++) {
+        sprintf(acKey, "%lu", (unsigned long)u);
+        if(!SymTable_put(oSymTable, acKey, oSymTable)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Adds pcKey to the Matches pvExtra if it starts with the prefix of
+the Matches. Exits if there is insufficient memory. pvValue is
+unused. */
+static void addMatch(const char *pcKey, void *pvValue, void *pvExtra) {
+    struct Matches *psMatches = (struct Matches *)pvExtra;
+    const char **ppcKeys;
+
+    (void)pvValue;
+    if(strncmp(pcKey, psMatches->pcPrefix, psMatches->uPrefixLength)
+    != 0) {
+        return;
+    }
+    if(psMatches->uCount == psMatches->uCapacity) {
+        ppcKeys = (const char **)realloc(psMatches->ppcKeys,
+        2 * psMatches->uCapacity * sizeof(const char *));
+        if(ppcKeys == NULL) {
+            fprintf(stderr, "insufficient memory\n");
+            exit(EXIT_FAILURE);
+        }
+        psMatches->ppcKeys = ppcKeys;
+        psMatches->uCapacity *= 2;
+    }
+    psMatches->ppcKeys[psMatches->uCount] = pcKey;
+    (psMatches->uCount)++;
+}
+
+#ifndef SYMTABLE_BTREE
+/* Compares the keys at pvFirst and pvSecond for qsort. */
+static int compareKeys(const void *pvFirst, const void *pvSecond) {
+    return strcmp(*(const char *const *)pvFirst,
+    *(const char *const *)pvSecond);
+}
+#endif
+
+/* Stores in *psMatches the keys of oSymTable that start with pcPrefix,
+in ascending order. */
+static void scanPrefix(SymTable_T oSymTable, const char *pcPrefix,
+struct Matches *psMatches) {
+    psMatches->pcPrefix = pcPrefix;
+    psMatches->uPrefixLength = strlen(pcPrefix);
+    psMatches->uCount = 0;
+#ifdef SYMTABLE_BTREE
+    SymTable_mapPrefix(oSymTable, pcPrefix, addMatch, psMatches);
+#else
+    SymTable_map(oSymTable, addMatch, psMatches);
+    qsort(psMatches->ppcKeys, psMatches->uCount, sizeof(const char *),
+    compareKeys);
+#endif
+}
+
+/* Times LOOKUP_COUNT successful SymTable_get calls for random keys,
+and sorted scans for the keys with a random prefix, in a table of
+uCount bindings, for uCount = 10^3, 10^4, ... up to uMaxCount. A
+prefix is a random key without its last two digits, so a scan finds
+a hundred keys or more. Returns 0 if successful and 1 if not. */
+static int benchOrdered(size_t uMaxCount) {
+    SymTable_T oSymTable;
+    struct Matches sMatches;
+    char *pcKeys;
+    char *pcPrefix;
+    size_t uCount;
+    size_t uScans;
+    size_t uFound;
+    size_t uScanned;
+    size_t uState = 217;
+    size_t uLength;
+    size_t u;
+    double dStart;
+    double dGet;
+    double dScan;
+
+    pcKeys = (char *)malloc((size_t)LOOKUP_COUNT * MAX_KEY_LENGTH);
+    sMatches.uCapacity = 256;
+    sMatches.ppcKeys =
+    (const char **)malloc(sMatches.uCapacity * sizeof(const char *));
+    if(pcKeys == NULL || sMatches.ppcKeys == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(pcKeys);
+        free(sMatches.ppcKeys);
+        return 1;
+    }
+
+    printf("%12s %14s %14s %14s\n", "bindings", "get ns/op",
+    "scan us/op", "keys/scan");
+    for(uCount = 1000; uCount <= uMaxCount; uCount *= 10) {
+        oSymTable = SymTable_new();
+        if(oSymTable == NULL || !fillTable(oSymTable, uCount)) {
+            fprintf(stderr, "insufficient memory at %lu bindings\n",
+            (unsigned long)uCount);
+            if(oSymTable != NULL) {
+                SymTable_free(oSymTable);
+            }
+            free(pcKeys);
+            free(sMatches.ppcKeys);
+            return 1;
+        }
+
+        for(u = 0; u < LOOKUP_COUNT; u++) {
+            sprintf(pcKeys + u * MAX_KEY_LENGTH, "%lu",
+            (unsigned long)(nextRandom(&uState) % uCount));
+        }
+        uFound = 0;
+        dStart = cpuSeconds();
+        for(u = 0; u < LOOKUP_COUNT; u++) {
+            if(SymTable_get(oSymTable, pcKeys + u * MAX_KEY_LENGTH)
+            != NULL) {
+                uFound++;
+            }
+        }
+        dGet = cpuSeconds() - dStart;
+        if(uFound != LOOKUP_COUNT) {
+            fprintf(stderr, "lookup failed at %lu bindings\n",
+            (unsigned long)uCount);
+        }
+
+        /* the same number of keys examined at every size, so that a
+        full pass per scan stays affordable on large tables. The
+        prefixes reuse the key buffer. */
+        uScans = SCANNED_KEYS / uCount;
+        for(u = 0; u < uScans; u++) {
+            pcPrefix = pcKeys + u * MAX_KEY_LENGTH;
+            sprintf(pcPrefix, "%lu",
+            (unsigned long)(nextRandom(&uState) % uCount));
+            uLength = strlen(pcPrefix);
+            pcPrefix[uLength > 3 ? uLength - 2 : 1] = '\0';
+        }
+        uScanned = 0;
+        dStart = cpuSeconds();
+        for(u = 0; u < uScans; u++) {
+            scanPrefix(oSymTable, pcKeys + u * MAX_KEY_LENGTH,
+            &sMatches);
+            uScanned += sMatches.uCount;
+        }
+        dScan = cpuSeconds() - dStart;
+
+        printf("%12lu %14.1f %14.2f %14.1f\n", (unsigned long)uCount,
+        dGet * 1e9 / LOOKUP_COUNT, dScan * 1e6 / (double)uScans,
+        (double)uScanned / (double)uScans);
+        fflush(stdout);
+
+        SymTable_free(oSymTable);
+    }
+
+    free(pcKeys);
+    free(sMatches.ppcKeys);
+    return 0;
+}
+
+/* Runs the benchmark. argv[1], if present, is the largest table size
+to measure (default 10^6). Writes the results to stdout. Returns 0 if
+successful and EXIT_FAILURE if not. */
+int main(int argc, char *argv[]) {
+    unsigned long ulCount = 1000000;
+
+    if(argc > 2) {
+        fprintf(stderr, "Usage: %s [maxcount]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc == 2 && sscanf(argv[1], "%lu", &ulCount) != 1) {
+        fprintf(stderr, "maxcount must be numeric\n");
+        return EXIT_FAILURE;
+    }
+
+    return benchOrdered((size_t)ulCount) ? EXIT_FAILURE : 0;
+}
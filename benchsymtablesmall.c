@@ -0,0 +1,183 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablesmall.c                                               */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef S_SPLINT_S
+#include <sys/resource.h>
+#endif
+
+/* Measures many small tables, as a compiler keeps one per scope: the
+memory each takes, the time to build them, and the cost of lookups
+spread over all of them. */
+
+/* number of timed lookups */
+enum {LOOKUP_COUNT = 1000000};
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 24};
+
+/* most bindings per table */
+enum {MAX_BINDINGS = 64};
+
+/* names the keys of each table are drawn from, in order */
+static const char *const apcNames[] = {"i", "j", "n", "tmp", "result",
+    "count", "buffer", "length", "self", "other", "index", "value"};
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Returns the peak resident set size of the process so far, in
+kilobytes, or 0 where it cannot be measured. */
+static long peakKilobytes(void) {
+#ifndef S_SPLINT_S
+    struct rusage sUsage;
+    if(getrusage(RUSAGE_SELF, &sUsage) == 0) {
+        return (long)sUsage.ru_maxrss;
+    }
+#endif
+    return 0;
+}
+
+/* Builds uTables tables of uBindings bindings each, then times
+LOOKUP_COUNT successful SymTable_get calls on random tables. The keys
+and the array of tables are made before the first measurement, so
+the growth of the peak resident set size is the tables'. Returns 0 if
+successful and 1 if not. */
+static int benchSmall(size_t uTables, size_t uBindings) {
+    SymTable_T *poTables;
+    char acKeys[MAX_BINDINGS][MAX_KEY_LENGTH];
+    size_t uState = 217;
+    size_t uFound = 0;
+    size_t uNames = sizeof(apcNames) / sizeof(apcNames[0]);
+    size_t u;
+    size_t v;
+    long lBefore;
+    long lAfter;
+    double dStart;
+    double dBuild;
+    double dGet;
+    double dFree;
+
+    if(uTables == 0 || uBindings == 0 || uBindings > MAX_BINDINGS) {
+        fprintf(stderr, "tables must be positive and bindings from 1 "
+        "to %d\n", MAX_BINDINGS);
+        return 1;
+    }
+    poTables = (SymTable_T *)malloc(uTables * sizeof(SymTable_T));
+    if(poTables == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        return 1;
+    }
+    for(v = 0; v < uBindings; v++) {
+        if(v < uNames) {
+            strcpy(acKeys[v], apcNames[v]);
+        }
+        else {
+            sprintf(acKeys[v], "%s%lu", apcNames[v % uNames],
+            (unsigned long)(v / uNames));
+        }
+    }
+
+    lBefore = peakKilobytes();
+    dStart = cpuSeconds();
+    for(u = 0; u < uTables; u++) {
+        poTables[u] = SymTable_new();
+        if(poTables[u] == NULL) {
+            fprintf(stderr, "insufficient memory at table %lu\n",
+            (unsigned long)u);
+            while(u > 0) {
+                u--;
+                SymTable_free(poTables[u]);
+            }
+            free(poTables);
+            return 1;
+        }
+        for(v = 0; v < uBindings; v++) {
+            if(!SymTable_put(poTables[u], acKeys[v], poTables)) {
+                fprintf(stderr, "insufficient memory at table %lu\n",
+                (unsigned long)u);
+                for(v = 0; v <= u; v++) {
+                    SymTable_free(poTables[v]);
+                }
+                free(poTables);
+                return 1;
+            }
+        }
+    }
+    dBuild = cpuSeconds() - dStart;
+    lAfter = peakKilobytes();
+
+    dStart = cpuSeconds();
+    for(u = 0; u < LOOKUP_COUNT; u++) {
+        v = nextRandom(&uState);
+        if(SymTable_get(poTables[v % uTables], acKeys[(v >> 20)
+        % uBindings]) != NULL) {
+            uFound++;
+        }
+    }
+    dGet = cpuSeconds() - dStart;
+    if(uFound != LOOKUP_COUNT) {
+        fprintf(stderr, "lookup failed\n");
+    }
+
+    dStart = cpuSeconds();
+    for(u = 0; u < uTables; u++) {
+        SymTable_free(poTables[u]);
+    }
+    dFree = cpuSeconds() - dStart;
+
+    printf("%10s %10s %12s %12s %12s %12s\n", "tables", "bindings",
+    "bytes/table", "build ns", "get ns/op", "free ns");
+    printf("%10lu %10lu %12.1f %12.1f %12.1f %12.1f\n",
+    (unsigned long)uTables, (unsigned long)uBindings,
+    (double)(lAfter - lBefore) * 1024.0 / (double)uTables,
+    dBuild * 1e9 / (double)uTables, dGet * 1e9 / LOOKUP_COUNT,
+    dFree * 1e9 / (double)uTables);
+
+    free(poTables);
+    return 0;
+}
+
+/* Runs the benchmark. argv[1], if present, is the number of tables
+(default 10^6) and argv[2] the number of bindings in each (default
+4). The build and free times are per table. Writes the results to
+stdout. Returns 0 if successful and EXIT_FAILURE if not. Each run
+measures one set of tables, since the peak resident set size only
+grows. */
+int main(int argc, char *argv[]) {
+    unsigned long ulTables = 1000000;
+    unsigned long ulBindings = 4;
+
+    if(argc > 3) {
+        fprintf(stderr, "Usage: %s [tables [bindings]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc >= 2 && sscanf(argv[1], "%lu", &ulTables) != 1) {
+        fprintf(stderr, "tables must be numeric\n");
+        return EXIT_FAILURE;
+    }
+    if(argc == 3 && sscanf(argv[2], "%lu", &ulBindings) != 1) {
+        fprintf(stderr, "bindings must be numeric\n");
+        return EXIT_FAILURE;
+    }
+
+    return benchSmall((size_t)ulTables, (size_t)ulBindings)
+    ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,232 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtablezipf.c                                                */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtablelist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Measures the list implementation under each reordering policy on
+lookups whose keys follow a Zipf distribution: the key of rank r is
+looked up with probability proportional to 1/r. The ranks are
+shuffled against the order of the puts, so the hot keys start
+anywhere in the list. */
+
+/* number of timed lookups per table size and policy */
+enum {LOOKUP_COUNT = 1000000};
+
+/* number of lookups whose comparisons are counted */
+enum {SAMPLE_COUNT = 20000};
+
+/* maximum length of a generated key, including its '\0' */
+enum {MAX_KEY_LENGTH = 24};
+
+/* the policies, and their names for the report */
+static const enum SymTableOrder aeOrders[] = {SYMTABLE_ORDER_NONE,
+    SYMTABLE_ORDER_MOVE_TO_FRONT, SYMTABLE_ORDER_TRANSPOSE,
+    SYMTABLE_ORDER_COUNT};
+static const char *const apcOrderNames[] = {"none", "move-to-front",
+    "transpose", "count"};
+
+/* Returns the next value of the pseudo-random sequence whose state is
+*puState. The benchmark needs the same sequence on every platform, so
+it does not use rand(). */
+static size_t nextRandom(size_t *puState) {
+    *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+    return *puState >> 16;
+}
+
+/* Returns the CPU time consumed so far, in seconds. */
+static double cpuSeconds(void) {
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/* Returns a rank from 0 to uCount - 1 drawn from the Zipf distribution
+whose cumulative probabilities are pdCumulative[0..uCount-1]. */
+static size_t drawRank(const double *pdCumulative, size_t uCount,
+size_t *puState) {
+    double dDraw;
+    size_t uLow = 0;
+    size_t uHigh = uCount - 1;
+    size_t uMiddle;
+
+    dDraw = (double)(nextRandom(puState) & 0xffffffffU) / 4294967296.0;
+    while(uLow < uHigh) {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if(pdCumulative[uMiddle] <= dDraw) {
+            uLow = uMiddle + 1;
+        }
+        else {
+            uHigh = uMiddle;
+        }
+    }
+    return uLow;
+}
+
+/* Returns the number of keys SymTable_get compares pcKey with in the
+list oSymTable, which holds it: its position from the front, plus 1.
+Counts with a cursor, which sees the pairs in list order. */
+static size_t countComparisons(SymTable_T oSymTable,
+const char *pcKey) {
+    struct SymTableIter sIter;
+    const char *pcSeen;
+    void *pvValue;
+    size_t uComparisons = 0;
+
+    SymTable_iterBegin(oSymTable, &sIter);
+    while(SymTable_iterNext(&sIter, &pcSeen, &pvValue)) {
+        uComparisons++;
+        if(!strcmp(pcSeen, pcKey)) {
+            break;
+        }
+    }
+    SymTable_iterEnd(&sIter);
+    return uComparisons;
+}
+
+/* Measures a table of uCount bindings under each policy: the time of
+LOOKUP_COUNT successful SymTable_get calls, then the mean comparisons
+per call over SAMPLE_COUNT more, once the list has settled. pcKeys
+holds the keys and pdCumulative room for uCount cumulative
+probabilities. Returns 0 if successful and 1 if not. */
+static int benchSize(size_t uCount, const char *pcKeys,
+double *pdCumulative) {
+    SymTable_T oSymTable;
+    const char *pcKey;
+    size_t *puRankToKey;
+    size_t uState;
+    size_t uComparisons;
+    size_t uFound;
+    size_t uSwap;
+    size_t u;
+    size_t v;
+    double dTotal = 0.0;
+    double dStart;
+    double dGet;
+    int iOrder;
+
+    puRankToKey = (size_t *)malloc(uCount * sizeof(size_t));
+    if(puRankToKey == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        return 1;
+    }
+
+    for(u = 0; u < uCount; u++) {
+        dTotal += 1.0 / (double)(u + 1);
+        pdCumulative[u] = dTotal;
+    }
+    for(u = 0; u < uCount; u++) {
+        pdCumulative[u] /= dTotal;
+    }
+
+    for(iOrder = 0; iOrder < 4; iOrder++) {
+        /* the same keys, shuffle, and draws for every policy */
+        uState = 217;
+        for(u = 0; u < uCount; u++) {
+            puRankToKey[u] = u;
+        }
+        for(u = uCount - 1; u > 0; u--) {
+            v = nextRandom(&uState) % (u + 1);
+            uSwap = puRankToKey[u];
+            puRankToKey[u] = puRankToKey[v];
+            puRankToKey[v] = uSwap;
+        }
+
+        oSymTable = SymTable_new();
+        if(oSymTable == NULL) {
+            fprintf(stderr, "insufficient memory\n");
+            free(puRankToKey);
+            return 1;
+        }
+        SymTable_setOrder(oSymTable, aeOrders[iOrder]);
+        for(u = 0; u < uCount; u++) {
+            if(!SymTable_put(oSymTable, pcKeys + u * MAX_KEY_LENGTH,
+            oSymTable)) {
+                fprintf(stderr, "insufficient memory\n");
+                SymTable_free(oSymTable);
+                free(puRankToKey);
+                return 1;
+            }
+        }
+
+        uFound = 0;
+        dStart = cpuSeconds();
+        for(u = 0; u < LOOKUP_COUNT; u++) {
+            pcKey = pcKeys + puRankToKey[drawRank(pdCumulative, uCount,
+            &uState)] * MAX_KEY_LENGTH;
+            if(SymTable_get(oSymTable, pcKey) != NULL) {
+                uFound++;
+            }
+        }
+        dGet = cpuSeconds() - dStart;
+        if(uFound != LOOKUP_COUNT) {
+            fprintf(stderr, "lookup failed\n");
+        }
+
+        uComparisons = 0;
+        for(u = 0; u < SAMPLE_COUNT; u++) {
+            pcKey = pcKeys + puRankToKey[drawRank(pdCumulative, uCount,
+            &uState)] * MAX_KEY_LENGTH;
+            uComparisons += countComparisons(oSymTable, pcKey);
+            (void)SymTable_get(oSymTable, pcKey);
+        }
+
+        printf("%10lu %14s %14.1f %14.1f\n", (unsigned long)uCount,
+        apcOrderNames[iOrder],
+        (double)uComparisons / SAMPLE_COUNT,
+        dGet * 1e9 / LOOKUP_COUNT);
+        fflush(stdout);
+        SymTable_free(oSymTable);
+    }
+
+    free(puRankToKey);
+    return 0;
+}
+
+/* Runs the benchmark for tables of 16, 64, 256, ... up to argv[1]
+bindings (default 1024). Writes the mean comparisons per successful
+lookup and the time per lookup to stdout. Returns 0 if successful and
+EXIT_FAILURE if not. */
+int main(int argc, char *argv[]) {
+    unsigned long ulMaxCount = 1024;
+    char *pcKeys;
+    double *pdCumulative;
+    size_t uCount;
+    size_t u;
+    int iFailed = 0;
+
+    if(argc > 2) {
+        fprintf(stderr, "Usage: %s [maxcount]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc == 2 && sscanf(argv[1], "%lu", &ulMaxCount) != 1) {
+        fprintf(stderr, "maxcount must be numeric\n");
+        return EXIT_FAILURE;
+    }
+
+    pcKeys = (char *)malloc((size_t)ulMaxCount * MAX_KEY_LENGTH);
+    pdCumulative =
+    (double *)malloc((size_t)ulMaxCount * sizeof(double));
+    if(pcKeys == NULL || pdCumulative == NULL) {
+        fprintf(stderr, "insufficient memory\n");
+        free(pcKeys);
+        free(pdCumulative);
+        return EXIT_FAILURE;
+    }
+    for(u = 0; u < ulMaxCount; u++) {
+        sprintf(pcKeys + u * MAX_KEY_LENGTH, "%lu", (unsigned long)u);
+    }
+
+    printf("%10s %14s %14s %14s\n", "bindings", "policy",
+    "compares/get", "get ns/op");
+    for(uCount = 16; uCount <= ulMaxCount && !iFailed; uCount *= 4) {
+        iFailed = benchSize(uCount, pcKeys, pdCumulative);
+    }
+
+    free(pcKeys);
+    free(pdCumulative);
+    return iFailed ? EXIT_FAILURE : 0;
+}
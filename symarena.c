@@ -0,0 +1,233 @@
+/*--------------------------------------------------------------------*/
+/* symarena.c                                                         */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symarena.h"
+
+/* number of objects in the first slab. Each later slab is twice as
+large as the one before it, up to MAX_SLAB_OBJECTS. */
+enum {MIN_SLAB_OBJECTS = 64};
+enum {MAX_SLAB_OBJECTS = 65536};
+
+/* number of bytes in the first string page. Each later page is twice
+as large as the one before it, up to MAX_PAGE_SIZE. */
+enum {MIN_PAGE_SIZE = 4096};
+enum {MAX_PAGE_SIZE = 1048576};
+
+/* the strictest alignment any object might need */
+union Align
+{
+    void *pv;
+    size_t u;
+    long l;
+    double d;
+};
+
+/* A Chunk is a slab of objects or a page of strings. Chunks of each
+kind form a linked list so that the arena can free them. The usable
+bytes follow the header. */
+struct Chunk
+{
+    /* address of next chunk */
+    struct Chunk *psNextChunk;
+    /* forces the bytes after the header to be suitably aligned */
+    union Align uAlign;
+};
+
+/* An object handed back by SymArena_release holds the address of the
+next free object. */
+struct FreeObject
+{
+    /* address of next free object */
+    struct FreeObject *psNextFree;
+};
+
+/* SymArena tracks its slabs, its pages, and the unused space at the
+end of the newest of each. */
+struct SymArena
+{
+    /* size of each object, rounded up to keep objects aligned */
+    size_t uObjectSize;
+
+    /* list of slabs, newest first */
+    struct Chunk *psSlabs;
+    /* number of objects in the newest slab */
+    size_t uSlabObjects;
+    /* number of objects of the newest slab not yet handed out */
+    size_t uSlabLeft;
+    /* released objects, available for reuse */
+    struct FreeObject *psFreeObjects;
+
+    /* list of string pages, newest first */
+    struct Chunk *psPages;
+    /* size of the newest page */
+    size_t uPageSize;
+    /* number of bytes of the newest page not yet handed out */
+    size_t uPageLeft;
+
+    /* number of bytes allocated for the arena, its slabs, and its
+    pages */
+    size_t uBytes;
+};
+
+SymArena_T SymArena_new(size_t uObjectSize) {
+    SymArena_T oArena;
+
+    assert(uObjectSize > 0);
+
+    oArena = (SymArena_T)malloc(sizeof(struct SymArena));
+    if(oArena == NULL) {
+        return NULL;
+    }
+
+    /* rounds uObjectSize up to a multiple of the strictest alignment,
+    and makes room for the free list link */
+    if(uObjectSize < sizeof(struct FreeObject)) {
+        uObjectSize = sizeof(struct FreeObject);
+    }
+    oArena->uObjectSize = (uObjectSize + sizeof(union Align) - 1)
+    / sizeof(union Align) * sizeof(union Align);
+
+    oArena->psSlabs = NULL;
+    oArena->uSlabObjects = 0;
+    oArena->uSlabLeft = 0;
+    oArena->psFreeObjects = NULL;
+    oArena->psPages = NULL;
+    oArena->uPageSize = 0;
+    oArena->uPageLeft = 0;
+    oArena->uBytes = sizeof(struct SymArena);
+
+    return oArena;
+}
+
+/* Frees every chunk in the list beginning at psCurrentChunk. */
+static void SymArena_freeChunks(struct Chunk *psCurrentChunk) {
+    struct Chunk *psNextChunk;
+
+    while(psCurrentChunk != NULL) {
+        psNextChunk = psCurrentChunk->psNextChunk;
+        free(psCurrentChunk);
+        psCurrentChunk = psNextChunk;
+    }
+}
+
+void SymArena_free(SymArena_T oArena) {
+    assert(oArena != NULL);
+
+    SymArena_freeChunks(oArena->psSlabs);
+    SymArena_freeChunks(oArena->psPages);
+    free(oArena);
+}
+
+/* Returns the address of the first usable byte of psChunk. */
+static char *SymArena_chunkData(struct Chunk *psChunk) {
+    return (char *)&psChunk->uAlign;
+}
+
+void *SymArena_alloc(SymArena_T oArena) {
+    struct FreeObject *psObject;
+    struct Chunk *psSlab;
+    size_t uObjects;
+
+    assert(oArena != NULL);
+
+    /* reuses a released object if there is one */
+    if(oArena->psFreeObjects != NULL) {
+        psObject = oArena->psFreeObjects;
+        oArena->psFreeObjects = psObject->psNextFree;
+        return psObject;
+    }
+
+    /* starts a new, larger slab when the newest one is used up */
+    if(oArena->uSlabLeft == 0) {
+        uObjects = oArena->uSlabObjects * 2;
+        if(uObjects < MIN_SLAB_OBJECTS) {
+            uObjects = MIN_SLAB_OBJECTS;
+        }
+        if(uObjects > MAX_SLAB_OBJECTS) {
+            uObjects = MAX_SLAB_OBJECTS;
+        }
+        psSlab = (struct Chunk *)malloc(offsetof(struct Chunk, uAlign)
+        + uObjects * oArena->uObjectSize);
+        if(psSlab == NULL) {
+            return NULL;
+        }
+        oArena->uBytes += offsetof(struct Chunk, uAlign)
+        + uObjects * oArena->uObjectSize;
+        psSlab->psNextChunk = oArena->psSlabs;
+        oArena->psSlabs = psSlab;
+        oArena->uSlabObjects = uObjects;
+        oArena->uSlabLeft = uObjects;
+    }
+
+    /* hands out the slab's objects front to back */
+    (oArena->uSlabLeft)--;
+    return SymArena_chunkData(oArena->psSlabs)
+    + (oArena->uSlabObjects - oArena->uSlabLeft - 1)
+    * oArena->uObjectSize;
+}
+
+void SymArena_release(SymArena_T oArena, void *pvObject) {
+    struct FreeObject *psObject;
+
+    assert(oArena != NULL);
+    assert(pvObject != NULL);
+
+    psObject = (struct FreeObject *)pvObject;
+    psObject->psNextFree = oArena->psFreeObjects;
+    oArena->psFreeObjects = psObject;
+}
+
+char *SymArena_copyString(SymArena_T oArena, const char *pcString,
+size_t uLength) {
+    struct Chunk *psPage;
+    size_t uPageSize;
+    char *pcCopy;
+
+    assert(oArena != NULL);
+    assert(pcString != NULL);
+
+    /* starts a new page when the string does not fit in the newest
+    one. A string larger than a page gets a page of its own. */
+    if(uLength + 1 > oArena->uPageLeft) {
+        uPageSize = oArena->uPageSize * 2;
+        if(uPageSize < MIN_PAGE_SIZE) {
+            uPageSize = MIN_PAGE_SIZE;
+        }
+        if(uPageSize > MAX_PAGE_SIZE) {
+            uPageSize = MAX_PAGE_SIZE;
+        }
+        if(uPageSize < uLength + 1) {
+            uPageSize = uLength + 1;
+        }
+        psPage = (struct Chunk *)malloc(offsetof(struct Chunk, uAlign)
+        + uPageSize);
+        if(psPage == NULL) {
+            return NULL;
+        }
+        oArena->uBytes += offsetof(struct Chunk, uAlign) + uPageSize;
+        psPage->psNextChunk = oArena->psPages;
+        oArena->psPages = psPage;
+        oArena->uPageSize = uPageSize;
+        oArena->uPageLeft = uPageSize;
+    }
+
+    /* packs the copy right after the previous string on the page */
+    pcCopy = SymArena_chunkData(oArena->psPages)
+    + (oArena->uPageSize - oArena->uPageLeft);
+    memcpy(pcCopy, pcString, uLength);
+    pcCopy[uLength] = '\0';
+    oArena->uPageLeft -= uLength + 1;
+
+    return pcCopy;
+}
+
+size_t SymArena_getBytes(SymArena_T oArena) {
+    assert(oArena != NULL);
+
+    return oArena->uBytes;
+}
@@ -0,0 +1,46 @@
+/*--------------------------------------------------------------------*/
+/* symarena.h                                                         */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMARENA_INCLUDED
+#define SYMARENA_INCLUDED
+
+#include <stddef.h>
+
+/* A SymArena_T object hands out fixed-size objects carved from large
+slabs and copies of strings packed into large pages. Everything it
+hands out is released at once when the arena is freed. */
+typedef struct SymArena *SymArena_T;
+
+/* Returns a new SymArena_T object whose objects are uObjectSize bytes
+long, or NULL if insufficient memory is available. uObjectSize cannot
+be 0. */
+SymArena_T SymArena_new(size_t uObjectSize);
+
+/* Frees oArena along with every object and string it handed out.
+oArena cannot be NULL. */
+void SymArena_free(SymArena_T oArena);
+
+/* Returns an uninitialized object from oArena, or NULL if insufficient
+memory is available. Objects returned by SymArena_release are handed
+out again first. oArena cannot be NULL. */
+void *SymArena_alloc(SymArena_T oArena);
+
+/* Returns pvObject, which oArena handed out, to oArena so that a later
+SymArena_alloc can reuse it. oArena and pvObject cannot be NULL. */
+void SymArena_release(SymArena_T oArena, void *pvObject);
+
+/* Returns a copy of the first uLength characters of pcString,
+followed by '\0', stored in oArena, or NULL if insufficient memory is
+available. The copy lives until oArena is freed. oArena and pcString
+cannot be NULL. */
+char *SymArena_copyString(SymArena_T oArena, const char *pcString,
+size_t uLength);
+
+/* Returns the number of bytes oArena has allocated for itself, its
+slabs, and its pages, whether handed out or not. oArena cannot be
+NULL. */
+size_t SymArena_getBytes(SymArena_T oArena);
+
+#endif
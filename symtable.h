@@ -49,6 +49,24 @@ the value. If not, does not change oSymTable and returns NULL.
 oSymTable and pcKey cannot be NULL. */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
 
+/* Returns the address of the value of the pair with pcKey in
+oSymTable. If oSymTable does not contain pcKey, first puts a
+pcKey/NULL pair into it. Unless piInserted is NULL, sets *piInserted
+to 1 (TRUE) if the pair is new and to 0 (FALSE) if not. Returns NULL
+if there is insufficient memory, leaving oSymTable unchanged. The
+address is valid only until the next call that puts or removes a
+pair. oSymTable and pcKey cannot be NULL. Creates a copy of pcKey if
+it puts a pair. */
+void **SymTable_findOrInsert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted);
+
+/* Puts pcKey/pvValue pair into oSymTable, or replaces the value of
+pcKey with pvValue if oSymTable already contains pcKey. Returns 1
+(TRUE) if successful and 0 (FALSE) if there is insufficient memory,
+leaving oSymTable unchanged. oSymTable and pcKey cannot be NULL. */
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue);
+
 /* Applies function *pfApply to each key/value pair in oSymTable and 
 passes pvExtra as an extra parameter. oSymTable and pfApply cannot be
 NULL. */
@@ -56,4 +74,42 @@ void SymTable_map(SymTable_T oSymTable,
 void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
 const void *pvExtra);
 
+/* A SymTableIter is a cursor over the key/value pairs of a SymTable_T
+object. It is small enough to live on the stack, and its fields belong
+to the implementation. A scan may stop after any pair and resume
+later with the same cursor, so a long scan can be split into slices
+of a few pairs each. */
+struct SymTableIter
+{
+    /* table being scanned */
+    SymTable_T oSymTable;
+
+    /* position of the next pair to look at */
+    size_t uPosition;
+
+    /* next pair to return, or NULL if it must be searched for from
+    uPosition */
+    void *pvNext;
+};
+
+/* Starts *psIter at the first key/value pair of oSymTable. The cursor
+stays valid until a pair is put into or removed from oSymTable, or
+until oSymTable is freed or resized; SymTable_get, SymTable_contains,
+and SymTable_replace leave it valid. oSymTable and psIter cannot be
+NULL. */
+void SymTable_iterBegin(SymTable_T oSymTable,
+struct SymTableIter *psIter);
+
+/* Stores the key and value of the next pair of *psIter in *ppcKey and
+*ppvValue and returns 1 (TRUE), or returns 0 (FALSE) if every pair has
+been returned. Each pair is returned once, in no particular order.
+psIter, ppcKey, and ppvValue cannot be NULL. */
+int SymTable_iterNext(struct SymTableIter *psIter, const char **ppcKey,
+void **ppvValue);
+
+/* Ends the scan of *psIter early, after which SymTable_iterNext
+returns 0 (FALSE). A cursor that ran to the end needs no call. psIter
+cannot be NULL. */
+void SymTable_iterEnd(struct SymTableIter *psIter);
+
 #endif
\ No newline at end of file
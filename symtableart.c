@@ -0,0 +1,1101 @@
+/*--------------------------------------------------------------------*/
+/* symtableart.c                                                      */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* The table is an adaptive radix tree over the bytes of the keys,
+each key followed by its '\0', so that no key is a prefix of another.
+An inner node branches on one byte and comes in four sizes, which
+grow and shrink with the number of children. A chain of nodes with
+one child each is compressed into a prefix of the node below it, so a
+lookup visits one node per byte at which keys differ, and compares
+the rest of the key once, at the leaf. */
+
+/* kinds of inner node, by the most children they hold */
+enum {NODE4, NODE16, NODE48, NODE256};
+
+/* most bytes of a compressed path stored in a node. Longer paths
+keep only their start; the rest is read from a leaf below when an
+insertion or a removal needs it, and lookups check it at the leaf. */
+enum {MAX_PREFIX = 10};
+
+/* Every inner node starts with a Node. */
+struct Node
+{
+    /* NODE4, NODE16, NODE48, or NODE256 */
+    unsigned char ucType;
+
+    /* number of children */
+    unsigned short usChildren;
+
+    /* number of bytes in the compressed path above the branch byte */
+    size_t uPrefixLength;
+
+    /* first bytes of the compressed path */
+    unsigned char aucPrefix[MAX_PREFIX];
+};
+
+/* Node4 and Node16 keep the branch bytes of their children sorted,
+with the children in the same order. */
+struct Node4
+{
+    struct Node sNode;
+    unsigned char aucKeys[4];
+    void *apvChildren[4];
+};
+
+struct Node16
+{
+    struct Node sNode;
+    unsigned char aucKeys[16];
+    void *apvChildren[16];
+};
+
+/* A Node48 maps each byte to 1 + the index of its child, or to 0 if
+it has none. */
+struct Node48
+{
+    struct Node sNode;
+    unsigned char aucIndex[256];
+    void *apvChildren[48];
+};
+
+/* A Node256 has a slot for the child of every byte. */
+struct Node256
+{
+    struct Node sNode;
+    void *apvChildren[256];
+};
+
+/* A Leaf holds a binding. Its address, with the lowest bit set, is
+stored as a child, which tells leaves and nodes apart. */
+struct Leaf
+{
+    /* value */
+    void *pvValue;
+
+    /* length of the key, not counting its '\0' */
+    size_t uLength;
+
+    /* the key and its '\0' */
+    char acKey[1];
+};
+
+/* SymTable is the root of the tree and the number of bindings. */
+struct SymTable
+{
+   /* root, a node, a tagged leaf, or NULL if the table is empty */
+   void *pvRoot;
+
+   /* number of bindings */
+   size_t bindings;
+};
+
+/* Returns 1 (TRUE) if the child pvChild is a leaf, 0 (FALSE) if it is
+a node. */
+static int SymTable_isLeaf(const void *pvChild) {
+    return ((uintptr_t)pvChild & 1) != 0;
+}
+
+/* Returns the leaf that the child pvChild stands for. */
+static struct Leaf *SymTable_leaf(const void *pvChild) {
+    return (struct Leaf *)((uintptr_t)pvChild & ~(uintptr_t)1);
+}
+
+/* Returns psLeaf in the form stored as a child. */
+static void *SymTable_tagLeaf(struct Leaf *psLeaf) {
+    return (void *)((uintptr_t)psLeaf | 1);
+}
+
+/* Returns a new leaf holding a copy of the uLength bytes of pcKey and
+value NULL, or NULL if there is insufficient memory. */
+static struct Leaf *SymTable_newLeaf(const char *pcKey,
+size_t uLength) {
+    struct Leaf *psLeaf;
+
+    psLeaf = (struct Leaf *)malloc(offsetof(struct Leaf, acKey)
+    + uLength + 1);
+    if(psLeaf == NULL) {
+        return NULL;
+    }
+    psLeaf->pvValue = NULL;
+    psLeaf->uLength = uLength;
+    memcpy(psLeaf->acKey, pcKey, uLength + 1);
+    return psLeaf;
+}
+
+/* Returns 1 (TRUE) if psLeaf holds the uLength bytes of pcKey, 0
+(FALSE) if not. */
+static int SymTable_leafMatches(const struct Leaf *psLeaf,
+const char *pcKey, size_t uLength) {
+    return psLeaf->uLength == uLength
+    && memcmp(psLeaf->acKey, pcKey, uLength) == 0;
+}
+
+/* Returns a new node of kind ucType with no children and no prefix,
+or NULL if there is insufficient memory. */
+static struct Node *SymTable_newNode(unsigned char ucType) {
+    struct Node *psNode;
+    size_t uSize;
+
+    switch(ucType) {
+        case NODE4:
+            uSize = sizeof(struct Node4);
+            break;
+        case NODE16:
+            uSize = sizeof(struct Node16);
+            break;
+        case NODE48:
+            uSize = sizeof(struct Node48);
+            break;
+        default:
+            uSize = sizeof(struct Node256);
+            break;
+    }
+
+    /* calloc leaves every child slot NULL and every Node48 index 0 */
+    psNode = (struct Node *)calloc(1, uSize);
+    if(psNode == NULL) {
+        return NULL;
+    }
+    psNode->ucType = ucType;
+    return psNode;
+}
+
+/* Copies the number of children and the prefix of psSource to
+psDest. */
+static void SymTable_copyHeader(struct Node *psDest,
+const struct Node *psSource) {
+    psDest->usChildren = psSource->usChildren;
+    psDest->uPrefixLength = psSource->uPrefixLength;
+    memcpy(psDest->aucPrefix, psSource->aucPrefix, MAX_PREFIX);
+}
+
+/* Returns the address of the slot of the child of psNode for byte
+ucByte, or NULL if psNode has no such child. */
+static void **SymTable_findChild(struct Node *psNode,
+unsigned char ucByte) {
+    struct Node4 *psNode4;
+    struct Node16 *psNode16;
+    struct Node48 *psNode48;
+    struct Node256 *psNode256;
+    size_t u;
+
+    switch(psNode->ucType) {
+        case NODE4:
+            psNode4 = (struct Node4 *)psNode;
+            for(u = 0; u < psNode->usChildren; u++) {
+                if(psNode4->aucKeys[u] == ucByte) {
+                    return &psNode4->apvChildren[u];
+                }
+            }
+            return NULL;
+
+        case NODE16: {
+#if defined(__SSE2__)
+            /* compares the byte with all sixteen keys at once */
+            unsigned mask;
+
+            psNode16 = (struct Node16 *)psNode;
+            mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_set1_epi8((char)ucByte),
+                _mm_loadu_si128((const __m128i *)psNode16->aucKeys)))
+            & ((1U << psNode->usChildren) - 1);
+            if(mask == 0) {
+                return NULL;
+            }
+            u = 0;
+            while((mask & 1) == 0) {
+                mask >>= 1;
+                u++;
+            }
+            return &psNode16->apvChildren[u];
+#else
+            psNode16 = (struct Node16 *)psNode;
+            for(u = 0; u < psNode->usChildren; u++) {
+                if(psNode16->aucKeys[u] == ucByte) {
+                    return &psNode16->apvChildren[u];
+                }
+            }
+            return NULL;
+#endif
+        }
+
+        case NODE48:
+            psNode48 = (struct Node48 *)psNode;
+            if(psNode48->aucIndex[ucByte] == 0) {
+                return NULL;
+            }
+            return &psNode48->apvChildren[
+                psNode48->aucIndex[ucByte] - 1];
+
+        default:
+            psNode256 = (struct Node256 *)psNode;
+            if(psNode256->apvChildren[ucByte] == NULL) {
+                return NULL;
+            }
+            return &psNode256->apvChildren[ucByte];
+    }
+}
+
+/* Returns the child of psNode with the smallest branch byte not less
+than uByte and stores that byte in *puByte, or returns NULL if there
+is none. uByte is at most 256. */
+static void *SymTable_childFrom(const struct Node *psNode,
+unsigned uByte, unsigned *puByte) {
+    const struct Node4 *psNode4;
+    const struct Node16 *psNode16;
+    const struct Node48 *psNode48;
+    const struct Node256 *psNode256;
+    size_t u;
+
+    switch(psNode->ucType) {
+        case NODE4:
+            psNode4 = (const struct Node4 *)psNode;
+            for(u = 0; u < psNode->usChildren; u++) {
+                if(psNode4->aucKeys[u] >= uByte) {
+                    *puByte = psNode4->aucKeys[u];
+                    return psNode4->apvChildren[u];
+                }
+            }
+            return NULL;
+
+        case NODE16:
+            psNode16 = (const struct Node16 *)psNode;
+            for(u = 0; u < psNode->usChildren; u++) {
+                if(psNode16->aucKeys[u] >= uByte) {
+                    *puByte = psNode16->aucKeys[u];
+                    return psNode16->apvChildren[u];
+                }
+            }
+            return NULL;
+
+        case NODE48:
+            psNode48 = (const struct Node48 *)psNode;
+            for(; uByte < 256; uByte++) {
+                if(psNode48->aucIndex[uByte] != 0) {
+                    *puByte = uByte;
+                    return psNode48->apvChildren[
+                        psNode48->aucIndex[uByte] - 1];
+                }
+            }
+            return NULL;
+
+        default:
+            psNode256 = (const struct Node256 *)psNode;
+            for(; uByte < 256; uByte++) {
+                if(psNode256->apvChildren[uByte] != NULL) {
+                    *puByte = uByte;
+                    return psNode256->apvChildren[uByte];
+                }
+            }
+            return NULL;
+    }
+}
+
+/* Returns the leaf with the smallest key below the child pvChild. */
+static struct Leaf *SymTable_minimum(const void *pvChild) {
+    unsigned uByte;
+
+    while(!SymTable_isLeaf(pvChild)) {
+        pvChild = SymTable_childFrom((const struct Node *)pvChild, 0,
+        &uByte);
+    }
+    return SymTable_leaf(pvChild);
+}
+
+/* Adds pvChild to psNode, stored at *ppvNode, as the child for byte
+ucByte, which psNode has no child for. A full node is replaced by one
+of the next larger kind. Returns 1 (TRUE) if successful and 0 (FALSE)
+if there is insufficient memory, leaving psNode unchanged. */
+static int SymTable_addChild(void **ppvNode, struct Node *psNode,
+unsigned char ucByte, void *pvChild) {
+    struct Node4 *psNode4;
+    struct Node16 *psNode16;
+    struct Node48 *psNode48;
+    struct Node256 *psNode256;
+    struct Node *psLarger;
+    size_t u;
+
+    switch(psNode->ucType) {
+        case NODE4:
+            psNode4 = (struct Node4 *)psNode;
+            if(psNode->usChildren < 4) {
+                for(u = psNode->usChildren;
+                u > 0 && psNode4->aucKeys[u - 1] > ucByte; u--) {
+                    psNode4->aucKeys[u] = psNode4->aucKeys[u - 1];
+                    psNode4->apvChildren[u] =
+                    psNode4->apvChildren[u - 1];
+                }
+                psNode4->aucKeys[u] = ucByte;
+                psNode4->apvChildren[u] = pvChild;
+                (psNode->usChildren)++;
+                return 1;
+            }
+            psLarger = SymTable_newNode(NODE16);
+            if(psLarger == NULL) {
+                return 0;
+            }
+            SymTable_copyHeader(psLarger, psNode);
+            memcpy(((struct Node16 *)psLarger)->aucKeys,
+            psNode4->aucKeys, 4);
+            memcpy(((struct Node16 *)psLarger)->apvChildren,
+            psNode4->apvChildren, 4 * sizeof(void *));
+            break;
+
+        case NODE16:
+            psNode16 = (struct Node16 *)psNode;
+            if(psNode->usChildren < 16) {
+                for(u = psNode->usChildren;
+                u > 0 && psNode16->aucKeys[u - 1] > ucByte; u--) {
+                    psNode16->aucKeys[u] = psNode16->aucKeys[u - 1];
+                    psNode16->apvChildren[u] =
+                    psNode16->apvChildren[u - 1];
+                }
+                psNode16->aucKeys[u] = ucByte;
+                psNode16->apvChildren[u] = pvChild;
+                (psNode->usChildren)++;
+                return 1;
+            }
+            psLarger = SymTable_newNode(NODE48);
+            if(psLarger == NULL) {
+                return 0;
+            }
+            SymTable_copyHeader(psLarger, psNode);
+            for(u = 0; u < 16; u++) {
+                ((struct Node48 *)psLarger)->aucIndex[
+                    psNode16->aucKeys[u]] = (unsigned char)(u + 1);
+                ((struct Node48 *)psLarger)->apvChildren[u] =
+                psNode16->apvChildren[u];
+            }
+            break;
+
+        case NODE48:
+            psNode48 = (struct Node48 *)psNode;
+            if(psNode->usChildren < 48) {
+                /* removals can leave any slot free */
+                for(u = 0; psNode48->apvChildren[u] != NULL; u++) {
+                }
+                psNode48->apvChildren[u] = pvChild;
+                psNode48->aucIndex[ucByte] = (unsigned char)(u + 1);
+                (psNode->usChildren)++;
+                return 1;
+            }
+            psLarger = SymTable_newNode(NODE256);
+            if(psLarger == NULL) {
+                return 0;
+            }
+            SymTable_copyHeader(psLarger, psNode);
+            for(u = 0; u < 256; u++) {
+                if(psNode48->aucIndex[u] != 0) {
+                    ((struct Node256 *)psLarger)->apvChildren[u] =
+                    psNode48->apvChildren[psNode48->aucIndex[u] - 1];
+                }
+            }
+            break;
+
+        default:
+            psNode256 = (struct Node256 *)psNode;
+            psNode256->apvChildren[ucByte] = pvChild;
+            (psNode->usChildren)++;
+            return 1;
+    }
+
+    /* the larger node has room */
+    *ppvNode = psLarger;
+    free(psNode);
+    return SymTable_addChild(ppvNode, psLarger, ucByte, pvChild);
+}
+
+/* Replaces the Node4 psNode4, stored at *ppvNode, by its only child,
+moving its prefix and the branch byte in front of the child's
+prefix. */
+static void SymTable_collapse(void **ppvNode, struct Node4 *psNode4) {
+    unsigned char aucPrefix[MAX_PREFIX];
+    struct Node *psNode = &psNode4->sNode;
+    struct Node *psChild;
+    size_t uStored;
+    size_t uCopied;
+
+    if(SymTable_isLeaf(psNode4->apvChildren[0])) {
+        *ppvNode = psNode4->apvChildren[0];
+        free(psNode4);
+        return;
+    }
+
+    /* the path of the child becomes this prefix, the branch byte, and
+    the child's own prefix */
+    psChild = (struct Node *)psNode4->apvChildren[0];
+    uStored = psNode->uPrefixLength < MAX_PREFIX
+    ? psNode->uPrefixLength : MAX_PREFIX;
+    memcpy(aucPrefix, psNode->aucPrefix, uStored);
+    if(uStored < MAX_PREFIX) {
+        aucPrefix[uStored] = psNode4->aucKeys[0];
+        uStored++;
+    }
+    if(uStored < MAX_PREFIX) {
+        uCopied = psChild->uPrefixLength < MAX_PREFIX - uStored
+        ? psChild->uPrefixLength : MAX_PREFIX - uStored;
+        memcpy(aucPrefix + uStored, psChild->aucPrefix, uCopied);
+    }
+    memcpy(psChild->aucPrefix, aucPrefix, MAX_PREFIX);
+    psChild->uPrefixLength += psNode->uPrefixLength + 1;
+
+    *ppvNode = psChild;
+    free(psNode4);
+}
+
+/* Removes the child of psNode, stored at *ppvNode, for byte ucByte,
+whose slot is ppvSlot. A node left with few children is replaced by
+one of the next smaller kind, and a Node4 with one child by that
+child. If there is insufficient memory for a smaller node, psNode
+stays as it is. */
+static void SymTable_removeChild(void **ppvNode, struct Node *psNode,
+unsigned char ucByte, void **ppvSlot) {
+    struct Node4 *psNode4;
+    struct Node16 *psNode16;
+    struct Node48 *psNode48;
+    struct Node256 *psNode256;
+    struct Node *psSmaller;
+    size_t uIndex;
+    size_t uMoved;
+    size_t u;
+
+    switch(psNode->ucType) {
+        case NODE4:
+            psNode4 = (struct Node4 *)psNode;
+            uIndex = (size_t)(ppvSlot - psNode4->apvChildren);
+            uMoved = psNode->usChildren - uIndex - 1;
+            memmove(&psNode4->aucKeys[uIndex],
+            &psNode4->aucKeys[uIndex + 1], uMoved);
+            memmove(&psNode4->apvChildren[uIndex],
+            &psNode4->apvChildren[uIndex + 1], uMoved * sizeof(void *));
+            (psNode->usChildren)--;
+            if(psNode->usChildren == 1) {
+                SymTable_collapse(ppvNode, psNode4);
+            }
+            return;
+
+        case NODE16:
+            psNode16 = (struct Node16 *)psNode;
+            uIndex = (size_t)(ppvSlot - psNode16->apvChildren);
+            uMoved = psNode->usChildren - uIndex - 1;
+            memmove(&psNode16->aucKeys[uIndex],
+            &psNode16->aucKeys[uIndex + 1], uMoved);
+            memmove(&psNode16->apvChildren[uIndex],
+            &psNode16->apvChildren[uIndex + 1],
+            uMoved * sizeof(void *));
+            (psNode->usChildren)--;
+            if(psNode->usChildren > 3) {
+                return;
+            }
+            psSmaller = SymTable_newNode(NODE4);
+            if(psSmaller == NULL) {
+                return;
+            }
+            SymTable_copyHeader(psSmaller, psNode);
+            memcpy(((struct Node4 *)psSmaller)->aucKeys,
+            psNode16->aucKeys, psNode->usChildren);
+            memcpy(((struct Node4 *)psSmaller)->apvChildren,
+            psNode16->apvChildren, psNode->usChildren * sizeof(void *));
+            break;
+
+        case NODE48:
+            psNode48 = (struct Node48 *)psNode;
+            uIndex = (size_t)psNode48->aucIndex[ucByte] - 1;
+            psNode48->apvChildren[uIndex] = NULL;
+            psNode48->aucIndex[ucByte] = 0;
+            (psNode->usChildren)--;
+            if(psNode->usChildren > 12) {
+                return;
+            }
+            psSmaller = SymTable_newNode(NODE16);
+            if(psSmaller == NULL) {
+                return;
+            }
+            SymTable_copyHeader(psSmaller, psNode);
+            for(u = 0, uIndex = 0; u < 256; u++) {
+                if(psNode48->aucIndex[u] != 0) {
+                    ((struct Node16 *)psSmaller)->aucKeys[uIndex] =
+                    (unsigned char)u;
+                    ((struct Node16 *)psSmaller)->apvChildren[uIndex] =
+                    psNode48->apvChildren[psNode48->aucIndex[u] - 1];
+                    uIndex++;
+                }
+            }
+            break;
+
+        default:
+            psNode256 = (struct Node256 *)psNode;
+            psNode256->apvChildren[ucByte] = NULL;
+            (psNode->usChildren)--;
+            if(psNode->usChildren > 37) {
+                return;
+            }
+            psSmaller = SymTable_newNode(NODE48);
+            if(psSmaller == NULL) {
+                return;
+            }
+            SymTable_copyHeader(psSmaller, psNode);
+            for(u = 0, uIndex = 0; u < 256; u++) {
+                if(psNode256->apvChildren[u] != NULL) {
+                    ((struct Node48 *)psSmaller)->aucIndex[u] =
+                    (unsigned char)(uIndex + 1);
+                    ((struct Node48 *)psSmaller)->apvChildren[uIndex] =
+                    psNode256->apvChildren[u];
+                    uIndex++;
+                }
+            }
+            break;
+    }
+
+    *ppvNode = psSmaller;
+    free(psNode);
+}
+
+/* Returns the number of bytes of the prefix of psNode that match the
+key pcKey of uKeyBytes bytes, counting its '\0', from byte uDepth on.
+Bytes past those stored in psNode are read from a leaf below it. */
+static size_t SymTable_prefixMatch(const struct Node *psNode,
+const char *pcKey, size_t uKeyBytes, size_t uDepth) {
+    const struct Leaf *psLeaf;
+    size_t u;
+
+    for(u = 0; u < psNode->uPrefixLength && u < MAX_PREFIX; u++) {
+        if(uDepth + u >= uKeyBytes
+        || psNode->aucPrefix[u] != (unsigned char)pcKey[uDepth + u]) {
+            return u;
+        }
+    }
+    if(psNode->uPrefixLength > MAX_PREFIX) {
+        psLeaf = SymTable_minimum(psNode);
+        for(; u < psNode->uPrefixLength; u++) {
+            if(uDepth + u >= uKeyBytes
+            || psLeaf->acKey[uDepth + u] != pcKey[uDepth + u]) {
+                return u;
+            }
+        }
+    }
+    return psNode->uPrefixLength;
+}
+
+/* Returns the leaf of oSymTable holding the uLength bytes of pcKey, or
+NULL if there is none. Only the stored bytes of each prefix are
+compared on the way down; the leaf compares the whole key. */
+static struct Leaf *SymTable_findLeaf(SymTable_T oSymTable,
+const char *pcKey, size_t uLength) {
+    const void *pvChild = oSymTable->pvRoot;
+    const struct Node *psNode;
+    void **ppvSlot;
+    size_t uDepth = 0;
+
+    while(pvChild != NULL) {
+        if(SymTable_isLeaf(pvChild)) {
+            return SymTable_leafMatches(SymTable_leaf(pvChild), pcKey,
+            uLength) ? SymTable_leaf(pvChild) : NULL;
+        }
+
+        psNode = (const struct Node *)pvChild;
+        if(psNode->uPrefixLength > 0) {
+            if(uDepth + psNode->uPrefixLength > uLength
+            || memcmp(psNode->aucPrefix, pcKey + uDepth,
+            psNode->uPrefixLength < MAX_PREFIX
+            ? psNode->uPrefixLength : MAX_PREFIX) != 0) {
+                return NULL;
+            }
+            uDepth += psNode->uPrefixLength;
+        }
+
+        ppvSlot = SymTable_findChild((struct Node *)psNode,
+        (unsigned char)pcKey[uDepth]);
+        if(ppvSlot == NULL) {
+            return NULL;
+        }
+        pvChild = *ppvSlot;
+        uDepth++;
+    }
+    return NULL;
+}
+
+/* Returns the leaf holding the uLength bytes of pcKey below the child
+stored at *ppvChild, whose bytes before uDepth match the key, first
+adding a leaf with value NULL if there is none. Sets *piInserted to 1
+(TRUE) if the leaf is new. Returns NULL if there is insufficient
+memory, leaving the tree unchanged. */
+static struct Leaf *SymTable_insert(void **ppvChild, const char *pcKey,
+size_t uLength, size_t uDepth, int *piInserted) {
+    struct Leaf *psOldLeaf;
+    struct Leaf *psNewLeaf;
+    const struct Leaf *psMinimum;
+    struct Node *psNode;
+    struct Node *psBranch;
+    void *pvBranch;
+    void **ppvSlot;
+    unsigned char ucOldByte;
+    size_t uMatched;
+    size_t uStored;
+
+    for(;;) {
+        if(*ppvChild == NULL) {
+            psNewLeaf = SymTable_newLeaf(pcKey, uLength);
+            if(psNewLeaf == NULL) {
+                return NULL;
+            }
+            *ppvChild = SymTable_tagLeaf(psNewLeaf);
+            *piInserted = 1;
+            return psNewLeaf;
+        }
+
+        if(SymTable_isLeaf(*ppvChild)) {
+            psOldLeaf = SymTable_leaf(*ppvChild);
+            if(SymTable_leafMatches(psOldLeaf, pcKey, uLength)) {
+                return psOldLeaf;
+            }
+
+            /* a Node4 takes the place of the leaf, with the bytes both
+            keys share as its prefix; the keys end in '\0', so they
+            differ before either ends */
+            for(uMatched = 0; pcKey[uDepth + uMatched]
+            == psOldLeaf->acKey[uDepth + uMatched]; uMatched++) {
+            }
+            psNewLeaf = SymTable_newLeaf(pcKey, uLength);
+            psBranch = SymTable_newNode(NODE4);
+            if(psNewLeaf == NULL || psBranch == NULL) {
+                free(psNewLeaf);
+                free(psBranch);
+                return NULL;
+            }
+            psBranch->uPrefixLength = uMatched;
+            memcpy(psBranch->aucPrefix, pcKey + uDepth,
+            uMatched < MAX_PREFIX ? uMatched : MAX_PREFIX);
+            pvBranch = psBranch;
+            SymTable_addChild(&pvBranch, psBranch,
+            (unsigned char)psOldLeaf->acKey[uDepth + uMatched],
+            *ppvChild);
+            SymTable_addChild(&pvBranch, psBranch,
+            (unsigned char)pcKey[uDepth + uMatched],
+            SymTable_tagLeaf(psNewLeaf));
+            *ppvChild = psBranch;
+            *piInserted = 1;
+            return psNewLeaf;
+        }
+
+        psNode = (struct Node *)*ppvChild;
+        if(psNode->uPrefixLength > 0) {
+            uMatched = SymTable_prefixMatch(psNode, pcKey, uLength + 1,
+            uDepth);
+            if(uMatched < psNode->uPrefixLength) {
+                /* the key leaves the path inside the prefix, so a
+                Node4 takes the matched part and branches there */
+                psNewLeaf = SymTable_newLeaf(pcKey, uLength);
+                psBranch = SymTable_newNode(NODE4);
+                if(psNewLeaf == NULL || psBranch == NULL) {
+                    free(psNewLeaf);
+                    free(psBranch);
+                    return NULL;
+                }
+                psBranch->uPrefixLength = uMatched;
+                memcpy(psBranch->aucPrefix, psNode->aucPrefix,
+                uMatched < MAX_PREFIX ? uMatched : MAX_PREFIX);
+
+                /* psNode keeps the part after the branch byte */
+                if(psNode->uPrefixLength <= MAX_PREFIX) {
+                    ucOldByte = psNode->aucPrefix[uMatched];
+                    psNode->uPrefixLength -= uMatched + 1;
+                    memmove(psNode->aucPrefix,
+                    psNode->aucPrefix + uMatched + 1,
+                    psNode->uPrefixLength);
+                }
+                else {
+                    psMinimum = SymTable_minimum(psNode);
+                    ucOldByte =
+                    (unsigned char)psMinimum->acKey[uDepth + uMatched];
+                    psNode->uPrefixLength -= uMatched + 1;
+                    uStored = psNode->uPrefixLength < MAX_PREFIX
+                    ? psNode->uPrefixLength : MAX_PREFIX;
+                    memcpy(psNode->aucPrefix,
+                    psMinimum->acKey + uDepth + uMatched + 1, uStored);
+                }
+
+                pvBranch = psBranch;
+                SymTable_addChild(&pvBranch, psBranch, ucOldByte,
+                psNode);
+                SymTable_addChild(&pvBranch, psBranch,
+                (unsigned char)pcKey[uDepth + uMatched],
+                SymTable_tagLeaf(psNewLeaf));
+                *ppvChild = psBranch;
+                *piInserted = 1;
+                return psNewLeaf;
+            }
+            uDepth += psNode->uPrefixLength;
+        }
+
+        ppvSlot = SymTable_findChild(psNode,
+        (unsigned char)pcKey[uDepth]);
+        if(ppvSlot == NULL) {
+            psNewLeaf = SymTable_newLeaf(pcKey, uLength);
+            if(psNewLeaf == NULL) {
+                return NULL;
+            }
+            if(!SymTable_addChild(ppvChild, psNode,
+            (unsigned char)pcKey[uDepth],
+            SymTable_tagLeaf(psNewLeaf))) {
+                free(psNewLeaf);
+                return NULL;
+            }
+            *piInserted = 1;
+            return psNewLeaf;
+        }
+        ppvChild = ppvSlot;
+        uDepth++;
+    }
+}
+
+/* Removes the leaf holding the uLength bytes of pcKey from below the
+child stored at *ppvChild and returns it, or returns NULL if there is
+none. */
+static struct Leaf *SymTable_removeLeaf(void **ppvChild,
+const char *pcKey, size_t uLength) {
+    struct Leaf *psLeaf;
+    struct Node *psNode;
+    void **ppvSlot;
+    size_t uDepth = 0;
+
+    if(*ppvChild == NULL) {
+        return NULL;
+    }
+
+    /* a leaf at the root */
+    if(SymTable_isLeaf(*ppvChild)) {
+        psLeaf = SymTable_leaf(*ppvChild);
+        if(!SymTable_leafMatches(psLeaf, pcKey, uLength)) {
+            return NULL;
+        }
+        *ppvChild = NULL;
+        return psLeaf;
+    }
+
+    for(;;) {
+        psNode = (struct Node *)*ppvChild;
+        if(psNode->uPrefixLength > 0) {
+            if(uDepth + psNode->uPrefixLength > uLength
+            || memcmp(psNode->aucPrefix, pcKey + uDepth,
+            psNode->uPrefixLength < MAX_PREFIX
+            ? psNode->uPrefixLength : MAX_PREFIX) != 0) {
+                return NULL;
+            }
+            uDepth += psNode->uPrefixLength;
+        }
+
+        ppvSlot = SymTable_findChild(psNode,
+        (unsigned char)pcKey[uDepth]);
+        if(ppvSlot == NULL) {
+            return NULL;
+        }
+        if(SymTable_isLeaf(*ppvSlot)) {
+            psLeaf = SymTable_leaf(*ppvSlot);
+            if(!SymTable_leafMatches(psLeaf, pcKey, uLength)) {
+                return NULL;
+            }
+            SymTable_removeChild(ppvChild, psNode,
+            (unsigned char)pcKey[uDepth], ppvSlot);
+            return psLeaf;
+        }
+        ppvChild = ppvSlot;
+        uDepth++;
+    }
+}
+
+/* Returns the leaf with the smallest key greater than pcKey in strcmp
+order below the child pvChild, whose keys all match pcKey before byte
+uDepth, or NULL if there is none. */
+static struct Leaf *SymTable_successor(const void *pvChild,
+const char *pcKey, size_t uDepth) {
+    const struct Node *psNode;
+    const struct Leaf *psMinimum = NULL;
+    struct Leaf *psLeaf;
+    unsigned char ucPrefix;
+    unsigned char ucKey;
+    unsigned uByte;
+    size_t u;
+
+    if(pvChild == NULL) {
+        return NULL;
+    }
+    if(SymTable_isLeaf(pvChild)) {
+        psLeaf = SymTable_leaf(pvChild);
+        return strcmp(psLeaf->acKey, pcKey) > 0 ? psLeaf : NULL;
+    }
+
+    /* a prefix that differs from the key puts the whole subtree before
+    or after it; the prefix holds no '\0', so this happens at the
+    latest where pcKey ends */
+    psNode = (const struct Node *)pvChild;
+    for(u = 0; u < psNode->uPrefixLength; u++) {
+        if(u < MAX_PREFIX) {
+            ucPrefix = psNode->aucPrefix[u];
+        }
+        else {
+            if(psMinimum == NULL) {
+                psMinimum = SymTable_minimum(psNode);
+            }
+            ucPrefix = (unsigned char)psMinimum->acKey[uDepth + u];
+        }
+        ucKey = (unsigned char)pcKey[uDepth + u];
+        if(ucPrefix != ucKey) {
+            return ucPrefix > ucKey ? SymTable_minimum(psNode) : NULL;
+        }
+    }
+    uDepth += psNode->uPrefixLength;
+
+    /* the child on the key's own byte may hold a greater key, and
+    every later child holds only greater keys */
+    ucKey = (unsigned char)pcKey[uDepth];
+    pvChild = SymTable_childFrom(psNode, ucKey, &uByte);
+    if(pvChild != NULL && uByte == ucKey) {
+        psLeaf = SymTable_successor(pvChild, pcKey, uDepth + 1);
+        if(psLeaf != NULL) {
+            return psLeaf;
+        }
+        pvChild = SymTable_childFrom(psNode, (unsigned)ucKey + 1,
+        &uByte);
+    }
+    return pvChild == NULL ? NULL : SymTable_minimum(pvChild);
+}
+
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    /* Allocates memory for oSymTable. The tree starts empty. */
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if(oSymTable == NULL) {
+        return NULL;
+    }
+    oSymTable->pvRoot = NULL;
+    oSymTable->bindings = 0;
+    return oSymTable;
+}
+
+/* Frees the child pvChild and everything below it. */
+static void SymTable_freeChild(void *pvChild) {
+    struct Node *psNode;
+    unsigned uByte;
+    void *pvGrandchild;
+
+    if(SymTable_isLeaf(pvChild)) {
+        free(SymTable_leaf(pvChild));
+        return;
+    }
+    psNode = (struct Node *)pvChild;
+    for(pvGrandchild = SymTable_childFrom(psNode, 0, &uByte);
+    pvGrandchild != NULL;
+    pvGrandchild = SymTable_childFrom(psNode, uByte + 1, &uByte)) {
+        SymTable_freeChild(pvGrandchild);
+    }
+    free(psNode);
+}
+
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    if(oSymTable->pvRoot != NULL) {
+        SymTable_freeChild(oSymTable->pvRoot);
+    }
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->bindings;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    struct Leaf *psLeaf;
+    int iInserted = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_insert(&oSymTable->pvRoot, pcKey, strlen(pcKey),
+    0, &iInserted);
+    if(psLeaf == NULL || !iInserted) {
+        return 0;
+    }
+    psLeaf->pvValue = (void *) pvValue;
+    (oSymTable->bindings)++;
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    struct Leaf *psLeaf;
+    void *pvTempValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_findLeaf(oSymTable, pcKey, strlen(pcKey));
+    if(psLeaf == NULL) {
+        return NULL;
+    }
+    pvTempValue = psLeaf->pvValue;
+    psLeaf->pvValue = (void *) pvValue;
+    return pvTempValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_findLeaf(oSymTable, pcKey, strlen(pcKey)) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    struct Leaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_findLeaf(oSymTable, pcKey, strlen(pcKey));
+    return psLeaf == NULL ? NULL : psLeaf->pvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct Leaf *psLeaf;
+    void *pvTempValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_removeLeaf(&oSymTable->pvRoot, pcKey,
+    strlen(pcKey));
+    if(psLeaf == NULL) {
+        return NULL;
+    }
+    pvTempValue = psLeaf->pvValue;
+    free(psLeaf);
+    (oSymTable->bindings)--;
+    return pvTempValue;
+}
+
+void **SymTable_findOrInsert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted) {
+    struct Leaf *psLeaf;
+    int iInserted = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_insert(&oSymTable->pvRoot, pcKey, strlen(pcKey),
+    0, &iInserted);
+    if(psLeaf == NULL) {
+        return NULL;
+    }
+    if(iInserted) {
+        (oSymTable->bindings)++;
+    }
+    if(piInserted != NULL) {
+        *piInserted = iInserted;
+    }
+    return &psLeaf->pvValue;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findOrInsert(oSymTable, pcKey, NULL);
+    if(ppvValue == NULL) {
+        return 0;
+    }
+    *ppvValue = (void *) pvValue;
+    return 1;
+}
+
+/* Applies function *pfApply to each binding below the child pvChild,
+in key order, and passes pvExtra as an extra parameter. */
+static void SymTable_mapChild(const void *pvChild,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    const struct Node *psNode;
+    struct Leaf *psLeaf;
+    unsigned uByte;
+
+    if(SymTable_isLeaf(pvChild)) {
+        psLeaf = SymTable_leaf(pvChild);
+        (*pfApply)(psLeaf->acKey, psLeaf->pvValue, (void *) pvExtra);
+        return;
+    }
+    psNode = (const struct Node *)pvChild;
+    for(pvChild = SymTable_childFrom(psNode, 0, &uByte);
+    pvChild != NULL;
+    pvChild = SymTable_childFrom(psNode, uByte + 1, &uByte)) {
+        SymTable_mapChild(pvChild, pfApply, pvExtra);
+    }
+}
+
+void SymTable_map(SymTable_T oSymTable,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if(oSymTable->pvRoot != NULL) {
+        SymTable_mapChild(oSymTable->pvRoot, pfApply, pvExtra);
+    }
+
+    return;
+}
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->uPosition = 0;
+    psIter->pvNext = oSymTable->pvRoot == NULL ? NULL
+    : SymTable_minimum(oSymTable->pvRoot);
+}
+
+int SymTable_iterNext(struct SymTableIter *psIter, const char **ppcKey,
+void **ppvValue) {
+    struct Leaf *psLeaf;
+
+    assert(psIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    /* the cursor holds no stack, so the next leaf is found from the
+    root by key, in time bounded by the key's length */
+    psLeaf = (struct Leaf *)psIter->pvNext;
+    if(psLeaf == NULL) {
+        return 0;
+    }
+    *ppcKey = psLeaf->acKey;
+    *ppvValue = psLeaf->pvValue;
+    psIter->pvNext = SymTable_successor(psIter->oSymTable->pvRoot,
+    psLeaf->acKey, 0);
+    return 1;
+}
+
+void SymTable_iterEnd(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+
+    psIter->pvNext = NULL;
+}
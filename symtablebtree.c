@@ -0,0 +1,871 @@
+/*--------------------------------------------------------------------*/
+/* symtablebtree.c                                                    */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtablebtree.h"
+
+/* most keys a node holds */
+enum {NODE_KEYS = 32};
+
+/* fewest keys a node other than the root holds. Two nodes this small
+fit into one node when they merge, with the key between them. */
+enum {MIN_KEYS = NODE_KEYS / 2 - 1};
+
+/* number of leading key bytes kept in a node next to each key */
+enum {PREFIX_BYTES = 8};
+
+/* Every node starts with a Node: its keys in strcmp order, and next to
+each key its first PREFIX_BYTES bytes packed into an integer, so a
+search within a node compares integers from a few cache lines and
+only follows a key pointer when two prefixes are equal. */
+struct Node
+{
+    /* 1 (TRUE) if the node is a Leaf, 0 (FALSE) if it is an Inner */
+    int iLeaf;
+
+    /* number of keys in the node */
+    size_t keys;
+
+    /* prefix of each key */
+    uint64_t auPrefixes[NODE_KEYS];
+
+    /* the keys */
+    char *apcKeys[NODE_KEYS];
+};
+
+/* A Leaf holds bindings. Its keys are copies that the table owns.
+Leaves are linked in key order, so a scan moves from leaf to leaf
+without climbing the tree. */
+struct Leaf
+{
+    struct Node sNode;
+
+    /* value of each key */
+    void *apvValues[NODE_KEYS];
+
+    /* leaf with the next larger keys, or NULL */
+    struct Leaf *psNextLeaf;
+};
+
+/* An Inner node holds separators. Child i holds the keys not less
+than key i - 1 and less than key i. A separator points at a key of
+some leaf, the smallest key of the subtree to its right, and owns no
+memory of its own. */
+struct Inner
+{
+    struct Node sNode;
+
+    /* the children, keys + 1 of them */
+    struct Node *apsChildren[NODE_KEYS + 1];
+};
+
+/* SymTable is a B+-tree whose leaves hold the bindings. */
+struct SymTable
+{
+   /* root node, a Leaf while the table has few bindings */
+   struct Node *psRoot;
+
+   /* leaf with the smallest keys. Splits keep the left half in the
+   old leaf and merges free the right leaf, so it never changes. */
+   struct Leaf *psFirstLeaf;
+
+   /* number of bindings */
+   size_t bindings;
+};
+
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+    struct Leaf *psLeaf;
+
+    /* Allocates memory for oSymTable and an empty root leaf */
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if(oSymTable == NULL) {
+        return NULL;
+    }
+    psLeaf = (struct Leaf *)malloc(sizeof(struct Leaf));
+    if(psLeaf == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    psLeaf->sNode.iLeaf = 1;
+    psLeaf->sNode.keys = 0;
+    psLeaf->psNextLeaf = NULL;
+
+    oSymTable->psRoot = &psLeaf->sNode;
+    oSymTable->psFirstLeaf = psLeaf;
+    oSymTable->bindings = 0;
+    return oSymTable;
+}
+
+/* Frees psNode and every node below it, and the keys of its leaves. */
+static void SymTable_freeNode(struct Node *psNode) {
+    struct Inner *psInner;
+    size_t u;
+
+    if(psNode->iLeaf) {
+        for(u = 0; u < psNode->keys; u++) {
+            free(psNode->apcKeys[u]);
+        }
+    }
+    else {
+        psInner = (struct Inner *)psNode;
+        for(u = 0; u <= psNode->keys; u++) {
+            SymTable_freeNode(psInner->apsChildren[u]);
+        }
+    }
+    free(psNode);
+}
+
+void SymTable_free(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    SymTable_freeNode(oSymTable->psRoot);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->bindings;
+}
+
+/* Returns the first PREFIX_BYTES bytes of pcKey, padded with '\0'
+bytes, as an integer whose order is the strcmp order of the bytes. */
+static uint64_t SymTable_prefix(const char *pcKey) {
+    uint64_t uPrefix = 0;
+    size_t u;
+
+    for(u = 0; u < PREFIX_BYTES && pcKey[u] != '\0'; u++) {
+        uPrefix |= (uint64_t)(unsigned char)pcKey[u]
+        << (8 * (PREFIX_BYTES - 1 - u));
+    }
+    return uPrefix;
+}
+
+/* Compares pcKey, whose prefix is uPrefix, with key uIndex of psNode.
+Returns a negative number, 0, or a positive number as pcKey is less
+than, equal to, or greater than that key in strcmp order. */
+static int SymTable_compare(uint64_t uPrefix, const char *pcKey,
+const struct Node *psNode, size_t uIndex) {
+    uint64_t uNodePrefix = psNode->auPrefixes[uIndex];
+
+    if(uPrefix != uNodePrefix) {
+        return uPrefix < uNodePrefix ? -1 : 1;
+    }
+
+    /* equal prefixes with a '\0' byte in them are equal keys */
+    if((uPrefix & 0xFF) == 0) {
+        return 0;
+    }
+    return strcmp(pcKey + PREFIX_BYTES,
+    psNode->apcKeys[uIndex] + PREFIX_BYTES);
+}
+
+/* Returns the index of the first key of psNode that is not less than
+pcKey, whose prefix is uPrefix, or the number of keys if there is
+none. */
+static size_t SymTable_lowerIndex(const struct Node *psNode,
+uint64_t uPrefix, const char *pcKey) {
+    size_t uLow = 0;
+    size_t uHigh = psNode->keys;
+    size_t uMiddle;
+
+    while(uLow < uHigh) {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if(SymTable_compare(uPrefix, pcKey, psNode, uMiddle) > 0) {
+            uLow = uMiddle + 1;
+        }
+        else {
+            uHigh = uMiddle;
+        }
+    }
+    return uLow;
+}
+
+/* Returns the index of the child of psInner whose keys include
+pcKey, whose prefix is uPrefix: the number of separators not greater
+than pcKey. */
+static size_t SymTable_childIndex(const struct Inner *psInner,
+uint64_t uPrefix, const char *pcKey) {
+    size_t uIndex;
+
+    uIndex = SymTable_lowerIndex(&psInner->sNode, uPrefix, pcKey);
+    if(uIndex < psInner->sNode.keys
+    && SymTable_compare(uPrefix, pcKey, &psInner->sNode, uIndex) == 0) {
+        uIndex++;
+    }
+    return uIndex;
+}
+
+/* Returns the leaf of oSymTable whose keys include pcKey, whose prefix
+is uPrefix. */
+static struct Leaf *SymTable_findLeaf(SymTable_T oSymTable,
+uint64_t uPrefix, const char *pcKey) {
+    struct Node *psNode = oSymTable->psRoot;
+    struct Inner *psInner;
+
+    while(!psNode->iLeaf) {
+        psInner = (struct Inner *)psNode;
+        psNode = psInner->apsChildren[SymTable_childIndex(psInner,
+        uPrefix, pcKey)];
+    }
+    return (struct Leaf *)psNode;
+}
+
+/* Returns the address of the value of pcKey in oSymTable, or NULL if
+oSymTable does not contain pcKey. */
+static void **SymTable_findValue(SymTable_T oSymTable,
+const char *pcKey) {
+    uint64_t uPrefix = SymTable_prefix(pcKey);
+    struct Leaf *psLeaf;
+    size_t uIndex;
+
+    psLeaf = SymTable_findLeaf(oSymTable, uPrefix, pcKey);
+    uIndex = SymTable_lowerIndex(&psLeaf->sNode, uPrefix, pcKey);
+    if(uIndex < psLeaf->sNode.keys
+    && SymTable_compare(uPrefix, pcKey, &psLeaf->sNode, uIndex) == 0) {
+        return &psLeaf->apvValues[uIndex];
+    }
+    return NULL;
+}
+
+/* Inserts key pcKey with prefix uPrefix into psInner at index uIndex,
+with psChild as the child to its right. psInner cannot be full. */
+static void SymTable_insertSeparator(struct Inner *psInner,
+size_t uIndex, char *pcKey, uint64_t uPrefix, struct Node *psChild) {
+    struct Node *psNode = &psInner->sNode;
+    size_t uMoved = psNode->keys - uIndex;
+
+    memmove(&psNode->auPrefixes[uIndex + 1],
+    &psNode->auPrefixes[uIndex],
+    uMoved * sizeof(uint64_t));
+    memmove(&psNode->apcKeys[uIndex + 1], &psNode->apcKeys[uIndex],
+    uMoved * sizeof(char *));
+    memmove(&psInner->apsChildren[uIndex + 2],
+    &psInner->apsChildren[uIndex + 1], uMoved * sizeof(struct Node *));
+    psNode->auPrefixes[uIndex] = uPrefix;
+    psNode->apcKeys[uIndex] = pcKey;
+    psInner->apsChildren[uIndex + 1] = psChild;
+    (psNode->keys)++;
+}
+
+/* Removes key uIndex of psInner and the child to its right. */
+static void SymTable_removeSeparator(struct Inner *psInner,
+size_t uIndex) {
+    struct Node *psNode = &psInner->sNode;
+    size_t uMoved = psNode->keys - uIndex - 1;
+
+    memmove(&psNode->auPrefixes[uIndex],
+    &psNode->auPrefixes[uIndex + 1],
+    uMoved * sizeof(uint64_t));
+    memmove(&psNode->apcKeys[uIndex], &psNode->apcKeys[uIndex + 1],
+    uMoved * sizeof(char *));
+    memmove(&psInner->apsChildren[uIndex + 1],
+    &psInner->apsChildren[uIndex + 2], uMoved * sizeof(struct Node *));
+    (psNode->keys)--;
+}
+
+/* Splits the full child uIndex of psParent in two and puts the
+separator between the halves into psParent, which cannot be full.
+Returns 1 (TRUE) if successful and 0 (FALSE) if there is insufficient
+memory, leaving the tree unchanged. */
+static int SymTable_splitChild(struct Inner *psParent, size_t uIndex) {
+    struct Node *psChild = psParent->apsChildren[uIndex];
+    struct Leaf *psLeft;
+    struct Leaf *psRight;
+    struct Inner *psLeftInner;
+    struct Inner *psRightInner;
+    size_t uMiddle = NODE_KEYS / 2;
+
+    assert(psChild->keys == NODE_KEYS);
+
+    if(psChild->iLeaf) {
+        /* the right half starts with key uMiddle, which also becomes
+        the separator */
+        psLeft = (struct Leaf *)psChild;
+        psRight = (struct Leaf *)malloc(sizeof(struct Leaf));
+        if(psRight == NULL) {
+            return 0;
+        }
+        psRight->sNode.iLeaf = 1;
+        psRight->sNode.keys = NODE_KEYS - uMiddle;
+        memcpy(psRight->sNode.auPrefixes, &psChild->auPrefixes[uMiddle],
+        (NODE_KEYS - uMiddle) * sizeof(uint64_t));
+        memcpy(psRight->sNode.apcKeys, &psChild->apcKeys[uMiddle],
+        (NODE_KEYS - uMiddle) * sizeof(char *));
+        memcpy(psRight->apvValues, &psLeft->apvValues[uMiddle],
+        (NODE_KEYS - uMiddle) * sizeof(void *));
+        psRight->psNextLeaf = psLeft->psNextLeaf;
+        psLeft->psNextLeaf = psRight;
+        psChild->keys = uMiddle;
+        SymTable_insertSeparator(psParent, uIndex,
+        psRight->sNode.apcKeys[0], psRight->sNode.auPrefixes[0],
+        &psRight->sNode);
+        return 1;
+    }
+
+    /* key uMiddle moves up into psParent, and the keys and children
+    after it move to the right half */
+    psLeftInner = (struct Inner *)psChild;
+    psRightInner = (struct Inner *)malloc(sizeof(struct Inner));
+    if(psRightInner == NULL) {
+        return 0;
+    }
+    psRightInner->sNode.iLeaf = 0;
+    psRightInner->sNode.keys = NODE_KEYS - uMiddle - 1;
+    memcpy(psRightInner->sNode.auPrefixes,
+    &psChild->auPrefixes[uMiddle + 1],
+    (NODE_KEYS - uMiddle - 1) * sizeof(uint64_t));
+    memcpy(psRightInner->sNode.apcKeys, &psChild->apcKeys[uMiddle + 1],
+    (NODE_KEYS - uMiddle - 1) * sizeof(char *));
+    memcpy(psRightInner->apsChildren,
+    &psLeftInner->apsChildren[uMiddle + 1],
+    (NODE_KEYS - uMiddle) * sizeof(struct Node *));
+    psChild->keys = uMiddle;
+    SymTable_insertSeparator(psParent, uIndex,
+    psChild->apcKeys[uMiddle], psChild->auPrefixes[uMiddle],
+    &psRightInner->sNode);
+    return 1;
+}
+
+/* Returns the leaf of oSymTable whose keys include pcKey, whose prefix
+is uPrefix, after splitting every full node on the way down to it, so
+that the leaf has room for one more key. Returns NULL if there is
+insufficient memory for a split; the tree is still valid then. */
+static struct Leaf *SymTable_findLeafForInsert(SymTable_T oSymTable,
+uint64_t uPrefix, const char *pcKey) {
+    struct Inner *psInner;
+    struct Node *psNode;
+    size_t uIndex;
+
+    /* a full root gets a new root above it, growing the tree by one
+    level */
+    if(oSymTable->psRoot->keys == NODE_KEYS) {
+        psInner = (struct Inner *)malloc(sizeof(struct Inner));
+        if(psInner == NULL) {
+            return NULL;
+        }
+        psInner->sNode.iLeaf = 0;
+        psInner->sNode.keys = 0;
+        psInner->apsChildren[0] = oSymTable->psRoot;
+        if(!SymTable_splitChild(psInner, 0)) {
+            free(psInner);
+            return NULL;
+        }
+        oSymTable->psRoot = &psInner->sNode;
+    }
+
+    psNode = oSymTable->psRoot;
+    while(!psNode->iLeaf) {
+        psInner = (struct Inner *)psNode;
+        uIndex = SymTable_childIndex(psInner, uPrefix, pcKey);
+        if(psInner->apsChildren[uIndex]->keys == NODE_KEYS) {
+            if(!SymTable_splitChild(psInner, uIndex)) {
+                return NULL;
+            }
+            if(SymTable_compare(uPrefix, pcKey, psNode, uIndex) >= 0) {
+                uIndex++;
+            }
+        }
+        psNode = psInner->apsChildren[uIndex];
+    }
+    return (struct Leaf *)psNode;
+}
+
+/* Returns the address of the value of the pair with pcKey in
+oSymTable, first putting a pcKey/NULL pair into it if there is none.
+Sets *piInserted to 1 (TRUE) if the pair is new and to 0 (FALSE) if
+not. Returns NULL if there is insufficient memory. */
+static void **SymTable_findOrInsertKey(SymTable_T oSymTable,
+const char *pcKey, int *piInserted) {
+    uint64_t uPrefix = SymTable_prefix(pcKey);
+    struct Leaf *psLeaf;
+    struct Node *psNode;
+    size_t uIndex;
+    size_t uMoved;
+    char *pcCopy;
+
+    *piInserted = 0;
+    psLeaf = SymTable_findLeafForInsert(oSymTable, uPrefix, pcKey);
+    if(psLeaf == NULL) {
+        /* the pair may exist even if there is no memory for a split */
+        return SymTable_findValue(oSymTable, pcKey);
+    }
+
+    psNode = &psLeaf->sNode;
+    uIndex = SymTable_lowerIndex(psNode, uPrefix, pcKey);
+    if(uIndex < psNode->keys
+    && SymTable_compare(uPrefix, pcKey, psNode, uIndex) == 0) {
+        return &psLeaf->apvValues[uIndex];
+    }
+
+    /* allocates memory for the copy of the key */
+    pcCopy = (char *)malloc(strlen(pcKey) + 1);
+    if(pcCopy == NULL) {
+        return NULL;
+    }
+    strcpy(pcCopy, pcKey);
+
+    uMoved = psNode->keys - uIndex;
+    memmove(&psNode->auPrefixes[uIndex + 1],
+    &psNode->auPrefixes[uIndex],
+    uMoved * sizeof(uint64_t));
+    memmove(&psNode->apcKeys[uIndex + 1], &psNode->apcKeys[uIndex],
+    uMoved * sizeof(char *));
+    memmove(&psLeaf->apvValues[uIndex + 1], &psLeaf->apvValues[uIndex],
+    uMoved * sizeof(void *));
+    psNode->auPrefixes[uIndex] = uPrefix;
+    psNode->apcKeys[uIndex] = pcCopy;
+    psLeaf->apvValues[uIndex] = NULL;
+    (psNode->keys)++;
+    (oSymTable->bindings)++;
+
+    *piInserted = 1;
+    return &psLeaf->apvValues[uIndex];
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findOrInsertKey(oSymTable, pcKey, &iInserted);
+    if(ppvValue == NULL || !iInserted) {
+        return 0;
+    }
+    *ppvValue = (void *) pvValue;
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+    void *pvTempValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findValue(oSymTable, pcKey);
+    if(ppvValue == NULL) {
+        return NULL;
+    }
+    pvTempValue = *ppvValue;
+    *ppvValue = (void *) pvValue;
+    return pvTempValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_findValue(oSymTable, pcKey) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    void **ppvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findValue(oSymTable, pcKey);
+    return ppvValue == NULL ? NULL : *ppvValue;
+}
+
+/* Moves the last key of the child left of uIndex in psParent to the
+front of child uIndex, through the separator between them. */
+static void SymTable_borrowLeft(struct Inner *psParent, size_t uIndex) {
+    struct Node *psLeft = psParent->apsChildren[uIndex - 1];
+    struct Node *psChild = psParent->apsChildren[uIndex];
+    struct Node *psSeparators = &psParent->sNode;
+    size_t uLast = psLeft->keys - 1;
+
+    memmove(&psChild->auPrefixes[1], &psChild->auPrefixes[0],
+    psChild->keys * sizeof(uint64_t));
+    memmove(&psChild->apcKeys[1], &psChild->apcKeys[0],
+    psChild->keys * sizeof(char *));
+
+    if(psChild->iLeaf) {
+        /* the moved key becomes the smallest of the child, and so its
+        separator */
+        memmove(&((struct Leaf *)psChild)->apvValues[1],
+        &((struct Leaf *)psChild)->apvValues[0],
+        psChild->keys * sizeof(void *));
+        psChild->auPrefixes[0] = psLeft->auPrefixes[uLast];
+        psChild->apcKeys[0] = psLeft->apcKeys[uLast];
+        ((struct Leaf *)psChild)->apvValues[0] =
+        ((struct Leaf *)psLeft)->apvValues[uLast];
+        psSeparators->auPrefixes[uIndex - 1] = psChild->auPrefixes[0];
+        psSeparators->apcKeys[uIndex - 1] = psChild->apcKeys[0];
+    }
+    else {
+        /* the separator comes down, and the last key of the left
+        child goes up in its place */
+        memmove(&((struct Inner *)psChild)->apsChildren[1],
+        &((struct Inner *)psChild)->apsChildren[0],
+        (psChild->keys + 1) * sizeof(struct Node *));
+        psChild->auPrefixes[0] = psSeparators->auPrefixes[uIndex - 1];
+        psChild->apcKeys[0] = psSeparators->apcKeys[uIndex - 1];
+        ((struct Inner *)psChild)->apsChildren[0] =
+        ((struct Inner *)psLeft)->apsChildren[uLast + 1];
+        psSeparators->auPrefixes[uIndex - 1] =
+        psLeft->auPrefixes[uLast];
+        psSeparators->apcKeys[uIndex - 1] = psLeft->apcKeys[uLast];
+    }
+
+    (psChild->keys)++;
+    (psLeft->keys)--;
+}
+
+/* Moves the first key of the child right of uIndex in psParent to the
+end of child uIndex, through the separator between them. */
+static void SymTable_borrowRight(struct Inner *psParent,
+size_t uIndex) {
+    struct Node *psChild = psParent->apsChildren[uIndex];
+    struct Node *psRight = psParent->apsChildren[uIndex + 1];
+    struct Node *psSeparators = &psParent->sNode;
+    size_t uEnd = psChild->keys;
+
+    if(psChild->iLeaf) {
+        psChild->auPrefixes[uEnd] = psRight->auPrefixes[0];
+        psChild->apcKeys[uEnd] = psRight->apcKeys[0];
+        ((struct Leaf *)psChild)->apvValues[uEnd] =
+        ((struct Leaf *)psRight)->apvValues[0];
+        memmove(&((struct Leaf *)psRight)->apvValues[0],
+        &((struct Leaf *)psRight)->apvValues[1],
+        (psRight->keys - 1) * sizeof(void *));
+    }
+    else {
+        psChild->auPrefixes[uEnd] = psSeparators->auPrefixes[uIndex];
+        psChild->apcKeys[uEnd] = psSeparators->apcKeys[uIndex];
+        ((struct Inner *)psChild)->apsChildren[uEnd + 1] =
+        ((struct Inner *)psRight)->apsChildren[0];
+        psSeparators->auPrefixes[uIndex] = psRight->auPrefixes[0];
+        psSeparators->apcKeys[uIndex] = psRight->apcKeys[0];
+        memmove(&((struct Inner *)psRight)->apsChildren[0],
+        &((struct Inner *)psRight)->apsChildren[1],
+        psRight->keys * sizeof(struct Node *));
+    }
+    memmove(&psRight->auPrefixes[0], &psRight->auPrefixes[1],
+    (psRight->keys - 1) * sizeof(uint64_t));
+    memmove(&psRight->apcKeys[0], &psRight->apcKeys[1],
+    (psRight->keys - 1) * sizeof(char *));
+    (psRight->keys)--;
+    (psChild->keys)++;
+
+    /* a leaf's separator is the new smallest key of the right leaf */
+    if(psChild->iLeaf) {
+        psSeparators->auPrefixes[uIndex] = psRight->auPrefixes[0];
+        psSeparators->apcKeys[uIndex] = psRight->apcKeys[0];
+    }
+}
+
+/* Merges the child right of separator uIndex of psParent into the
+child left of it, and frees the right child. */
+static void SymTable_mergeChildren(struct Inner *psParent,
+size_t uIndex) {
+    struct Node *psLeft = psParent->apsChildren[uIndex];
+    struct Node *psRight = psParent->apsChildren[uIndex + 1];
+    size_t uEnd = psLeft->keys;
+
+    if(psLeft->iLeaf) {
+        memcpy(&((struct Leaf *)psLeft)->apvValues[uEnd],
+        ((struct Leaf *)psRight)->apvValues,
+        psRight->keys * sizeof(void *));
+        ((struct Leaf *)psLeft)->psNextLeaf =
+        ((struct Leaf *)psRight)->psNextLeaf;
+    }
+    else {
+        /* the separator comes down between the two halves */
+        psLeft->auPrefixes[uEnd] = psParent->sNode.auPrefixes[uIndex];
+        psLeft->apcKeys[uEnd] = psParent->sNode.apcKeys[uIndex];
+        uEnd++;
+        memcpy(&((struct Inner *)psLeft)->apsChildren[uEnd],
+        ((struct Inner *)psRight)->apsChildren,
+        (psRight->keys + 1) * sizeof(struct Node *));
+    }
+    memcpy(&psLeft->auPrefixes[uEnd], psRight->auPrefixes,
+    psRight->keys * sizeof(uint64_t));
+    memcpy(&psLeft->apcKeys[uEnd], psRight->apcKeys,
+    psRight->keys * sizeof(char *));
+    psLeft->keys = uEnd + psRight->keys;
+
+    SymTable_removeSeparator(psParent, uIndex);
+    free(psRight);
+}
+
+/* Gives child uIndex of psParent, which has MIN_KEYS keys, at least
+one more, by borrowing a key from a sibling or merging with one.
+Returns the index of the child that now holds its keys. */
+static size_t SymTable_fixChild(struct Inner *psParent, size_t uIndex) {
+    if(uIndex > 0
+    && psParent->apsChildren[uIndex - 1]->keys > MIN_KEYS) {
+        SymTable_borrowLeft(psParent, uIndex);
+        return uIndex;
+    }
+    if(uIndex < psParent->sNode.keys
+    && psParent->apsChildren[uIndex + 1]->keys > MIN_KEYS) {
+        SymTable_borrowRight(psParent, uIndex);
+        return uIndex;
+    }
+    if(uIndex < psParent->sNode.keys) {
+        SymTable_mergeChildren(psParent, uIndex);
+        return uIndex;
+    }
+    SymTable_mergeChildren(psParent, uIndex - 1);
+    return uIndex - 1;
+}
+
+/* Points the separator of oSymTable that points at pcOldKey, if any,
+at pcNewKey, the next larger key of the table. */
+static void SymTable_replaceSeparator(SymTable_T oSymTable,
+const char *pcOldKey, char *pcNewKey) {
+    uint64_t uPrefix = SymTable_prefix(pcOldKey);
+    struct Node *psNode = oSymTable->psRoot;
+    size_t uIndex;
+
+    while(!psNode->iLeaf) {
+        uIndex = SymTable_lowerIndex(psNode, uPrefix, pcOldKey);
+        if(uIndex < psNode->keys
+        && psNode->apcKeys[uIndex] == pcOldKey) {
+            psNode->auPrefixes[uIndex] = SymTable_prefix(pcNewKey);
+            psNode->apcKeys[uIndex] = pcNewKey;
+            return;
+        }
+        psNode = ((struct Inner *)psNode)->apsChildren[uIndex];
+    }
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    uint64_t uPrefix;
+    struct Node *psNode;
+    struct Node *psChild;
+    struct Inner *psInner;
+    struct Leaf *psLeaf;
+    size_t uIndex;
+    size_t uMoved;
+    char *pcOldKey;
+    void *pvTempValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* on the way down, every node below the root gets more than
+    MIN_KEYS keys, so that the leaf can lose one */
+    uPrefix = SymTable_prefix(pcKey);
+    psNode = oSymTable->psRoot;
+    while(!psNode->iLeaf) {
+        psInner = (struct Inner *)psNode;
+        uIndex = SymTable_childIndex(psInner, uPrefix, pcKey);
+        if(psInner->apsChildren[uIndex]->keys <= MIN_KEYS) {
+            uIndex = SymTable_fixChild(psInner, uIndex);
+        }
+        psChild = psInner->apsChildren[uIndex];
+
+        /* a root left with one child gives way to it */
+        if(psNode == oSymTable->psRoot && psNode->keys == 0) {
+            oSymTable->psRoot = psChild;
+            free(psNode);
+        }
+        psNode = psChild;
+    }
+
+    psLeaf = (struct Leaf *)psNode;
+    uIndex = SymTable_lowerIndex(psNode, uPrefix, pcKey);
+    if(uIndex == psNode->keys
+    || SymTable_compare(uPrefix, pcKey, psNode, uIndex) != 0) {
+        return NULL;
+    }
+
+    pcOldKey = psNode->apcKeys[uIndex];
+    pvTempValue = psLeaf->apvValues[uIndex];
+    uMoved = psNode->keys - uIndex - 1;
+    memmove(&psNode->auPrefixes[uIndex],
+    &psNode->auPrefixes[uIndex + 1],
+    uMoved * sizeof(uint64_t));
+    memmove(&psNode->apcKeys[uIndex], &psNode->apcKeys[uIndex + 1],
+    uMoved * sizeof(char *));
+    memmove(&psLeaf->apvValues[uIndex], &psLeaf->apvValues[uIndex + 1],
+    uMoved * sizeof(void *));
+    (psNode->keys)--;
+    (oSymTable->bindings)--;
+
+    /* only the smallest key of a leaf other than the root can be a
+    separator, and that leaf keeps a key to take its place */
+    if(uIndex == 0 && psNode != oSymTable->psRoot) {
+        SymTable_replaceSeparator(oSymTable, pcOldKey,
+        psNode->apcKeys[0]);
+    }
+    free(pcOldKey);
+    return pvTempValue;
+}
+
+void **SymTable_findOrInsert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted) {
+    void **ppvValue;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findOrInsertKey(oSymTable, pcKey, &iInserted);
+    if(ppvValue != NULL && piInserted != NULL) {
+        *piInserted = iInserted;
+    }
+    return ppvValue;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findOrInsertKey(oSymTable, pcKey, &iInserted);
+    if(ppvValue == NULL) {
+        return 0;
+    }
+    *ppvValue = (void *) pvValue;
+    return 1;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    struct Leaf *psLeaf;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* applies pfApply to each binding, leaf by leaf in key order */
+    for(psLeaf = oSymTable->psFirstLeaf; psLeaf != NULL;
+    psLeaf = psLeaf->psNextLeaf) {
+        for(u = 0; u < psLeaf->sNode.keys; u++) {
+            (*pfApply)(psLeaf->sNode.apcKeys[u], psLeaf->apvValues[u],
+            (void *) pvExtra);
+        }
+    }
+
+    return;
+}
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->uPosition = 0;
+    psIter->pvNext = oSymTable->psFirstLeaf;
+}
+
+int SymTable_iterNext(struct SymTableIter *psIter, const char **ppcKey,
+void **ppvValue) {
+    struct Leaf *psLeaf;
+
+    assert(psIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    /* pvNext is the current leaf and uPosition the index of the next
+    key in it */
+    psLeaf = (struct Leaf *)psIter->pvNext;
+    while(psLeaf != NULL && psIter->uPosition >= psLeaf->sNode.keys) {
+        psLeaf = psLeaf->psNextLeaf;
+        psIter->uPosition = 0;
+    }
+    psIter->pvNext = psLeaf;
+    if(psLeaf == NULL) {
+        return 0;
+    }
+
+    *ppcKey = psLeaf->sNode.apcKeys[psIter->uPosition];
+    *ppvValue = psLeaf->apvValues[psIter->uPosition];
+    (psIter->uPosition)++;
+    return 1;
+}
+
+void SymTable_iterEnd(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+
+    psIter->pvNext = NULL;
+}
+
+void SymTable_lowerBound(SymTable_T oSymTable, const char *pcKey,
+struct SymTableIter *psIter) {
+    uint64_t uPrefix;
+    struct Leaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(psIter != NULL);
+
+    /* the first such key is in the leaf that pcKey would go in, or is
+    the first key of the next leaf */
+    uPrefix = SymTable_prefix(pcKey);
+    psLeaf = SymTable_findLeaf(oSymTable, uPrefix, pcKey);
+    psIter->oSymTable = oSymTable;
+    psIter->uPosition =
+    SymTable_lowerIndex(&psLeaf->sNode, uPrefix, pcKey);
+    psIter->pvNext = psLeaf;
+}
+
+size_t SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+const char *pcHigh,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    struct SymTableIter sIter;
+    const char *pcKey;
+    void *pvValue;
+    size_t uCount = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcLow != NULL);
+    assert(pfApply != NULL);
+
+    SymTable_lowerBound(oSymTable, pcLow, &sIter);
+    while(SymTable_iterNext(&sIter, &pcKey, &pvValue)) {
+        if(pcHigh != NULL && strcmp(pcKey, pcHigh) >= 0) {
+            break;
+        }
+        (*pfApply)(pcKey, pvValue, (void *) pvExtra);
+        uCount++;
+    }
+    return uCount;
+}
+
+size_t SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    struct SymTableIter sIter;
+    const char *pcKey;
+    void *pvValue;
+    size_t uLength;
+    size_t uCount = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    /* the keys with the prefix are the ones from the prefix itself up
+    to the first key without it */
+    uLength = strlen(pcPrefix);
+    SymTable_lowerBound(oSymTable, pcPrefix, &sIter);
+    while(SymTable_iterNext(&sIter, &pcKey, &pvValue)) {
+        if(strncmp(pcKey, pcPrefix, uLength) != 0) {
+            break;
+        }
+        (*pfApply)(pcKey, pvValue, (void *) pvExtra);
+        uCount++;
+    }
+    return uCount;
+}
@@ -0,0 +1,42 @@
+/*--------------------------------------------------------------------*/
+/* symtablebtree.h                                                    */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEBTREE_INCLUDED
+#define SYMTABLEBTREE_INCLUDED
+
+#include "symtable.h"
+
+/* Functions that only the B+-tree implementation of the SymTable ADT
+(symtablebtree.c) provides. That implementation keeps its keys in
+strcmp order, so its cursors and SymTable_map visit the pairs in
+ascending order of their keys, and the functions below find a range of
+keys without looking at the rest of the table. */
+
+/* Starts *psIter at the first pair of oSymTable whose key is not less
+than pcKey in strcmp order, so that SymTable_iterNext returns that
+pair and every later one in order. The cursor follows the rules of
+SymTable_iterBegin. oSymTable, pcKey, and psIter cannot be NULL. */
+void SymTable_lowerBound(SymTable_T oSymTable, const char *pcKey,
+struct SymTableIter *psIter);
+
+/* Applies function *pfApply to each pair of oSymTable whose key is
+not less than pcLow and, unless pcHigh is NULL, less than pcHigh, in
+ascending order of their keys, and passes pvExtra as an extra
+parameter. Returns the number of pairs. oSymTable, pcLow, and pfApply
+cannot be NULL. */
+size_t SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+const char *pcHigh,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra);
+
+/* Applies function *pfApply to each pair of oSymTable whose key
+starts with pcPrefix, in ascending order of their keys, and passes
+pvExtra as an extra parameter. Returns the number of pairs. oSymTable,
+pcPrefix, and pfApply cannot be NULL. */
+size_t SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra);
+
+#endif
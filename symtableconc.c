@@ -0,0 +1,863 @@
+/*--------------------------------------------------------------------*/
+/* symtableconc.c                                                     */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+/* pthread_rwlock_t and posix_memalign are POSIX.1-2001 */
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtableconc.h"
+
+/* number of locks of a table. Lock i guards every bucket whose index
+is congruent to i modulo LOCK_STRIPES. Must be a power of two. */
+enum {LOCK_STRIPES = 64};
+
+/* number of buckets of a new table. Bucket counts are powers of two
+and never fewer than LOCK_STRIPES, so the low bits of a hash code that
+pick a key's bucket also pick its lock, whatever the bucket count. */
+enum {INITIAL_BUCKETS = 512};
+
+/* size of a cache line in bytes, assumed for padding */
+enum {CACHE_LINE = 64};
+
+/* number of bindings a stripe retires before it tries to advance the
+epoch and free the ones no reader can still reach */
+enum {RECLAIM_THRESHOLD = 64};
+
+/* number of lists of retired bindings per stripe, one for each epoch
+that may still have readers, and one more being filled */
+enum {LIMBO_LISTS = 3};
+
+/* multiplier of the hash function */
+#define HASH_MULTIPLIER 65599
+
+/* Loads and stores of the words that lock-free readers share with
+writers. Compilers without the builtins get plain accesses, and their
+tables from SymTableConc_newLockFreeReads lock their reads instead. */
+#if defined(__GNUC__)
+#define SYMTABLECONC_ATOMICS 1
+#define SymTableConc_load(pv) __atomic_load_n(pv, __ATOMIC_ACQUIRE)
+#define SymTableConc_store(pv, v) \
+    __atomic_store_n(pv, v, __ATOMIC_RELEASE)
+#define SymTableConc_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define SYMTABLECONC_ATOMICS 0
+#define SymTableConc_load(pv) (*(pv))
+#define SymTableConc_store(pv, v) ((void)(*(pv) = (v)))
+#define SymTableConc_fence() ((void)0)
+#endif
+
+/* Each key/value pair is stored in a Binding. Bindings are each found
+in a linked list beginning at a bucket in the hash table. */
+struct Binding
+{
+    /* value */
+    void *pvValue;
+    /* full hash code of acKey, so that resizing never rehashes a key
+    and lookups only compare keys whose hash codes match */
+    size_t uHash;
+
+    /* address of next binding */
+    struct Binding *psNextBinding;
+
+    /* address of next binding retired by the same stripe in the same
+    epoch. A retired binding keeps psNextBinding, so a lock-free reader
+    standing on it can still finish walking its chain. */
+    struct Binding *psNextRetired;
+
+    /* the key, allocated along with the binding */
+    char acKey[1];
+};
+
+/* A BucketArray is a hash table, allocated along with its bucket
+count so that a lock-free reader loads both with one pointer. */
+struct BucketArray
+{
+    /* number of buckets */
+    size_t bucketCount;
+
+    /* epoch in which the array was replaced by a larger one */
+    size_t uRetireEpoch;
+
+    /* address of next retired array */
+    struct BucketArray *psNextRetired;
+
+    /* the buckets */
+    struct Binding *apsBuckets[1];
+};
+
+/* A Stripe is one lock of a table, the number of bindings in the
+buckets it guards, and the bindings it has removed that lock-free
+readers may still be reading. All of them only change while it is
+write-locked. */
+struct Stripe
+{
+    pthread_rwlock_t sLock;
+    size_t bindings;
+
+    /* retired bindings, by epoch modulo LIMBO_LISTS */
+    struct Binding *apsLimbo[LIMBO_LISTS];
+
+    /* epoch of the bindings in each of apsLimbo */
+    size_t auLimboEpoch[LIMBO_LISTS];
+
+    /* number of bindings in apsLimbo */
+    size_t retired;
+};
+
+/* Each stripe fills whole cache lines of its own, so that threads
+taking neighbouring locks do not contend for the same line. */
+union PaddedStripe
+{
+    struct Stripe sStripe;
+    char acPad[CACHE_LINE
+    * ((sizeof(struct Stripe) + CACHE_LINE - 1) / CACHE_LINE)];
+};
+
+/* A Reader is the announcement of one thread reading a table without
+locks. A thread writes only its own Reader, which fills a cache line,
+so readers never write to a line another thread reads often. */
+struct Reader
+{
+    /* (epoch << 1) | 1 while the thread reads, 0 otherwise */
+    size_t uState;
+
+    /* 1 (TRUE) while a thread owns the Reader, 0 (FALSE) after the
+    thread exits and before another thread takes it over */
+    int iInUse;
+
+    /* address of next Reader of the table */
+    struct Reader *psNextReader;
+};
+
+union PaddedReader
+{
+    struct Reader sReader;
+    char acPad[CACHE_LINE
+    * ((sizeof(struct Reader) + CACHE_LINE - 1) / CACHE_LINE)];
+};
+
+/* SymTableConc is a hash table of bindings and the stripes that guard
+it. psBuckets only changes while every stripe is write-locked, so
+holding any one stripe is enough to read it. In a table with lock-free
+reads, readers that hold no stripe announce the epoch they start in
+instead, and memory they might reach is only freed two epochs after
+it was unlinked. */
+struct SymTableConc
+{
+    /* the locks, in the order they are taken when all are needed */
+    union PaddedStripe auStripes[LOCK_STRIPES];
+
+    /* the hash table */
+    struct BucketArray *psBuckets;
+
+    /* 1 (TRUE) if gets and contains take no lock, 0 (FALSE) if not */
+    int iLockFreeReads;
+
+    /* current epoch. It advances once every reader has seen it. */
+    size_t uEpoch;
+
+    /* Readers of the threads that have read the table without locks,
+    newest first. Readers are never removed until the table is
+    freed. */
+    struct Reader *psReaders;
+
+    /* key under which each thread finds its Reader */
+    pthread_key_t sReaderKey;
+
+    /* guards registering Readers and psRetiredArrays */
+    pthread_mutex_t sMutex;
+
+    /* arrays replaced by SymTableConc_expand that readers may still be
+    reading, newest first, each with the bindings it held then */
+    struct BucketArray *psRetiredArrays;
+};
+
+/* Return a hash code for pcKey and store its length in *puLength. The
+65599 hash is mixed afterwards so that its low bits, which choose the
+bucket and the stripe, depend on every character. */
+static size_t SymTableConc_hash(const char *pcKey, size_t *puLength) {
+    size_t u;
+    uint64_t uHash = 0;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++) {
+        uHash = uHash * HASH_MULTIPLIER + (uint64_t)pcKey[u];
+    }
+    uHash ^= uHash >> 33;
+    uHash *= 0xFF51AFD7ED558CCDULL;
+    uHash ^= uHash >> 33;
+
+    *puLength = u;
+    return (size_t)uHash;
+}
+
+/* Returns the stripe of oSymTable that guards the bucket of a key with
+hash code uHash. */
+static struct Stripe *SymTableConc_stripe(SymTableConc_T oSymTable,
+size_t uHash) {
+    return &oSymTable->auStripes[uHash & (LOCK_STRIPES - 1)].sStripe;
+}
+
+/* Write-locks every stripe of oSymTable, in index order so that two
+threads doing so cannot deadlock. */
+static void SymTableConc_lockAll(SymTableConc_T oSymTable) {
+    size_t stripe;
+
+    for(stripe = 0; stripe < LOCK_STRIPES; stripe++) {
+        pthread_rwlock_wrlock(
+        &oSymTable->auStripes[stripe].sStripe.sLock);
+    }
+}
+
+/* Unlocks every stripe of oSymTable. */
+static void SymTableConc_unlockAll(SymTableConc_T oSymTable) {
+    size_t stripe;
+
+    for(stripe = 0; stripe < LOCK_STRIPES; stripe++) {
+        pthread_rwlock_unlock(
+        &oSymTable->auStripes[stripe].sStripe.sLock);
+    }
+}
+
+/* Returns a new bucket array of bucketCount empty buckets, or NULL if
+there is insufficient memory. */
+static struct BucketArray *SymTableConc_newBuckets(size_t bucketCount) {
+    struct BucketArray *psBuckets;
+
+    if(bucketCount > ((size_t)-1 - offsetof(struct BucketArray,
+    apsBuckets)) / sizeof(struct Binding*)) {
+        return NULL;
+    }
+    psBuckets = (struct BucketArray*)calloc(1,
+    offsetof(struct BucketArray, apsBuckets)
+    + bucketCount * sizeof(struct Binding*));
+    if(psBuckets == NULL) {
+        return NULL;
+    }
+    psBuckets->bucketCount = bucketCount;
+    return psBuckets;
+}
+
+/* Frees psBuckets and every binding in its buckets. */
+static void SymTableConc_freeBuckets(struct BucketArray *psBuckets) {
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    size_t bucket;
+
+    for(bucket = 0; bucket < psBuckets->bucketCount; bucket++) {
+        psCurrentBinding = psBuckets->apsBuckets[bucket];
+        while(psCurrentBinding != NULL) {
+            psNextBinding = psCurrentBinding->psNextBinding;
+            free(psCurrentBinding);
+            psCurrentBinding = psNextBinding;
+        }
+    }
+    free(psBuckets);
+}
+
+/* Marks the Reader pvReader free for another thread to take over. It
+is the destructor of the reader key, so it runs when a thread that has
+read the table exits. */
+static void SymTableConc_releaseReader(void *pvReader) {
+    SymTableConc_store(&((struct Reader*)pvReader)->iInUse, 0);
+}
+
+/* Returns a new table, with lock-free reads if iLockFreeReads is
+nonzero and the compiler provides atomic builtins, or NULL if
+insufficient memory or another resource is available. */
+static SymTableConc_T SymTableConc_create(int iLockFreeReads) {
+    SymTableConc_T oSymTable;
+    struct Stripe *psStripe;
+    void *pvTable;
+    size_t stripe;
+    size_t list;
+
+    /* aligns the stripes to cache lines */
+    if(posix_memalign(&pvTable, CACHE_LINE,
+    sizeof(struct SymTableConc)) != 0) {
+        return NULL;
+    }
+    oSymTable = (SymTableConc_T)pvTable;
+
+    oSymTable->psBuckets = SymTableConc_newBuckets(INITIAL_BUCKETS);
+    if(oSymTable->psBuckets == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    if(pthread_mutex_init(&oSymTable->sMutex, NULL) != 0) {
+        free(oSymTable->psBuckets);
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->iLockFreeReads = iLockFreeReads && SYMTABLECONC_ATOMICS;
+    if(oSymTable->iLockFreeReads
+    && pthread_key_create(&oSymTable->sReaderKey,
+    SymTableConc_releaseReader) != 0) {
+        pthread_mutex_destroy(&oSymTable->sMutex);
+        free(oSymTable->psBuckets);
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->uEpoch = 0;
+    oSymTable->psReaders = NULL;
+    oSymTable->psRetiredArrays = NULL;
+
+    for(stripe = 0; stripe < LOCK_STRIPES; stripe++) {
+        psStripe = &oSymTable->auStripes[stripe].sStripe;
+        if(pthread_rwlock_init(&psStripe->sLock, NULL) != 0) {
+            while(stripe > 0) {
+                stripe--;
+                pthread_rwlock_destroy(
+                &oSymTable->auStripes[stripe].sStripe.sLock);
+            }
+            if(oSymTable->iLockFreeReads) {
+                pthread_key_delete(oSymTable->sReaderKey);
+            }
+            pthread_mutex_destroy(&oSymTable->sMutex);
+            free(oSymTable->psBuckets);
+            free(oSymTable);
+            return NULL;
+        }
+        psStripe->bindings = 0;
+        for(list = 0; list < LIMBO_LISTS; list++) {
+            psStripe->apsLimbo[list] = NULL;
+            psStripe->auLimboEpoch[list] = 0;
+        }
+        psStripe->retired = 0;
+    }
+
+    return oSymTable;
+}
+
+SymTableConc_T SymTableConc_new(void) {
+    return SymTableConc_create(0);
+}
+
+SymTableConc_T SymTableConc_newLockFreeReads(void) {
+    return SymTableConc_create(1);
+}
+
+void SymTableConc_free(SymTableConc_T oSymTable) {
+    struct BucketArray *psNextArray;
+    struct Binding *psNextBinding;
+    struct Reader *psNextReader;
+    struct Stripe *psStripe;
+    size_t stripe;
+    size_t list;
+
+    assert(oSymTable != NULL);
+
+    for(stripe = 0; stripe < LOCK_STRIPES; stripe++) {
+        psStripe = &oSymTable->auStripes[stripe].sStripe;
+        for(list = 0; list < LIMBO_LISTS; list++) {
+            while(psStripe->apsLimbo[list] != NULL) {
+                psNextBinding = psStripe->apsLimbo[list]->psNextRetired;
+                free(psStripe->apsLimbo[list]);
+                psStripe->apsLimbo[list] = psNextBinding;
+            }
+        }
+        pthread_rwlock_destroy(&psStripe->sLock);
+    }
+    while(oSymTable->psRetiredArrays != NULL) {
+        psNextArray = oSymTable->psRetiredArrays->psNextRetired;
+        SymTableConc_freeBuckets(oSymTable->psRetiredArrays);
+        oSymTable->psRetiredArrays = psNextArray;
+    }
+    SymTableConc_freeBuckets(oSymTable->psBuckets);
+
+    if(oSymTable->iLockFreeReads) {
+        pthread_key_delete(oSymTable->sReaderKey);
+    }
+    while(oSymTable->psReaders != NULL) {
+        psNextReader = oSymTable->psReaders->psNextReader;
+        free(oSymTable->psReaders);
+        oSymTable->psReaders = psNextReader;
+    }
+    pthread_mutex_destroy(&oSymTable->sMutex);
+    free(oSymTable);
+}
+
+size_t SymTableConc_getLength(SymTableConc_T oSymTable) {
+    struct Stripe *psStripe;
+    size_t uLength = 0;
+    size_t stripe;
+
+    assert(oSymTable != NULL);
+
+    for(stripe = 0; stripe < LOCK_STRIPES; stripe++) {
+        psStripe = &oSymTable->auStripes[stripe].sStripe;
+        pthread_rwlock_rdlock(&psStripe->sLock);
+        uLength += psStripe->bindings;
+        pthread_rwlock_unlock(&psStripe->sLock);
+    }
+    return uLength;
+}
+
+/* Advances the epoch of oSymTable if every thread reading it without
+locks has announced the current epoch. Memory retired two epochs ago
+is then out of reach of every reader. */
+static void SymTableConc_advance(SymTableConc_T oSymTable) {
+#if SYMTABLECONC_ATOMICS
+    struct Reader *psReader;
+    size_t uEpoch;
+    size_t uState;
+
+    uEpoch = SymTableConc_load(&oSymTable->uEpoch);
+    for(psReader = SymTableConc_load(&oSymTable->psReaders);
+    psReader != NULL; psReader = psReader->psNextReader) {
+        uState = SymTableConc_load(&psReader->uState);
+        if(uState != 0 && uState >> 1 != uEpoch) {
+            return;
+        }
+    }
+    /* fails harmlessly if another thread advanced it first */
+    __atomic_compare_exchange_n(&oSymTable->uEpoch, &uEpoch,
+    uEpoch + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#else
+    (void)oSymTable;
+#endif
+}
+
+/* Frees the bindings psStripe retired in epochs every reader of
+oSymTable has left, and the retired arrays likewise, unless another
+thread is using the list of retired arrays. The caller must hold
+psStripe. */
+static void SymTableConc_reclaim(SymTableConc_T oSymTable,
+struct Stripe *psStripe) {
+    struct BucketArray **ppsArrayLink;
+    struct BucketArray *psArray;
+    struct Binding *psNextBinding;
+    size_t uEpoch;
+    size_t list;
+
+    uEpoch = SymTableConc_load(&oSymTable->uEpoch);
+    for(list = 0; list < LIMBO_LISTS; list++) {
+        if(psStripe->auLimboEpoch[list] + 2 > uEpoch) {
+            continue;
+        }
+        while(psStripe->apsLimbo[list] != NULL) {
+            psNextBinding = psStripe->apsLimbo[list]->psNextRetired;
+            free(psStripe->apsLimbo[list]);
+            psStripe->apsLimbo[list] = psNextBinding;
+            psStripe->retired--;
+        }
+    }
+
+    if(SymTableConc_load(&oSymTable->psRetiredArrays) == NULL
+    || pthread_mutex_trylock(&oSymTable->sMutex) != 0) {
+        return;
+    }
+    ppsArrayLink = &oSymTable->psRetiredArrays;
+    while(*ppsArrayLink != NULL) {
+        psArray = *ppsArrayLink;
+        if(psArray->uRetireEpoch + 2 <= uEpoch) {
+            SymTableConc_store(ppsArrayLink, psArray->psNextRetired);
+            SymTableConc_freeBuckets(psArray);
+        }
+        else {
+            ppsArrayLink = &psArray->psNextRetired;
+        }
+    }
+    pthread_mutex_unlock(&oSymTable->sMutex);
+}
+
+/* Frees psBinding, just unlinked from a bucket of psStripe in
+oSymTable, once no lock-free reader can reach it; in a table without
+lock-free reads, frees it now. The caller must hold psStripe. */
+static void SymTableConc_retire(SymTableConc_T oSymTable,
+struct Stripe *psStripe, struct Binding *psBinding) {
+    struct Binding *psNextBinding;
+    size_t uEpoch;
+    size_t list;
+
+    if(!oSymTable->iLockFreeReads) {
+        free(psBinding);
+        return;
+    }
+
+    /* orders the unlink before reading the epoch, so a reader that
+    announces a later epoch cannot find psBinding */
+    SymTableConc_fence();
+    uEpoch = SymTableConc_load(&oSymTable->uEpoch);
+
+    /* a list last filled LIMBO_LISTS or more epochs ago is out of
+    reach of every reader */
+    list = uEpoch % LIMBO_LISTS;
+    if(psStripe->auLimboEpoch[list] != uEpoch) {
+        while(psStripe->apsLimbo[list] != NULL) {
+            psNextBinding = psStripe->apsLimbo[list]->psNextRetired;
+            free(psStripe->apsLimbo[list]);
+            psStripe->apsLimbo[list] = psNextBinding;
+            psStripe->retired--;
+        }
+        psStripe->auLimboEpoch[list] = uEpoch;
+    }
+    psBinding->psNextRetired = psStripe->apsLimbo[list];
+    psStripe->apsLimbo[list] = psBinding;
+    psStripe->retired++;
+
+    if(psStripe->retired >= RECLAIM_THRESHOLD) {
+        SymTableConc_advance(oSymTable);
+        SymTableConc_reclaim(oSymTable, psStripe);
+    }
+}
+
+/* Returns the Reader of the calling thread for oSymTable, registering
+one if the thread has not read oSymTable before, or NULL if there is
+insufficient memory. */
+static struct Reader *SymTableConc_reader(SymTableConc_T oSymTable) {
+    struct Reader *psReader;
+    void *pvReader;
+
+    psReader = (struct Reader*)
+    pthread_getspecific(oSymTable->sReaderKey);
+    if(psReader != NULL) {
+        return psReader;
+    }
+
+    pthread_mutex_lock(&oSymTable->sMutex);
+    /* takes over the Reader of an exited thread, if there is one */
+    for(psReader = oSymTable->psReaders; psReader != NULL;
+    psReader = psReader->psNextReader) {
+        if(!SymTableConc_load(&psReader->iInUse)) {
+            break;
+        }
+    }
+    if(psReader == NULL) {
+        if(posix_memalign(&pvReader, CACHE_LINE,
+        sizeof(union PaddedReader)) != 0) {
+            pthread_mutex_unlock(&oSymTable->sMutex);
+            return NULL;
+        }
+        psReader = (struct Reader*)pvReader;
+        psReader->uState = 0;
+        psReader->psNextReader = oSymTable->psReaders;
+        SymTableConc_store(&oSymTable->psReaders, psReader);
+    }
+    SymTableConc_store(&psReader->iInUse, 1);
+    pthread_mutex_unlock(&oSymTable->sMutex);
+
+    if(pthread_setspecific(oSymTable->sReaderKey, psReader) != 0) {
+        SymTableConc_store(&psReader->iInUse, 0);
+        return NULL;
+    }
+    return psReader;
+}
+
+/* Returns the address of the link that points to the binding of pcKey
+in oSymTable, which is a bucket or the psNextBinding field of the
+previous binding, or NULL if pcKey is not in oSymTable. The caller must
+hold the stripe of uHash. */
+static struct Binding **SymTableConc_findLink(SymTableConc_T oSymTable,
+const char *pcKey, size_t uHash) {
+    struct Binding **ppsLink;
+
+    ppsLink = &oSymTable->psBuckets->apsBuckets[uHash
+    & (oSymTable->psBuckets->bucketCount - 1)];
+    while(*ppsLink != NULL) {
+        if((*ppsLink)->uHash == uHash
+        && !strcmp((*ppsLink)->acKey, pcKey)) {
+            return ppsLink;
+        }
+        ppsLink = &(*ppsLink)->psNextBinding;
+    }
+    return NULL;
+}
+
+/* Looks up pcKey, whose hash code is uHash, in oSymTable. Returns 1
+(TRUE) and stores its value in *ppvValue if found, or returns 0 (FALSE)
+if not. Holds the read lock of the key's stripe meanwhile, unless
+oSymTable has lock-free reads: then it only announces the current
+epoch, so that nothing it reaches is freed before it is done. */
+static int SymTableConc_lookup(SymTableConc_T oSymTable,
+const char *pcKey, size_t uHash, void **ppvValue) {
+    struct Binding **ppsLink;
+    struct Binding *psBinding;
+    struct BucketArray *psBuckets;
+    struct Reader *psReader = NULL;
+    struct Stripe *psStripe;
+    int iFound = 0;
+
+    if(oSymTable->iLockFreeReads) {
+        psReader = SymTableConc_reader(oSymTable);
+    }
+    if(psReader == NULL) {
+        psStripe = SymTableConc_stripe(oSymTable, uHash);
+        pthread_rwlock_rdlock(&psStripe->sLock);
+        ppsLink = SymTableConc_findLink(oSymTable, pcKey, uHash);
+        if(ppsLink != NULL) {
+            *ppvValue = (*ppsLink)->pvValue;
+            iFound = 1;
+        }
+        pthread_rwlock_unlock(&psStripe->sLock);
+        return iFound;
+    }
+
+    /* the announcement must be visible before any binding is read */
+    SymTableConc_store(&psReader->uState,
+    (SymTableConc_load(&oSymTable->uEpoch) << 1) | 1);
+    SymTableConc_fence();
+
+    psBuckets = SymTableConc_load(&oSymTable->psBuckets);
+    psBinding = SymTableConc_load(&psBuckets->apsBuckets[uHash
+    & (psBuckets->bucketCount - 1)]);
+    while(psBinding != NULL) {
+        if(psBinding->uHash == uHash
+        && !strcmp(psBinding->acKey, pcKey)) {
+            *ppvValue = SymTableConc_load(&psBinding->pvValue);
+            iFound = 1;
+            break;
+        }
+        psBinding = SymTableConc_load(&psBinding->psNextBinding);
+    }
+
+    SymTableConc_store(&psReader->uState, (size_t)0);
+    return iFound;
+}
+
+/* Doubles the number of buckets of oSymTable if the stripe psStripe
+still holds more bindings than buckets once every stripe is locked;
+another thread may have expanded the table meanwhile. Moves every
+binding at once. With lock-free reads, readers may be walking the old
+chains, so the bindings are copied rather than relinked, and the old
+array and its bindings are retired together. Leaves oSymTable
+unchanged if there is insufficient memory, so it keeps working with
+longer chains. The caller must hold no stripe. */
+static void SymTableConc_expand(SymTableConc_T oSymTable,
+struct Stripe *psStripe) {
+    struct BucketArray *psOldBuckets;
+    struct BucketArray *psNewBuckets;
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    struct Binding *psCopy;
+    size_t newBucketCount;
+    size_t uSize;
+    size_t bucket;
+
+    SymTableConc_lockAll(oSymTable);
+
+    psOldBuckets = oSymTable->psBuckets;
+    if(psStripe->bindings <= psOldBuckets->bucketCount / LOCK_STRIPES
+    || psOldBuckets->bucketCount > (size_t)-1 / 2) {
+        SymTableConc_unlockAll(oSymTable);
+        return;
+    }
+    newBucketCount = psOldBuckets->bucketCount * 2;
+    psNewBuckets = SymTableConc_newBuckets(newBucketCount);
+    if(psNewBuckets == NULL) {
+        SymTableConc_unlockAll(oSymTable);
+        return;
+    }
+
+    /* links every binding, or a copy, into the unpublished array,
+    using its cached hash code */
+    for(bucket = 0; bucket < psOldBuckets->bucketCount; bucket++) {
+        psCurrentBinding = psOldBuckets->apsBuckets[bucket];
+        while(psCurrentBinding != NULL) {
+            psNextBinding = psCurrentBinding->psNextBinding;
+            psCopy = psCurrentBinding;
+            if(oSymTable->iLockFreeReads) {
+                uSize = offsetof(struct Binding, acKey)
+                + strlen(psCurrentBinding->acKey) + 1;
+                psCopy = (struct Binding*)malloc(uSize);
+                if(psCopy == NULL) {
+                    SymTableConc_freeBuckets(psNewBuckets);
+                    SymTableConc_unlockAll(oSymTable);
+                    return;
+                }
+                memcpy(psCopy, psCurrentBinding, uSize);
+            }
+            psCopy->psNextBinding = psNewBuckets->apsBuckets[
+            psCopy->uHash & (newBucketCount - 1)];
+            psNewBuckets->apsBuckets[psCopy->uHash
+            & (newBucketCount - 1)] = psCopy;
+            psCurrentBinding = psNextBinding;
+        }
+    }
+    SymTableConc_store(&oSymTable->psBuckets, psNewBuckets);
+
+    if(!oSymTable->iLockFreeReads) {
+        free(psOldBuckets);
+    }
+    else {
+        SymTableConc_fence();
+        psOldBuckets->uRetireEpoch =
+        SymTableConc_load(&oSymTable->uEpoch);
+        pthread_mutex_lock(&oSymTable->sMutex);
+        psOldBuckets->psNextRetired = oSymTable->psRetiredArrays;
+        SymTableConc_store(&oSymTable->psRetiredArrays, psOldBuckets);
+        pthread_mutex_unlock(&oSymTable->sMutex);
+        SymTableConc_advance(oSymTable);
+        SymTableConc_reclaim(oSymTable, psStripe);
+    }
+
+    SymTableConc_unlockAll(oSymTable);
+}
+
+int SymTableConc_put(SymTableConc_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    struct Binding *psNewBinding;
+    struct Binding **ppsBucket;
+    struct Stripe *psStripe;
+    size_t uLength;
+    size_t uHash;
+    int iExpand;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableConc_hash(pcKey, &uLength);
+    psStripe = SymTableConc_stripe(oSymTable, uHash);
+
+    pthread_rwlock_wrlock(&psStripe->sLock);
+    if(SymTableConc_findLink(oSymTable, pcKey, uHash) != NULL) {
+        pthread_rwlock_unlock(&psStripe->sLock);
+        return 0;
+    }
+
+    psNewBinding = (struct Binding*)
+    malloc(offsetof(struct Binding, acKey) + uLength + 1);
+    if(psNewBinding == NULL) {
+        pthread_rwlock_unlock(&psStripe->sLock);
+        return 0;
+    }
+    memcpy(psNewBinding->acKey, pcKey, uLength + 1);
+    psNewBinding->pvValue = (void*)pvValue;
+    psNewBinding->uHash = uHash;
+
+    /* adds the binding to the front of its bucket, publishing it only
+    once it is complete */
+    ppsBucket = &oSymTable->psBuckets->apsBuckets[uHash
+    & (oSymTable->psBuckets->bucketCount - 1)];
+    psNewBinding->psNextBinding = *ppsBucket;
+    SymTableConc_store(ppsBucket, psNewBinding);
+    psStripe->bindings++;
+
+    /* a stripe guards bucketCount / LOCK_STRIPES buckets; keys spread
+    evenly over the stripes, so one stripe over its share means the
+    whole table is about full */
+    iExpand = psStripe->bindings
+    > oSymTable->psBuckets->bucketCount / LOCK_STRIPES;
+    pthread_rwlock_unlock(&psStripe->sLock);
+
+    if(iExpand) {
+        SymTableConc_expand(oSymTable, psStripe);
+    }
+    return 1;
+}
+
+void *SymTableConc_replace(SymTableConc_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    struct Binding **ppsLink;
+    struct Stripe *psStripe;
+    void *pvOldValue = NULL;
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableConc_hash(pcKey, &uLength);
+    psStripe = SymTableConc_stripe(oSymTable, uHash);
+
+    pthread_rwlock_wrlock(&psStripe->sLock);
+    ppsLink = SymTableConc_findLink(oSymTable, pcKey, uHash);
+    if(ppsLink != NULL) {
+        pvOldValue = (*ppsLink)->pvValue;
+        SymTableConc_store(&(*ppsLink)->pvValue, (void*)pvValue);
+    }
+    pthread_rwlock_unlock(&psStripe->sLock);
+
+    return pvOldValue;
+}
+
+int SymTableConc_contains(SymTableConc_T oSymTable, const char *pcKey) {
+    void *pvValue;
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableConc_hash(pcKey, &uLength);
+    return SymTableConc_lookup(oSymTable, pcKey, uHash, &pvValue);
+}
+
+void *SymTableConc_get(SymTableConc_T oSymTable, const char *pcKey) {
+    void *pvValue = NULL;
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableConc_hash(pcKey, &uLength);
+    SymTableConc_lookup(oSymTable, pcKey, uHash, &pvValue);
+    return pvValue;
+}
+
+void *SymTableConc_remove(SymTableConc_T oSymTable, const char *pcKey) {
+    struct Binding **ppsLink;
+    struct Binding *psBinding;
+    struct Stripe *psStripe;
+    void *pvValue = NULL;
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableConc_hash(pcKey, &uLength);
+    psStripe = SymTableConc_stripe(oSymTable, uHash);
+
+    pthread_rwlock_wrlock(&psStripe->sLock);
+    ppsLink = SymTableConc_findLink(oSymTable, pcKey, uHash);
+    if(ppsLink != NULL) {
+        psBinding = *ppsLink;
+        pvValue = psBinding->pvValue;
+        SymTableConc_store(ppsLink, psBinding->psNextBinding);
+        psStripe->bindings--;
+        SymTableConc_retire(oSymTable, psStripe, psBinding);
+    }
+    pthread_rwlock_unlock(&psStripe->sLock);
+
+    return pvValue;
+}
+
+void SymTableConc_map(SymTableConc_T oSymTable,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    struct BucketArray *psBuckets;
+    struct Binding *psCurrentBinding;
+    struct Stripe *psStripe;
+    size_t bucket;
+    size_t stripe;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* visits one stripe's buckets at a time, so other stripes stay
+    available to other threads */
+    for(stripe = 0; stripe < LOCK_STRIPES; stripe++) {
+        psStripe = &oSymTable->auStripes[stripe].sStripe;
+        pthread_rwlock_rdlock(&psStripe->sLock);
+        psBuckets = oSymTable->psBuckets;
+        for(bucket = stripe; bucket < psBuckets->bucketCount;
+        bucket += LOCK_STRIPES) {
+            for(psCurrentBinding = psBuckets->apsBuckets[bucket];
+            psCurrentBinding != NULL;
+            psCurrentBinding = psCurrentBinding->psNextBinding) {
+                (*pfApply)(psCurrentBinding->acKey,
+                psCurrentBinding->pvValue, (void*)pvExtra);
+            }
+        }
+        pthread_rwlock_unlock(&psStripe->sLock);
+    }
+}
@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------*/
+/* symtableconc.h                                                     */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLECONC_INCLUDED
+#define SYMTABLECONC_INCLUDED
+
+#include <stddef.h>
+
+/* A SymTableConc_T object stores a collection of key/value pairs, like
+a SymTable_T object, but any number of threads may call its functions
+at the same time, with no locking of their own. Its hash table is
+guarded by a fixed set of locks, each covering an interleaved range of
+buckets, so threads that touch different ranges do not wait for each
+other. */
+typedef struct SymTableConc *SymTableConc_T;
+
+/* Returns a new SymTableConc_T object, or NULL if insufficient memory
+or another resource is available. */
+SymTableConc_T SymTableConc_new(void);
+
+/* Returns a new SymTableConc_T object whose gets and contains take no
+lock and write no memory shared with other threads, or NULL if
+insufficient memory or another resource is available. Meant for tables
+read far more often than changed: puts and removes still lock, and a
+removed binding, or a bucket array outgrown by an expansion, is only
+freed once no thread can still be reading it, so memory is reclaimed
+later and expansions copy every binding. Each thread that reads the
+table keeps a small record of its own until the table is freed. */
+SymTableConc_T SymTableConc_newLockFreeReads(void);
+
+/* Frees oSymTable. No other thread may be using oSymTable. oSymTable
+cannot be NULL. */
+void SymTableConc_free(SymTableConc_T oSymTable);
+
+/* Returns total number of key/value pairs in oSymTable. While other
+threads change oSymTable, the count may be out of date by the time it
+is returned. oSymTable cannot be NULL. */
+size_t SymTableConc_getLength(SymTableConc_T oSymTable);
+
+/* Puts pcKey/pvValue pair into oSymTable. Returns 1 (TRUE) if
+successful. Returns 0 (FALSE) if pcKey is already in oSymTable, leaving
+oSymTable unchanged. Also returns 0 if there is insufficient memory.
+oSymTable and pcKey cannot be NULL. Creates a copy of pcKey but not of
+pvValue. */
+int SymTableConc_put(SymTableConc_T oSymTable, const char *pcKey,
+const void *pvValue);
+
+/* If oSymTable contains a pair with pcKey, replaces its value with
+pvValue and returns the old value. If oSymTable does not contain
+pcKey, returns NULL. oSymTable and pcKey cannot be NULL. */
+void *SymTableConc_replace(SymTableConc_T oSymTable, const char *pcKey,
+const void *pvValue);
+
+/* Returns 1 (TRUE) if oSymTable contains pcKey and 0 (FALSE) if it
+does not. oSymTable and pcKey cannot be NULL. */
+int SymTableConc_contains(SymTableConc_T oSymTable, const char *pcKey);
+
+/* Returns value associated with pcKey in oSymTable. If pcKey is not
+in oSymTable, returns NULL. oSymTable and pcKey cannot be NULL. */
+void *SymTableConc_get(SymTableConc_T oSymTable, const char *pcKey);
+
+/* If oSymTable contains pcKey, removes the key/value pair and returns
+the value. If not, does not change oSymTable and returns NULL.
+oSymTable and pcKey cannot be NULL. */
+void *SymTableConc_remove(SymTableConc_T oSymTable, const char *pcKey);
+
+/* Applies function *pfApply to each key/value pair in oSymTable and
+passes pvExtra as an extra parameter. Pairs that other threads put or
+remove meanwhile may or may not be visited. *pfApply runs while a lock
+of oSymTable is held, so it must not call any function on oSymTable.
+oSymTable and pfApply cannot be NULL. */
+void SymTableConc_map(SymTableConc_T oSymTable,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra);
+
+#endif
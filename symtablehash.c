@@ -4,14 +4,111 @@
 /*--------------------------------------------------------------------*/
 
 #include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "symtable.h"
+#include <time.h>
+#include "symtablehash.h"
+#ifdef SYMTABLE_ARENA
+#include "symarena.h"
+#endif
 
-/* array of bucket count sizes for hash expansion */
-static const size_t auBucketCounts[] = {509, 1021, 2039, 4093, 8191, 
+/* array of bucket count sizes for hash expansion. Past the last
+entry, each expansion uses the smallest prime larger than twice the
+current bucket count. */
+static const size_t auBucketCounts[] = {509, 1021, 2039, 4093, 8191,
 16381, 32749, 65521};
 
+/* Keys shorter than SYMTABLE_INLINE_KEY bytes are stored inside their
+binding. Define it as 0 to store every key in memory of its own. 23
+bytes, with the flag byte before them, fill a binding to 56 bytes. */
+#ifndef SYMTABLE_INLINE_KEY
+#define SYMTABLE_INLINE_KEY 23
+#endif
+
+/* maximum number of old buckets moved into the new hash table by a
+single put, get, or remove while the table is being resized */
+enum {MIGRATE_STEP = 4};
+
+/* number of keys SymTable_getMany hashes and prefetches before it
+resolves any of them. The cache misses of a group overlap, so a larger
+group hides more latency, until the prefetched lines no longer fit in
+the L1 cache. */
+enum {BATCH_GROUP = 16};
+
+/* Asks the processor to start loading the cache line at address pv,
+without waiting for it. Compilers without the builtin skip the hint. */
+#if defined(__GNUC__)
+#define SymTable_prefetch(pv) __builtin_prefetch(pv)
+#else
+#define SymTable_prefetch(pv) ((void)(pv))
+#endif
+
+#ifdef SYMTABLE_INSTRUMENT
+/* the functions of the table whose calls are counted, and their names
+for SymTable_dumpCounters */
+enum Call {CALL_PUT, CALL_REPLACE, CALL_CONTAINS, CALL_GET, CALL_REMOVE,
+    CALL_FIND_OR_INSERT, CALL_UPSERT, CALL_GET_LENGTH, CALL_MAP,
+    CALL_SEED, CALL_PUT_N, CALL_REPLACE_N, CALL_CONTAINS_N,
+    CALL_GET_N, CALL_REMOVE_N, CALL_PUT_HASHED, CALL_REPLACE_HASHED,
+    CALL_CONTAINS_HASHED, CALL_GET_HASHED, CALL_REMOVE_HASHED,
+    CALL_GET_MANY, CALL_RESERVE, CALL_COMPACT, CALL_PUT_BULK,
+    CALL_MERGE, CALL_INTERN, CALL_PUT_ATOM, CALL_REPLACE_ATOM,
+    CALL_CONTAINS_ATOM, CALL_GET_ATOM, CALL_REMOVE_ATOM, CALL_GET_STATS,
+    CALL_ITER_BEGIN, CALL_ITER_NEXT, CALL_COUNT};
+static const char *const apcCallNames[] = {"SymTable_put",
+    "SymTable_replace", "SymTable_contains", "SymTable_get",
+    "SymTable_remove", "SymTable_findOrInsert", "SymTable_upsert",
+    "SymTable_getLength", "SymTable_map", "SymTable_seed",
+    "SymTable_putN", "SymTable_replaceN",
+    "SymTable_containsN", "SymTable_getN", "SymTable_removeN",
+    "SymTable_putHashed", "SymTable_replaceHashed",
+    "SymTable_containsHashed", "SymTable_getHashed",
+    "SymTable_removeHashed", "SymTable_getMany", "SymTable_reserve",
+    "SymTable_compact", "SymTable_putBulk", "SymTable_merge",
+    "SymTable_intern", "SymTable_putAtom", "SymTable_replaceAtom",
+    "SymTable_containsAtom", "SymTable_getAtom", "SymTable_removeAtom",
+    "SymTable_getStats",
+    "SymTable_iterBegin", "SymTable_iterNext"};
+
+/* What a table built with SYMTABLE_INSTRUMENT counts. Each function
+counts as one call even where it calls another. The functions that
+several threads may call on one table at once, SymTable_hashKey,
+SymTable_getSliceCount, and SymTable_mapSlice, count nothing, so that
+they still only read the table. */
+struct Counters
+{
+   /* calls of each function, indexed by enum Call */
+   size_t auCalls[CALL_COUNT];
+
+   /* keys compared with a key being looked up, which happens only
+   when their hash codes match */
+   size_t keyCompares;
+
+   /* bindings and atoms looked at along chains by lookups */
+   size_t nodesVisited;
+
+   /* hash codes computed */
+   size_t hashes;
+
+   /* memory allocated, and freed, by malloc, calloc, or the arena */
+   size_t mallocs;
+   size_t frees;
+
+   /* SymTable_expand calls, and the processor time they took */
+   size_t expands;
+   clock_t expandTicks;
+};
+
+/* Adds 1 to counter field of the counters of oSymTable. Without
+SYMTABLE_INSTRUMENT, does nothing and generates no code. */
+#define SymTable_count(oSymTable, field) \
+((void)((oSymTable)->sCounters.field++))
+#else
+#define SymTable_count(oSymTable, field) ((void)0)
+#endif
+
 /* Each key/value pair is stored in a Binding. Bindings are each found
 in a linked list beginning at a bucket in the hash table. */
 struct Binding
@@ -20,23 +117,129 @@ struct Binding
     char *pcKey;
     /* value */
     void *pvValue;
+    /* full hash code of pcKey, so that resizing never rehashes a key
+    and lookups only compare keys whose hash codes match */
+    size_t uHash;
 
     /* address of next binding */
     struct Binding *psNextBinding;
+
+    /* 1 if the binding lies in a block of SymTable_putBulk, which
+    frees it with the block, and 0 if not */
+    unsigned char ucInBlock;
+
+#if SYMTABLE_INLINE_KEY > 0
+    /* pcKey points here when the key is short enough, so comparing it
+    touches no memory outside the binding */
+    char acInlineKey[SYMTABLE_INLINE_KEY];
+#endif
+};
+
+/* Each interned key is stored in a SymAtom. Atoms are chained by hash
+code in a hash table of their own, separate from the bindings. */
+struct SymAtom
+{
+    /* full hash code of acKey */
+    size_t uHash;
+    /* number of characters in acKey, not counting its '\0' */
+    size_t uLength;
+
+    /* address of next atom in the same bucket */
+    struct SymAtom *psNextAtom;
+
+    /* the key */
+    char acKey[1];
+};
+
+/* Each SymTable_putBulk call allocates its bindings, followed by the
+keys too long to be stored in them, in a single BulkBlock. A binding
+in a block is never freed on its own; the block is freed along with
+the table. */
+struct BulkBlock
+{
+    /* address of next block */
+    struct BulkBlock *psNextBlock;
+
+    /* the bindings */
+    struct Binding asBindings[1];
 };
 
 /* SymTable is a structure that points to the first Binding and tracks
-total number of bindings. */
+total number of bindings. While the table is resizing, the bindings
+are split between the old and the new hash table and are moved over a
+few buckets at a time. */
 struct SymTable
 {
    /* pointer to hash table, an array of pointers to bindings  */
    struct Binding **psHashTable;
-   
+
    /* number of bindings */
    size_t bindings;
-   
-   /* index to keep track of number of buckets */
+
+   /* index to keep track of number of buckets. Past the end of
+   auBucketCounts it keeps counting expansions. */
    size_t buckets;
+
+   /* number of buckets in psHashTable */
+   size_t bucketCount;
+
+   /* index into the growth sequence below which the hash table does
+   not shrink on its own, set by SymTable_reserve */
+   size_t reservedBuckets;
+
+   /* hash table being drained into psHashTable, or NULL if the table
+   is not resizing */
+   struct Binding **psOldHashTable;
+
+   /* number of buckets in psOldHashTable */
+   size_t oldBucketCount;
+
+   /* number of buckets of psOldHashTable already moved */
+   size_t migrated;
+
+   /* hash table of interned keys, or NULL if no key has been
+   interned */
+   struct SymAtom **psAtomTable;
+
+   /* number of atoms */
+   size_t atoms;
+
+   /* index into the growth sequence for psAtomTable */
+   size_t atomBuckets;
+
+   /* number of buckets in psAtomTable */
+   size_t atomBucketCount;
+
+   /* blocks of bindings put by SymTable_putBulk, newest first */
+   struct BulkBlock *psBulkBlocks;
+
+   /* 1 (TRUE) if keys are hashed with SipHash under auSeed, set by
+   SymTable_seed, and 0 (FALSE) if with the compiled-in function */
+   int iSeeded;
+
+   /* the 128-bit key of SipHash, if iSeeded */
+   uint64_t auSeed[2];
+
+   /* number of resizes started, growing or shrinking, whether their
+   bindings move a few buckets at a time or all at once */
+   size_t resizes;
+
+   /* bytes of memory allocated for the table and not yet freed,
+   besides its arena, not counting the allocator's own overhead */
+   size_t bytes;
+
+   /* slice at which the next sampling SymTable_getStats call starts */
+   size_t sampleStart;
+
+#ifdef SYMTABLE_INSTRUMENT
+   /* counters for finding where the time of the table goes */
+   struct Counters sCounters;
+#endif
+
+#ifdef SYMTABLE_ARENA
+   /* arena holding every binding and key copy of the table */
+   SymArena_T oArena;
+#endif
 };
 
 SymTable_T SymTable_new(void) {
@@ -53,317 +256,2151 @@ SymTable_T SymTable_new(void) {
         free(oSymTable);
         return NULL;
     }
+#ifdef SYMTABLE_ARENA
+    oSymTable->oArena = SymArena_new(sizeof(struct Binding));
+    if(oSymTable->oArena == NULL) {
+        free(oSymTable->psHashTable);
+        free(oSymTable);
+        return NULL;
+    }
+#endif
 
     /* initializes parameters of oSymTable */
     oSymTable->bindings = 0;
     oSymTable->buckets = 0;
-    
+    oSymTable->bucketCount = auBucketCounts[0];
+    oSymTable->reservedBuckets = 0;
+    oSymTable->psOldHashTable = NULL;
+    oSymTable->oldBucketCount = 0;
+    oSymTable->migrated = 0;
+    oSymTable->psAtomTable = NULL;
+    oSymTable->atoms = 0;
+    oSymTable->atomBuckets = 0;
+    oSymTable->atomBucketCount = 0;
+    oSymTable->psBulkBlocks = NULL;
+    oSymTable->iSeeded = 0;
+    oSymTable->auSeed[0] = 0;
+    oSymTable->auSeed[1] = 0;
+    oSymTable->resizes = 0;
+    oSymTable->bytes = sizeof(struct SymTable)
+    + auBucketCounts[0] * sizeof(struct Binding*);
+    oSymTable->sampleStart = 0;
+#ifdef SYMTABLE_INSTRUMENT
+    memset(&oSymTable->sCounters, 0, sizeof(oSymTable->sCounters));
+    oSymTable->sCounters.mallocs = 2;
+#endif
+
     return oSymTable;
 }
 
-void SymTable_free(SymTable_T oSymTable) {
-    struct Binding *psCurrentBinding;
-    struct Binding *psNextBinding;
-    size_t bucket = 0;
+/* The hash function, chosen when the file is compiled by defining
+SYMTABLE_HASH as one of:
 
-    assert(oSymTable != NULL);
+   SYMTABLE_HASH_65599   multiplies by 65599 and adds each character in
+                         turn; the default, whose codes testCollisions
+                         in testsymtable.c depends on
+   SYMTABLE_HASH_WORD    mixes eight characters at a time with 64-bit
+                         multiplies, in the manner of wyhash
+   SYMTABLE_HASH_CRC32C  the CRC-32C of the key, with the SSE4.2 crc32
+                         instruction when the compiler targets it, and
+                         a table of 16 remainders otherwise */
+#define SYMTABLE_HASH_65599 1
+#define SYMTABLE_HASH_WORD 2
+#define SYMTABLE_HASH_CRC32C 3
+#ifndef SYMTABLE_HASH
+#define SYMTABLE_HASH SYMTABLE_HASH_65599
+#endif
 
-    /* frees each binding in each of the buckets of the hash table */
-    while(bucket < auBucketCounts[oSymTable->buckets]) {
-        psCurrentBinding = oSymTable->psHashTable[bucket];
-        while(psCurrentBinding != NULL) {
-            psNextBinding = psCurrentBinding->psNextBinding;
-            free(psCurrentBinding->pcKey);
-            free(psCurrentBinding);
-            psCurrentBinding = psNextBinding;
-        }
-        bucket++;
+#if SYMTABLE_HASH == SYMTABLE_HASH_65599
+
+/* multiplier of the hash function */
+#define HASH_MULTIPLIER 65599
+
+/* Return a hash code for pcKey and store its length in *puLength, in
+a single pass over the key. */
+static size_t SymTable_hash(const char *pcKey, size_t *puLength) {
+    size_t u;
+    size_t uHash = 0;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++) {
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
     }
-    
-    /* frees hash table array and symbol table */
-    free(oSymTable->psHashTable);
-    free(oSymTable);
-}
 
-size_t SymTable_getLength(SymTable_T oSymTable) {
-    assert(oSymTable != NULL);
-    return oSymTable->bindings;
+    *puLength = u;
+    return uHash;
 }
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-inclusive. */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount) {
-    const size_t HASH_MULTIPLIER = 65599;
+/* Return the hash code of the uLength characters at pcKey. It equals
+the hash code SymTable_hash computes for the same characters followed
+by '\0'. */
+static size_t SymTable_hashN(const char *pcKey, size_t uLength) {
     size_t u;
     size_t uHash = 0;
 
     assert(pcKey != NULL);
 
-    for (u = 0; pcKey[u] != '\0'; u++) {
+    for (u = 0; u < uLength; u++) {
         uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
     }
 
+    return uHash;
+}
+
+/* Returns the bucket among uBucketCount buckets of the key with hash
+code uHash. The low bits of a code of this function depend only on the
+last few characters, and a short key's code is small, so the whole
+code is reduced modulo the bucket count, a prime. */
+static size_t SymTable_bucketOf(size_t uHash, size_t uBucketCount) {
     return uHash % uBucketCount;
 }
 
-/* Creates a new SymTable_T object with an expanded hash table, based on 
-the size of the incrementer buckets. Returns the symbol table if
-succesfful and NULL if not. */
-static SymTable_T SymTable_ExpandNew(size_t buckets) {
-    SymTable_T oSymTable;
+#elif SYMTABLE_HASH == SYMTABLE_HASH_WORD
 
-    /* Allocates memory for oSymTable and the hash table */
-    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
-    if(oSymTable == NULL) {
-        return NULL;
+/* the constants the word hash mixes the key with */
+#define HASH_SECRET0 0xa0761d6478bd642fU
+#define HASH_SECRET1 0xe7037ed1a0b428dbU
+
+/* Returns the exclusive or of the two halves of the 128-bit product of
+uA and uB. */
+static uint64_t SymTable_mix(uint64_t uA, uint64_t uB) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 uProduct =
+    (unsigned __int128)uA * uB;
+    return (uint64_t)uProduct ^ (uint64_t)(uProduct >> 64);
+#else
+    uint64_t uALow = uA & 0xffffffffU;
+    uint64_t uAHigh = uA >> 32;
+    uint64_t uBLow = uB & 0xffffffffU;
+    uint64_t uBHigh = uB >> 32;
+    uint64_t uLowLow = uALow * uBLow;
+    uint64_t uLowHigh = uALow * uBHigh;
+    uint64_t uHighLow = uAHigh * uBLow;
+    uint64_t uHighHigh = uAHigh * uBHigh;
+    uint64_t uMiddle = (uLowLow >> 32) + (uLowHigh & 0xffffffffU)
+    + (uHighLow & 0xffffffffU);
+    return ((uLowLow & 0xffffffffU) | (uMiddle << 32))
+    ^ (uHighHigh + (uLowHigh >> 32) + (uHighLow >> 32)
+    + (uMiddle >> 32));
+#endif
+}
+
+/* Returns the 8 bytes at pc as an integer, in the byte order of the
+processor. */
+static uint64_t SymTable_read8(const char *pc) {
+    uint64_t u;
+    memcpy(&u, pc, sizeof(u));
+    return u;
+}
+
+/* Returns the 4 bytes at pc as an integer, in the byte order of the
+processor. */
+static uint64_t SymTable_read4(const char *pc) {
+    uint32_t u;
+    memcpy(&u, pc, sizeof(u));
+    return u;
+}
+
+/* Return the hash code of the uLength characters at pcKey. Keys of up
+to 16 characters are read as two overlapping pairs of 4-byte words, or
+as three single bytes when shorter than 4; longer keys are mixed 16
+bytes at a time, and their last 16 bytes form the final pair. */
+static size_t SymTable_hashN(const char *pcKey, size_t uLength) {
+    uint64_t uSeed = HASH_SECRET0;
+    uint64_t uA;
+    uint64_t uB;
+    size_t uLeft;
+    const unsigned char *puc = (const unsigned char *)pcKey;
+
+    assert(pcKey != NULL);
+
+    if(uLength <= 16) {
+        if(uLength >= 4) {
+            uLeft = (uLength >> 3) << 2;
+            uA = (SymTable_read4(pcKey) << 32)
+            | SymTable_read4(pcKey + uLeft);
+            uB = (SymTable_read4(pcKey + uLength - 4) << 32)
+            | SymTable_read4(pcKey + uLength - 4 - uLeft);
+        }
+        else if(uLength > 0) {
+            uA = ((uint64_t)puc[0] << 16)
+            | ((uint64_t)puc[uLength >> 1] << 8) | puc[uLength - 1];
+            uB = 0;
+        }
+        else {
+            uA = 0;
+            uB = 0;
+        }
     }
-    oSymTable->psHashTable = (struct Binding**)
-    calloc(sizeof(struct Binding*), auBucketCounts[buckets]);
-    if(oSymTable->psHashTable == NULL) {
-        free(oSymTable);
-        return NULL;
+    else {
+        for(uLeft = uLength; uLeft > 16; uLeft -= 16) {
+            uSeed = SymTable_mix(SymTable_read8(pcKey) ^ HASH_SECRET1,
+            SymTable_read8(pcKey + 8) ^ uSeed);
+            pcKey += 16;
+        }
+        uA = SymTable_read8(pcKey + uLeft - 16);
+        uB = SymTable_read8(pcKey + uLeft - 8);
     }
 
-    /* initializes parameters of oSymTable */
-    oSymTable->bindings = 0;
-    oSymTable->buckets = buckets;
-    
-    return oSymTable;
+    return (size_t)SymTable_mix(HASH_SECRET1 ^ uLength,
+    SymTable_mix(uA ^ HASH_SECRET1, uB ^ uSeed));
 }
 
-/* Expands the size of oSymTables hash table. If not possible, will
-not change oSymTable. */
-static void SymTable_expand(SymTable_T oSymTable) {
-    SymTable_T oNewSymTable;
-    struct Binding **psOldHashTable;
-    struct Binding *psCurrentBinding;
-    size_t bucket; 
-    size_t numBucketCounts = 
-    sizeof(auBucketCounts)/sizeof(auBucketCounts[0]);
-    size_t newBucketCount = (oSymTable->buckets) + 1;
-    
-    /* Checks if it is possible to add more buckets */
-    if(newBucketCount + 1 >= numBucketCounts) {
-        return;
+#elif SYMTABLE_HASH == SYMTABLE_HASH_CRC32C
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#else
+/* the CRC-32C remainders of the 16 values of a 4-bit nibble */
+static const uint32_t auCrcNibbles[] = {0x00000000U, 0x105ec76fU,
+0x20bd8edeU, 0x30e349b1U, 0x417b1dbcU, 0x5125dad3U, 0x61c69362U,
+0x7198540dU, 0x82f63b78U, 0x92a8fc17U, 0xa24bb5a6U, 0xb21572c9U,
+0xc38d26c4U, 0xd3d3e1abU, 0xe330a81aU, 0xf36e6f75U};
+#endif
+
+/* Return the hash code of the uLength characters at pcKey: their
+CRC-32C. The crc32 instruction takes 8 bytes at a time, then 4, then
+1; the table takes a nibble at a time, and gives the same code. */
+static size_t SymTable_hashN(const char *pcKey, size_t uLength) {
+    uint32_t uCrc = 0xffffffffU;
+    size_t u = 0;
+
+    assert(pcKey != NULL);
+
+#if defined(__SSE4_2__)
+    {
+        uint64_t uCrc64 = uCrc;
+        uint64_t uWord;
+        uint32_t uHalf;
+        for(; u + 8 <= uLength; u += 8) {
+            memcpy(&uWord, pcKey + u, sizeof(uWord));
+            uCrc64 = _mm_crc32_u64(uCrc64, uWord);
+        }
+        uCrc = (uint32_t)uCrc64;
+        if(u + 4 <= uLength) {
+            memcpy(&uHalf, pcKey + u, sizeof(uHalf));
+            uCrc = _mm_crc32_u32(uCrc, uHalf);
+            u += 4;
+        }
+    }
+    for(; u < uLength; u++) {
+        uCrc = _mm_crc32_u8(uCrc, (unsigned char)pcKey[u]);
+    }
+#else
+    for(; u < uLength; u++) {
+        uCrc ^= (unsigned char)pcKey[u];
+        uCrc = (uCrc >> 4) ^ auCrcNibbles[uCrc & 0xfU];
+        uCrc = (uCrc >> 4) ^ auCrcNibbles[uCrc & 0xfU];
     }
+#endif
 
-    /* Creates a new, temporary symbol table. If not possible, maintains
-    original symbol table. */
-    oNewSymTable = SymTable_ExpandNew(newBucketCount);
-    if(oNewSymTable == NULL) {
-        return;
+    return (size_t)~uCrc;
+}
+
+#else
+#error "SYMTABLE_HASH names no hash function"
+#endif
+
+#if SYMTABLE_HASH != SYMTABLE_HASH_65599
+
+/* Return a hash code for pcKey and store its length in *puLength.
+These functions hash whole words, so they need the length first;
+strlen finds it faster than a loop over the characters would. */
+static size_t SymTable_hash(const char *pcKey, size_t *puLength) {
+    assert(pcKey != NULL);
+
+    *puLength = strlen(pcKey);
+    return SymTable_hashN(pcKey, *puLength);
+}
+
+/* Returns the bucket among uBucketCount buckets of the key with hash
+code uHash: the low 32 bits of the code, read as a fraction of 2^32,
+times the bucket count. A multiply and a shift cost less than the
+division modulo would, and every bit of the code matters.
+SymTable_nextBucketCount keeps the bucket count below 2^32. */
+static size_t SymTable_bucketOf(size_t uHash, size_t uBucketCount) {
+    return (size_t)(((uint64_t)(uHash & 0xffffffffU)
+    * (uint64_t)uBucketCount) >> 32);
+}
+
+#endif
+
+/* number of SipHash rounds per 8 bytes of key, and at the end. One
+and three, as in SipHash-1-3, are enough to keep the codes of a
+seeded table from being predicted. */
+enum {SIP_ROUNDS = 1};
+enum {SIP_FINAL_ROUNDS = 3};
+
+/* Returns u rotated left by n bits. */
+#define SymTable_rotate(u, n) (((u) << (n)) | ((u) >> (64 - (n))))
+
+/* Applies iRounds rounds of SipHash to the state auState. */
+static void SymTable_sipRounds(uint64_t *auState, int iRounds) {
+    while(iRounds-- > 0) {
+        auState[0] += auState[1];
+        auState[1] = SymTable_rotate(auState[1], 13) ^ auState[0];
+        auState[0] = SymTable_rotate(auState[0], 32);
+        auState[2] += auState[3];
+        auState[3] = SymTable_rotate(auState[3], 16) ^ auState[2];
+        auState[0] += auState[3];
+        auState[3] = SymTable_rotate(auState[3], 21) ^ auState[0];
+        auState[2] += auState[1];
+        auState[1] = SymTable_rotate(auState[1], 17) ^ auState[2];
+        auState[2] = SymTable_rotate(auState[2], 32);
     }
+}
 
-    /* Copies all keys from the old hash table to the new hash table. */
-    bucket = 0;
-    while(bucket < auBucketCounts[oSymTable->buckets]) {
-        psCurrentBinding = oSymTable->psHashTable[bucket];
-        while(psCurrentBinding != NULL) {
-            int success = SymTable_put(oNewSymTable, 
-            psCurrentBinding->pcKey, psCurrentBinding->pvValue);
-            
-            /* Checks all keys are successfully copied. */
-            if(success == 0) {
-                free(oNewSymTable);
-                return; 
-            }
+/* Returns the uCount bytes at puc, at most 8, as a little-endian
+integer. */
+static uint64_t SymTable_readLittle(const unsigned char *puc,
+size_t uCount) {
+    uint64_t u = 0;
 
-            psCurrentBinding = psCurrentBinding->psNextBinding;
-        }
-        bucket++;
+    while(uCount > 0) {
+        uCount--;
+        u = (u << 8) | puc[uCount];
     }
-    /* transfers new expanded hash table to symbol table */
-    psOldHashTable = oSymTable->psHashTable;
-    oSymTable->psHashTable = oNewSymTable->psHashTable;
-    (oSymTable->buckets)++;
+    return u;
+}
+
+/* Return the SipHash of the uLength characters at pcKey under the
+128-bit key auSeed[0..1]. */
+static size_t SymTable_sipHash(const uint64_t *auSeed,
+const char *pcKey, size_t uLength) {
+    const unsigned char *puc = (const unsigned char *)pcKey;
+    uint64_t auState[4];
+    uint64_t uWord;
+    size_t u;
 
-    /* frees temporary symbol table and old hash table */
-    (oNewSymTable->buckets)--;
-    oNewSymTable->psHashTable = psOldHashTable;
-    SymTable_free(oNewSymTable);
+    auState[0] = auSeed[0] ^ 0x736f6d6570736575U;
+    auState[1] = auSeed[1] ^ 0x646f72616e646f6dU;
+    auState[2] = auSeed[0] ^ 0x6c7967656e657261U;
+    auState[3] = auSeed[1] ^ 0x7465646279746573U;
 
-    return;
+    for(u = 0; u + 8 <= uLength; u += 8) {
+        uWord = SymTable_readLittle(puc + u, 8);
+        auState[3] ^= uWord;
+        SymTable_sipRounds(auState, SIP_ROUNDS);
+        auState[0] ^= uWord;
+    }
+    uWord = SymTable_readLittle(puc + u, uLength - u)
+    | ((uint64_t)uLength << 56);
+    auState[3] ^= uWord;
+    SymTable_sipRounds(auState, SIP_ROUNDS);
+    auState[0] ^= uWord;
+
+    auState[2] ^= 0xff;
+    SymTable_sipRounds(auState, SIP_FINAL_ROUNDS);
+    return (size_t)(auState[0] ^ auState[1] ^ auState[2] ^ auState[3]);
 }
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey, 
-const void *pvValue) {
-    struct Binding *psNewBinding;
-    size_t KeyHash;
-    
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+/* Return the hash code oSymTable uses for pcKey: the compiled-in
+function's, or the SipHash under its seed if SymTable_seed has given
+it one. Store the length of pcKey in *puLength. */
+static size_t SymTable_tableHash(SymTable_T oSymTable,
+const char *pcKey, size_t *puLength) {
+    SymTable_count(oSymTable, hashes);
+    if(oSymTable->iSeeded) {
+        *puLength = strlen(pcKey);
+        return SymTable_sipHash(oSymTable->auSeed, pcKey, *puLength);
+    }
+    return SymTable_hash(pcKey, puLength);
+}
 
-    /* checks if the symbol table aready contains the key */
-    if(SymTable_contains(oSymTable, pcKey)) {
+/* Return the hash code oSymTable uses for the uLength characters at
+pcKey, without counting it. Only reads oSymTable. */
+static size_t SymTable_readHashN(SymTable_T oSymTable,
+const char *pcKey, size_t uLength) {
+    if(oSymTable->iSeeded) {
+        return SymTable_sipHash(oSymTable->auSeed, pcKey, uLength);
+    }
+    return SymTable_hashN(pcKey, uLength);
+}
+
+/* Return the hash code oSymTable uses for the uLength characters at
+pcKey. */
+static size_t SymTable_tableHashN(SymTable_T oSymTable,
+const char *pcKey, size_t uLength) {
+    SymTable_count(oSymTable, hashes);
+    return SymTable_readHashN(oSymTable, pcKey, uLength);
+}
+
+/* Returns 1 (TRUE) if oSymTable1 and oSymTable2 give every key the
+same hash code, and 0 (FALSE) if not. */
+static int SymTable_hashesAlike(SymTable_T oSymTable1,
+SymTable_T oSymTable2) {
+    if(oSymTable1->iSeeded != oSymTable2->iSeeded) {
         return 0;
     }
+    return !oSymTable1->iSeeded
+    || (oSymTable1->auSeed[0] == oSymTable2->auSeed[0]
+    && oSymTable1->auSeed[1] == oSymTable2->auSeed[1]);
+}
 
-    /* checks if the symbol table should be expanded. */
-    if(oSymTable->bindings == auBucketCounts[oSymTable->buckets]) {
-        SymTable_expand(oSymTable);
+/* Returns 1 (TRUE) if pcStoredKey, a '\0'-terminated stored key, equals
+the uLength characters at pcKey, and 0 (FALSE) if not. Neither key is
+read past its end: the comparison stops at the '\0' of pcStoredKey, and
+only reads pcStoredKey[uLength] once the first uLength characters have
+matched. A key stored at address pcKey matches without comparing
+characters. */
+static int SymTable_keyEquals(const char *pcStoredKey,
+const char *pcKey, size_t uLength) {
+    return (pcStoredKey == pcKey
+    || !strncmp(pcStoredKey, pcKey, uLength))
+    && pcStoredKey[uLength] == '\0';
+}
+
+/* Returns the atom for the key of uLength characters at pcKey with
+hash code uHash in oSymTable, or NULL if the key has not been
+interned. */
+static struct SymAtom *SymTable_findAtom(SymTable_T oSymTable,
+const char *pcKey, size_t uLength, size_t uHash) {
+    struct SymAtom *psAtom;
+
+    if(oSymTable->psAtomTable == NULL) {
+        return NULL;
+    }
+
+    psAtom = oSymTable->psAtomTable[SymTable_bucketOf(uHash,
+    oSymTable->atomBucketCount)];
+    while(psAtom != NULL) {
+        SymTable_count(oSymTable, nodesVisited);
+        if(psAtom->uHash == uHash && psAtom->uLength == uLength) {
+            SymTable_count(oSymTable, keyCompares);
+            if(SymTable_keyEquals(psAtom->acKey, pcKey, uLength)) {
+                return psAtom;
+            }
+        }
+        psAtom = psAtom->psNextAtom;
     }
+    return NULL;
+}
 
-    /* allocates memory for new binding and copy of pcKey */    
+/* Returns a new binding holding a '\0'-terminated copy of the key of
+uLength characters at pcKey, or NULL if there is insufficient memory.
+If psAtom is not NULL, the binding shares the atom's copy of the key
+instead. A key shorter than SYMTABLE_INLINE_KEY bytes is copied into
+the binding itself. With SYMTABLE_ARENA, the binding and a longer
+key's copy come from the arena of oSymTable instead of from malloc. */
+static struct Binding *SymTable_newBinding(SymTable_T oSymTable,
+const char *pcKey, size_t uLength, const struct SymAtom *psAtom) {
+    struct Binding *psNewBinding;
+
+#ifdef SYMTABLE_ARENA
+    psNewBinding = (struct Binding*)SymArena_alloc(oSymTable->oArena);
+#else
     psNewBinding = (struct Binding*)malloc(sizeof(struct Binding));
+#endif
     if (psNewBinding == NULL) {
-        return 0;
+        return NULL;
     }
-    psNewBinding->pcKey = (char *)malloc((strlen(pcKey) + 1));
-    if(psNewBinding->pcKey == NULL) {
-        free(psNewBinding);  
-        return 0;
+    SymTable_count(oSymTable, mallocs);
+#ifndef SYMTABLE_ARENA
+    oSymTable->bytes += sizeof(struct Binding);
+#endif
+    psNewBinding->ucInBlock = 0;
+
+    /* the atom owns the key, so the binding need not copy it */
+    if(psAtom != NULL) {
+        psNewBinding->pcKey = (char *)psAtom->acKey;
+        return psNewBinding;
     }
 
-    /* initializes values of psNewBinding */
-    KeyHash = SymTable_hash(pcKey, auBucketCounts[oSymTable->buckets]);
-    strcpy(psNewBinding->pcKey, pcKey);
-    psNewBinding->pvValue = (void *) pvValue;
-    psNewBinding->psNextBinding = 
-    (oSymTable->psHashTable)[KeyHash];
-    
-    /* updates oSymTable parameters */
-    (oSymTable->psHashTable)[KeyHash] = psNewBinding;
-    (oSymTable->bindings)++;
+#if SYMTABLE_INLINE_KEY > 0
+    if(uLength < SYMTABLE_INLINE_KEY) {
+        psNewBinding->pcKey = psNewBinding->acInlineKey;
+        memcpy(psNewBinding->pcKey, pcKey, uLength);
+        psNewBinding->pcKey[uLength] = '\0';
+        return psNewBinding;
+    }
+#endif
 
-    return 1;
+    /* a longer key spills into memory of its own */
+#ifdef SYMTABLE_ARENA
+    psNewBinding->pcKey =
+    SymArena_copyString(oSymTable->oArena, pcKey, uLength);
+    if(psNewBinding->pcKey == NULL) {
+        SymArena_release(oSymTable->oArena, psNewBinding);
+        SymTable_count(oSymTable, frees);
+        return NULL;
+    }
+    SymTable_count(oSymTable, mallocs);
+#else
+    psNewBinding->pcKey = (char *)malloc(uLength + 1);
+    if(psNewBinding->pcKey == NULL) {
+        free(psNewBinding);
+        SymTable_count(oSymTable, frees);
+        oSymTable->bytes -= sizeof(struct Binding);
+        return NULL;
+    }
+    SymTable_count(oSymTable, mallocs);
+    oSymTable->bytes += uLength + 1;
+    memcpy(psNewBinding->pcKey, pcKey, uLength);
+    psNewBinding->pcKey[uLength] = '\0';
+#endif
+
+    return psNewBinding;
 }
 
-void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
-const void *pvValue) {
-    struct Binding *psChecker;
-    void *pvTempValue;
-    size_t KeyHash;
-    
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+#ifndef SYMTABLE_ARENA
+/* Returns 1 (TRUE) if the key of psBinding in oSymTable is stored in
+memory of its own, and 0 (FALSE) if it is stored in the binding or
+shared with an atom. */
+static int SymTable_ownsKey(SymTable_T oSymTable,
+struct Binding *psBinding) {
+    struct SymAtom *psAtom;
+
+#if SYMTABLE_INLINE_KEY > 0
+    if(psBinding->pcKey == psBinding->acInlineKey) {
+        return 0;
+    }
+#endif
 
-    KeyHash = SymTable_hash(pcKey, auBucketCounts[oSymTable->buckets]);
-    
-    /* checks the appropriate hash bucket for pcKey and replaces the
-    value if found*/
-    psChecker = oSymTable->psHashTable[KeyHash];
-    while(psChecker != NULL) {
-        if(!strcmp(psChecker->pcKey, pcKey)) {
-            pvTempValue = psChecker->pvValue;
-            psChecker->pvValue = (void *) pvValue;
-            return pvTempValue;
+    /* a shared key is the very string of an atom with the same hash
+    code, so comparing addresses is enough */
+    if(oSymTable->psAtomTable == NULL) {
+        return 1;
+    }
+    psAtom = oSymTable->psAtomTable[SymTable_bucketOf(psBinding->uHash,
+    oSymTable->atomBucketCount)];
+    while(psAtom != NULL) {
+        if(psAtom->acKey == psBinding->pcKey) {
+            return 0;
         }
-        psChecker = psChecker->psNextBinding;
+        psAtom = psAtom->psNextAtom;
     }
-        
-    return NULL;
+    return 1;
 }
+#endif
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
-    struct Binding *psChecker;
-    size_t KeyHash;
+/* Frees psBinding and its key. With SYMTABLE_ARENA, the binding goes
+back to the arena of oSymTable for reuse and the bytes of a spilled
+key are reclaimed only when oSymTable is freed. A key shared with an
+atom lives as long as the atom. A binding put by SymTable_putBulk, and
+its key, live as long as their block. */
+static void SymTable_freeBinding(SymTable_T oSymTable,
+struct Binding *psBinding) {
+    if(psBinding->ucInBlock) {
+        return;
+    }
 
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+#ifdef SYMTABLE_ARENA
+    SymArena_release(oSymTable->oArena, psBinding);
+#else
+    if(SymTable_ownsKey(oSymTable, psBinding)) {
+        oSymTable->bytes -= strlen(psBinding->pcKey) + 1;
+        free(psBinding->pcKey);
+        SymTable_count(oSymTable, frees);
+    }
+    free(psBinding);
+    oSymTable->bytes -= sizeof(struct Binding);
+#endif
+    SymTable_count(oSymTable, frees);
+}
 
-    KeyHash = SymTable_hash(pcKey, auBucketCounts[oSymTable->buckets]);
+#ifndef SYMTABLE_ARENA
+/* Frees every binding in the chain beginning at psCurrentBinding. */
+static void SymTable_freeChain(SymTable_T oSymTable,
+struct Binding *psCurrentBinding) {
+    struct Binding *psNextBinding;
 
-    /* checks each binding of the appropriate hash bucket for pcKey */
-    psChecker = (oSymTable->psHashTable)[KeyHash];
-    while(psChecker != NULL) {
-        if(!strcmp(psChecker->pcKey, pcKey)) {
-            return 1;
-        }
-        psChecker = psChecker->psNextBinding;
+    while(psCurrentBinding != NULL) {
+        psNextBinding = psCurrentBinding->psNextBinding;
+        SymTable_freeBinding(oSymTable, psCurrentBinding);
+        psCurrentBinding = psNextBinding;
     }
-
-    return 0;
 }
+#endif
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
-    struct Binding *psChecker;
-    size_t KeyHash;
+void SymTable_free(SymTable_T oSymTable) {
+    struct SymAtom *psAtom;
+    struct SymAtom *psNextAtom;
+    struct BulkBlock *psNextBlock;
+    size_t bucket;
 
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
 
-    KeyHash = SymTable_hash(pcKey, auBucketCounts[oSymTable->buckets]);
-   
-    /* checks the appropriate hash bucket for pcKey and returns value
-    if found */
-    psChecker = (oSymTable->psHashTable)[KeyHash];
-    while(psChecker != NULL) {
-        if(!strcmp(psChecker->pcKey, pcKey)) {
-            return psChecker->pvValue;
+#ifdef SYMTABLE_ARENA
+    /* frees every binding and key at once */
+    SymArena_free(oSymTable->oArena);
+#else
+
+    /* frees each binding in each of the buckets of the hash table */
+    for(bucket = 0; bucket < oSymTable->bucketCount; bucket++) {
+        SymTable_freeChain(oSymTable, oSymTable->psHashTable[bucket]);
+    }
+
+    /* frees the bindings not yet moved out of the old hash table */
+    if(oSymTable->psOldHashTable != NULL) {
+        for(bucket = oSymTable->migrated;
+        bucket < oSymTable->oldBucketCount; bucket++) {
+            SymTable_freeChain(oSymTable,
+            oSymTable->psOldHashTable[bucket]);
         }
-        psChecker = psChecker->psNextBinding;
     }
+#endif
 
-    return NULL;
-}
+    /* frees the blocks of bulk-loaded bindings, after the bindings
+    that skipped freeing themselves because they lie in a block */
+    while(oSymTable->psBulkBlocks != NULL) {
+        psNextBlock = oSymTable->psBulkBlocks->psNextBlock;
+        free(oSymTable->psBulkBlocks);
+        oSymTable->psBulkBlocks = psNextBlock;
+    }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
-    struct Binding *psCurrent;
-    struct Binding *psPrevious;
-    void *pvTempValue;
-    size_t KeyHash;
-    
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
-    
-    KeyHash = SymTable_hash(pcKey, auBucketCounts[oSymTable->buckets]);
-    
-     /* checks for empty bucket */
-    if((oSymTable->psHashTable)[KeyHash] == NULL) {
-        return NULL;
+    /* frees every atom, after the bindings that may share their
+    keys */
+    if(oSymTable->psAtomTable != NULL) {
+        for(bucket = 0; bucket < oSymTable->atomBucketCount; bucket++) {
+            psAtom = oSymTable->psAtomTable[bucket];
+            while(psAtom != NULL) {
+                psNextAtom = psAtom->psNextAtom;
+                free(psAtom);
+                psAtom = psNextAtom;
+            }
+        }
+        free(oSymTable->psAtomTable);
     }
-    
-    /* checks if first binding in appropriate hash bucket contains 
-    pcKey. Removes it if it does */
-    psCurrent = (oSymTable->psHashTable)[KeyHash];
-    if(!strcmp(psCurrent->pcKey, pcKey)) {
-        (oSymTable->psHashTable)[KeyHash] = psCurrent->psNextBinding;
-        free(psCurrent->pcKey);
-        pvTempValue = psCurrent->pvValue;
-        free(psCurrent);
-        (oSymTable->bindings)--;
-        return pvTempValue;
-    }
-
-    /* Checks all subsequent bindings in bucket. Removes it if 
-    if it contain pcKey. */
-    psPrevious = psCurrent;
-    psCurrent = psCurrent->psNextBinding;
-    while(psCurrent != NULL) {
-        if(!strcmp(psCurrent->pcKey, pcKey)) {
-            psPrevious->psNextBinding = psCurrent->psNextBinding;
-            free(psCurrent->pcKey);
-            pvTempValue = psCurrent->pvValue;
-            free(psCurrent);
-            (oSymTable->bindings)--;
-            return pvTempValue;
-        }
-        psPrevious = psCurrent;
-        psCurrent = psCurrent->psNextBinding;
-    } 
 
-    return NULL;
+    /* frees hash table arrays and symbol table */
+    free(oSymTable->psOldHashTable);
+    free(oSymTable->psHashTable);
+    free(oSymTable);
 }
 
-void SymTable_map(SymTable_T oSymTable,
-void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
-const void *pvExtra) {
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_GET_LENGTH]);
+    return oSymTable->bindings;
+}
+
+/* Moves up to MIGRATE_STEP buckets of the old hash table of oSymTable
+into the new one, relinking the existing bindings by their cached hash
+codes without allocating. Frees the old hash table once it is
+empty. */
+static void SymTable_migrate(SymTable_T oSymTable) {
     struct Binding *psCurrentBinding;
-    size_t bucket = 0;
+    struct Binding *psNextBinding;
+    size_t uOldBucketCount;
+    size_t uNewBucketCount;
+    size_t uStep;
+    size_t KeyHash;
 
-    assert(oSymTable != NULL);
-    assert(pfApply != NULL);
+    if(oSymTable->psOldHashTable == NULL) {
+        return;
+    }
 
-    /* applies pfApply to each binding in every bucket */
-    while(bucket < auBucketCounts[oSymTable->buckets]) {
-        psCurrentBinding = oSymTable->psHashTable[bucket];
+    uOldBucketCount = oSymTable->oldBucketCount;
+    uNewBucketCount = oSymTable->bucketCount;
+    for(uStep = 0; uStep < MIGRATE_STEP
+    && oSymTable->migrated < uOldBucketCount; uStep++) {
+        psCurrentBinding =
+        oSymTable->psOldHashTable[oSymTable->migrated];
         while(psCurrentBinding != NULL) {
-            (*pfApply)(psCurrentBinding->pcKey, 
-            psCurrentBinding->pvValue, (void *) pvExtra);
-            psCurrentBinding = psCurrentBinding->psNextBinding;
+            psNextBinding = psCurrentBinding->psNextBinding;
+            KeyHash = SymTable_bucketOf(psCurrentBinding->uHash,
+            uNewBucketCount);
+            psCurrentBinding->psNextBinding =
+            oSymTable->psHashTable[KeyHash];
+            oSymTable->psHashTable[KeyHash] = psCurrentBinding;
+            psCurrentBinding = psNextBinding;
         }
-        bucket++;
+        oSymTable->psOldHashTable[oSymTable->migrated] = NULL;
+        (oSymTable->migrated)++;
     }
-    
+
+    /* the old hash table is empty once every bucket has moved */
+    if(oSymTable->migrated == uOldBucketCount) {
+        free(oSymTable->psOldHashTable);
+        SymTable_count(oSymTable, frees);
+        oSymTable->bytes -= uOldBucketCount * sizeof(struct Binding*);
+        oSymTable->psOldHashTable = NULL;
+        oSymTable->migrated = 0;
+    }
+}
+
+/* Returns 1 (TRUE) if uCandidate is prime and 0 (FALSE) if not. */
+static int SymTable_isPrime(size_t uCandidate) {
+    size_t uDivisor;
+
+    if(uCandidate < 2) {
+        return 0;
+    }
+    for(uDivisor = 2; uDivisor <= uCandidate / uDivisor; uDivisor++) {
+        if(uCandidate % uDivisor == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Returns the bucket count that follows uBucketCount, the bucket
+count at index buckets of the growth sequence. Returns 0 if the hash
+table cannot grow any further. */
+static size_t SymTable_nextBucketCount(size_t buckets,
+size_t uBucketCount) {
+    size_t numBucketCounts =
+    sizeof(auBucketCounts)/sizeof(auBucketCounts[0]);
+    size_t uCandidate;
+
+    if(buckets + 1 < numBucketCounts) {
+        return auBucketCounts[buckets + 1];
+    }
+
+    /* Checks that the doubled bucket array is still addressable */
+    if(uBucketCount > ((size_t)-1 / sizeof(struct Binding *) - 1) / 2) {
+        return 0;
+    }
+
+    /* finds the smallest prime larger than twice uBucketCount. Trial
+    division costs O(sqrt(n)), which is small next to the O(n) of
+    migrating the bindings. */
+    uCandidate = 2 * uBucketCount + 1;
+    while(!SymTable_isPrime(uCandidate)) {
+        uCandidate += 2;
+    }
+
+#if SYMTABLE_HASH != SYMTABLE_HASH_65599
+    /* SymTable_bucketOf only spreads codes over fewer than 2^32
+    buckets */
+    if((uint64_t)uCandidate > 0xffffffffU) {
+        return 0;
+    }
+#endif
+    return uCandidate;
+}
+
+/* Returns the bucket count at index buckets of the growth sequence,
+or 0 if the hash table cannot grow that far. Walks the sequence from
+its start, which costs a few prime searches past the end of
+auBucketCounts. */
+static size_t SymTable_bucketCountAt(size_t buckets) {
+    size_t uBucketCount = auBucketCounts[0];
+    size_t u;
+
+    for(u = 0; u < buckets && uBucketCount != 0; u++) {
+        uBucketCount = SymTable_nextBucketCount(u, uBucketCount);
+    }
+    return uBucketCount;
+}
+
+/* Starts moving oSymTables bindings into a new hash table of
+newBucketCount buckets, the bucket count at index newBuckets of the
+growth sequence. The current hash table becomes the old one and is
+drained by later calls to SymTable_migrate. If not possible, will not
+change oSymTable. */
+static void SymTable_resize(SymTable_T oSymTable, size_t newBuckets,
+size_t newBucketCount) {
+    struct Binding **psNewHashTable;
+
+    /* A resize still in progress has to finish first. */
+    while(oSymTable->psOldHashTable != NULL) {
+        SymTable_migrate(oSymTable);
+    }
+
+    /* Allocates the new hash table. If not possible, maintains the
+    original hash table. */
+    psNewHashTable = (struct Binding**)
+    calloc(sizeof(struct Binding*), newBucketCount);
+    if(psNewHashTable == NULL) {
+        return;
+    }
+    SymTable_count(oSymTable, mallocs);
+    oSymTable->bytes += newBucketCount * sizeof(struct Binding*);
+    (oSymTable->resizes)++;
+
+    oSymTable->psOldHashTable = oSymTable->psHashTable;
+    oSymTable->oldBucketCount = oSymTable->bucketCount;
+    oSymTable->psHashTable = psNewHashTable;
+    oSymTable->bucketCount = newBucketCount;
+    oSymTable->buckets = newBuckets;
+    oSymTable->migrated = 0;
+
+    return;
+}
+
+/* Starts expanding oSymTables hash table to the next bucket count of
+the growth sequence. If not possible, will not change oSymTable. */
+static void SymTable_expand(SymTable_T oSymTable) {
+    size_t newBucketCount;
+#ifdef SYMTABLE_INSTRUMENT
+    clock_t tStart = clock();
+#endif
+
+    /* Checks if it is possible to add more buckets */
+    newBucketCount = SymTable_nextBucketCount(oSymTable->buckets,
+    oSymTable->bucketCount);
+    if(newBucketCount != 0) {
+        SymTable_resize(oSymTable, oSymTable->buckets + 1,
+        newBucketCount);
+    }
+
+#ifdef SYMTABLE_INSTRUMENT
+    oSymTable->sCounters.expandTicks += clock() - tStart;
+    (oSymTable->sCounters.expands)++;
+#endif
+}
+
+/* Starts shrinking oSymTables hash table to the previous bucket count
+of the growth sequence. If not possible, will not change oSymTable. */
+static void SymTable_shrink(SymTable_T oSymTable) {
+    assert(oSymTable->buckets > 0);
+
+    SymTable_resize(oSymTable, oSymTable->buckets - 1,
+    SymTable_bucketCountAt(oSymTable->buckets - 1));
+}
+
+/* Returns the address of the link that points to the binding with the
+key of uLength characters at pcKey in oSymTable, or NULL if oSymTable
+does not contain that key. The link is either a bucket or the
+psNextBinding of the preceding binding. uHash must be the hash code of
+the key. */
+static struct Binding **SymTable_findLink(SymTable_T oSymTable,
+const char *pcKey, size_t uLength, size_t uHash) {
+    struct Binding **ppsLink;
+    size_t KeyHash;
+
+    /* bindings in buckets of the old hash table that have not moved
+    yet are still found there */
+    if(oSymTable->psOldHashTable != NULL) {
+        KeyHash = SymTable_bucketOf(uHash, oSymTable->oldBucketCount);
+        if(KeyHash >= oSymTable->migrated) {
+            ppsLink = &(oSymTable->psOldHashTable)[KeyHash];
+            while(*ppsLink != NULL) {
+                SymTable_count(oSymTable, nodesVisited);
+                if((*ppsLink)->uHash == uHash) {
+                    SymTable_count(oSymTable, keyCompares);
+                    if(SymTable_keyEquals((*ppsLink)->pcKey, pcKey,
+                    uLength)) {
+                        return ppsLink;
+                    }
+                }
+                ppsLink = &(*ppsLink)->psNextBinding;
+            }
+        }
+    }
+
+    /* checks each binding of the appropriate hash bucket for pcKey */
+    KeyHash = SymTable_bucketOf(uHash, oSymTable->bucketCount);
+    ppsLink = &(oSymTable->psHashTable)[KeyHash];
+    while(*ppsLink != NULL) {
+        SymTable_count(oSymTable, nodesVisited);
+        if((*ppsLink)->uHash == uHash) {
+            SymTable_count(oSymTable, keyCompares);
+            if(SymTable_keyEquals((*ppsLink)->pcKey, pcKey, uLength)) {
+                return ppsLink;
+            }
+        }
+        ppsLink = &(*ppsLink)->psNextBinding;
+    }
+
+    return NULL;
+}
+
+/* Returns the binding of the key of uLength characters at pcKey, whose
+hash code is uHash, in oSymTable. If there is none, first puts a new
+binding of the key with a NULL value, sharing the key of psAtom if
+psAtom is not NULL. Sets *piInserted to 1 (TRUE) if the binding is new
+and to 0 (FALSE) if not. Returns NULL if there is insufficient
+memory. */
+static struct Binding *SymTable_findOrInsertKey(SymTable_T oSymTable,
+const char *pcKey, size_t uLength, size_t uHash,
+const struct SymAtom *psAtom, int *piInserted) {
+    struct Binding **ppsLink;
+    struct Binding *psNewBinding;
+    size_t KeyHash;
+
+    SymTable_migrate(oSymTable);
+
+    /* checks if the symbol table aready contains the key */
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash);
+    if(ppsLink != NULL) {
+        *piInserted = 0;
+        return *ppsLink;
+    }
+
+    /* checks if the symbol table should be expanded. */
+    if(oSymTable->bindings >= oSymTable->bucketCount) {
+        SymTable_expand(oSymTable);
+    }
+
+    /* allocates memory for new binding and copy of pcKey */
+    psNewBinding = SymTable_newBinding(oSymTable, pcKey, uLength,
+    psAtom);
+    if (psNewBinding == NULL) {
+        return NULL;
+    }
+
+    /* initializes values of psNewBinding. New bindings always go into
+    the new hash table. */
+    KeyHash = SymTable_bucketOf(uHash, oSymTable->bucketCount);
+    psNewBinding->pvValue = NULL;
+    psNewBinding->uHash = uHash;
+    psNewBinding->psNextBinding =
+    (oSymTable->psHashTable)[KeyHash];
+
+    /* updates oSymTable parameters */
+    (oSymTable->psHashTable)[KeyHash] = psNewBinding;
+    (oSymTable->bindings)++;
+
+    *piInserted = 1;
+    return psNewBinding;
+}
+
+/* Puts the binding of the key of uLength characters at pcKey, whose
+hash code is uHash, and pvValue into oSymTable, sharing the key of
+psAtom if psAtom is not NULL. Behaves like SymTable_put otherwise. */
+static int SymTable_putKey(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash, const struct SymAtom *psAtom,
+const void *pvValue) {
+    struct Binding *psBinding;
+    int iInserted;
+
+    psBinding = SymTable_findOrInsertKey(oSymTable, pcKey, uLength,
+    uHash, psAtom, &iInserted);
+    if(psBinding == NULL || !iInserted) {
+        return 0;
+    }
+
+    psBinding->pvValue = (void *) pvValue;
+    return 1;
+}
+
+/* Replaces the value of the binding of the key of uLength characters
+at pcKey, whose hash code is uHash, in oSymTable. Behaves like
+SymTable_replace otherwise. */
+static void *SymTable_replaceKey(SymTable_T oSymTable,
+const char *pcKey, size_t uLength, size_t uHash,
+const void *pvValue) {
+    struct Binding **ppsLink;
+    void *pvTempValue;
+
+    SymTable_migrate(oSymTable);
+
+    /* replaces the value of the binding with pcKey if found */
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash);
+    if(ppsLink == NULL) {
+        return NULL;
+    }
+
+    pvTempValue = (*ppsLink)->pvValue;
+    (*ppsLink)->pvValue = (void *) pvValue;
+    return pvTempValue;
+}
+
+/* Returns the binding of the key of uLength characters at pcKey, whose
+hash code is uHash, in oSymTable, or NULL if oSymTable does not contain
+that key. */
+static struct Binding *SymTable_getKey(SymTable_T oSymTable,
+const char *pcKey, size_t uLength, size_t uHash) {
+    struct Binding **ppsLink;
+
+    SymTable_migrate(oSymTable);
+
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash);
+    if(ppsLink == NULL) {
+        return NULL;
+    }
+    return *ppsLink;
+}
+
+/* Returns the value of the binding of the key of uLength characters at
+pcKey, whose hash code is uHash, in oSymTable, or NULL if oSymTable
+does not contain that key. */
+static void *SymTable_getValue(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash) {
+    struct Binding *psBinding;
+
+    psBinding = SymTable_getKey(oSymTable, pcKey, uLength, uHash);
+    if(psBinding == NULL) {
+        return NULL;
+    }
+    return psBinding->pvValue;
+}
+
+/* Removes the binding of the key of uLength characters at pcKey, whose
+hash code is uHash, from oSymTable. Behaves like SymTable_remove
+otherwise. */
+static void *SymTable_removeKey(SymTable_T oSymTable,
+const char *pcKey, size_t uLength, size_t uHash) {
+    struct Binding **ppsLink;
+    struct Binding *psCurrent;
+    void *pvTempValue;
+
+    SymTable_migrate(oSymTable);
+
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uLength, uHash);
+    if(ppsLink == NULL) {
+        return NULL;
+    }
+
+    /* unlinks the binding with pcKey from its bucket and frees it */
+    psCurrent = *ppsLink;
+    *ppsLink = psCurrent->psNextBinding;
+    pvTempValue = psCurrent->pvValue;
+    SymTable_freeBinding(oSymTable, psCurrent);
+    (oSymTable->bindings)--;
+
+    /* Shrinks once the table is a quarter full. The shrunken table is
+    half full, so it takes many puts or removes before it resizes
+    again. A shrink waits for the previous resize to finish moving its
+    buckets, which would otherwise all move at once; a later remove
+    checks again. */
+    if(oSymTable->psOldHashTable == NULL
+    && oSymTable->buckets > oSymTable->reservedBuckets
+    && oSymTable->bindings < oSymTable->bucketCount / 4) {
+        SymTable_shrink(oSymTable);
+    }
+
+    return pvTempValue;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_PUT]);
+
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    return SymTable_putKey(oSymTable, pcKey, uLength, uHash, NULL,
+    pvValue);
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REPLACE]);
+
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    return SymTable_replaceKey(oSymTable, pcKey, uLength, uHash,
+    pvValue);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_CONTAINS]);
+
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    return SymTable_getKey(oSymTable, pcKey, uLength, uHash) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_GET]);
+
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    return SymTable_getValue(oSymTable, pcKey, uLength, uHash);
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REMOVE]);
+
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    return SymTable_removeKey(oSymTable, pcKey, uLength, uHash);
+}
+
+void **SymTable_findOrInsert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted) {
+    struct Binding *psBinding;
+    size_t uLength;
+    size_t uHash;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_FIND_OR_INSERT]);
+
+    /* one hash and one walk of a chain serve both the lookup and the
+    insertion */
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    psBinding = SymTable_findOrInsertKey(oSymTable, pcKey, uLength,
+    uHash, NULL, &iInserted);
+    if(psBinding == NULL) {
+        return NULL;
+    }
+
+    if(piInserted != NULL) {
+        *piInserted = iInserted;
+    }
+    return &psBinding->pvValue;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    struct Binding *psBinding;
+    size_t uLength;
+    size_t uHash;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_UPSERT]);
+
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    psBinding = SymTable_findOrInsertKey(oSymTable, pcKey, uLength,
+    uHash, NULL, &iInserted);
+    if(psBinding == NULL) {
+        return 0;
+    }
+    psBinding->pvValue = (void *) pvValue;
+    return 1;
+}
+
+/* Fills the SYMTABLE_SEED_LENGTH bytes at pucSeed with random bytes
+for oSymTable, read from /dev/urandom. Where that cannot be read, they
+are made instead by hashing the time, the processor time, the address
+of oSymTable, and a count of the calls, which differ between tables
+and between runs but could be guessed. */
+static void SymTable_randomSeed(SymTable_T oSymTable,
+unsigned char *pucSeed) {
+    static const uint64_t auFallbackKey[2] = {0x0123456789abcdefU,
+    0xfedcba9876543210U};
+    static size_t uCalls = 0;
+    struct {
+        time_t tNow;
+        clock_t tClock;
+        SymTable_T oSymTable;
+        size_t uCall;
+    } sSources;
+    FILE *psFile;
+    uint64_t uWord;
+    size_t uRead = 0;
+    size_t u;
+
+    psFile = fopen("/dev/urandom", "rb");
+    if(psFile != NULL) {
+        uRead = fread(pucSeed, 1, SYMTABLE_SEED_LENGTH, psFile);
+        fclose(psFile);
+    }
+    if(uRead == SYMTABLE_SEED_LENGTH) {
+        return;
+    }
+
+    memset(&sSources, 0, sizeof(sSources));
+    sSources.tNow = time(NULL);
+    sSources.tClock = clock();
+    sSources.oSymTable = oSymTable;
+    sSources.uCall = uCalls++;
+    for(u = 0; u < SYMTABLE_SEED_LENGTH; u += sizeof(uWord)) {
+        sSources.uCall ^= u;
+        uWord = SymTable_sipHash(auFallbackKey,
+        (const char *)&sSources, sizeof(sSources));
+        memcpy(pucSeed + u, &uWord, sizeof(uWord));
+    }
+}
+
+int SymTable_seed(SymTable_T oSymTable, const unsigned char *pucSeed) {
+    unsigned char aucRandom[SYMTABLE_SEED_LENGTH];
+
+    assert(oSymTable != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_SEED]);
+
+    /* the codes of bindings and atoms already made would be wrong */
+    if(oSymTable->bindings != 0 || oSymTable->atoms != 0) {
+        return 0;
+    }
+
+    if(pucSeed == NULL) {
+        SymTable_randomSeed(oSymTable, aucRandom);
+        pucSeed = aucRandom;
+    }
+    oSymTable->auSeed[0] = SymTable_readLittle(pucSeed, 8);
+    oSymTable->auSeed[1] = SymTable_readLittle(pucSeed + 8, 8);
+    oSymTable->iSeeded = 1;
+    return 1;
+}
+
+size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey,
+size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* threads may hash with one table at once, so this counts
+    nothing */
+    return SymTable_readHashN(oSymTable, pcKey, uLength);
+}
+
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_PUT_N]);
+
+    return SymTable_putKey(oSymTable, pcKey, uLength,
+    SymTable_tableHashN(oSymTable, pcKey, uLength), NULL, pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REPLACE_N]);
+
+    return SymTable_replaceKey(oSymTable, pcKey, uLength,
+    SymTable_tableHashN(oSymTable, pcKey, uLength), pvValue);
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_CONTAINS_N]);
+
+    return SymTable_getKey(oSymTable, pcKey, uLength,
+    SymTable_tableHashN(oSymTable, pcKey, uLength)) != NULL;
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_GET_N]);
+
+    return SymTable_getValue(oSymTable, pcKey, uLength,
+    SymTable_tableHashN(oSymTable, pcKey, uLength));
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REMOVE_N]);
+
+    return SymTable_removeKey(oSymTable, pcKey, uLength,
+    SymTable_tableHashN(oSymTable, pcKey, uLength));
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_PUT_HASHED]);
+
+    return SymTable_putKey(oSymTable, pcKey, uLength, uHash, NULL,
+    pvValue);
+}
+
+void *SymTable_replaceHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash, const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REPLACE_HASHED]);
+
+    return SymTable_replaceKey(oSymTable, pcKey, uLength, uHash,
+    pvValue);
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_CONTAINS_HASHED]);
+
+    return SymTable_getKey(oSymTable, pcKey, uLength, uHash) != NULL;
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_GET_HASHED]);
+
+    return SymTable_getValue(oSymTable, pcKey, uLength, uHash);
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REMOVE_HASHED]);
+
+    return SymTable_removeKey(oSymTable, pcKey, uLength, uHash);
+}
+
+size_t SymTable_getMany(SymTable_T oSymTable,
+const char *const *ppcKeys, size_t uCount, void **ppvValues) {
+    size_t auHash[BATCH_GROUP];
+    size_t auLength[BATCH_GROUP];
+    struct Binding **apsBucket[BATCH_GROUP];
+    struct Binding **ppsLink;
+    size_t uFirst;
+    size_t uGroupCount;
+    size_t u;
+    size_t uFound = 0;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL);
+    assert(ppvValues != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_GET_MANY]);
+
+    /* the batch counts as one operation towards a resize */
+    SymTable_migrate(oSymTable);
+
+    for(uFirst = 0; uFirst < uCount; uFirst += uGroupCount) {
+        uGroupCount = uCount - uFirst;
+        if(uGroupCount > BATCH_GROUP) {
+            uGroupCount = BATCH_GROUP;
+        }
+
+        /* hashes every key of the group and prefetches its bucket.
+        Bindings not yet moved out of the old hash table are found
+        through their old bucket, which is prefetched as well. */
+        for(u = 0; u < uGroupCount; u++) {
+            assert(ppcKeys[uFirst + u] != NULL);
+            auHash[u] = SymTable_tableHash(oSymTable,
+            ppcKeys[uFirst + u], &auLength[u]);
+            apsBucket[u] = &(oSymTable->psHashTable)
+            [SymTable_bucketOf(auHash[u], oSymTable->bucketCount)];
+            SymTable_prefetch(apsBucket[u]);
+            if(oSymTable->psOldHashTable != NULL) {
+                SymTable_prefetch(&(oSymTable->psOldHashTable)
+                [SymTable_bucketOf(auHash[u],
+                oSymTable->oldBucketCount)]);
+            }
+        }
+
+        /* prefetches the first binding of each chain, whose bucket has
+        had the whole first pass to arrive */
+        for(u = 0; u < uGroupCount; u++) {
+            if(*apsBucket[u] != NULL) {
+                SymTable_prefetch(*apsBucket[u]);
+            }
+        }
+
+        /* resolves the keys of the group, most of whose bindings are
+        in the cache by now */
+        for(u = 0; u < uGroupCount; u++) {
+            ppsLink = SymTable_findLink(oSymTable, ppcKeys[uFirst + u],
+            auLength[u], auHash[u]);
+            if(ppsLink == NULL) {
+                ppvValues[uFirst + u] = NULL;
+            }
+            else {
+                ppvValues[uFirst + u] = (*ppsLink)->pvValue;
+                uFound++;
+            }
+        }
+    }
+
+    return uFound;
+}
+
+/* Finds the first bucket count of the growth sequence that holds
+uCapacity bindings. Stores its index in *puBuckets and the count in
+*puBucketCount. Returns 1 (TRUE) if successful and 0 (FALSE) if the
+hash table cannot grow that large. */
+static int SymTable_bucketCountFor(size_t uCapacity, size_t *puBuckets,
+size_t *puBucketCount) {
+    size_t buckets = 0;
+    size_t uBucketCount = auBucketCounts[0];
+
+    while(uBucketCount < uCapacity) {
+        uBucketCount = SymTable_nextBucketCount(buckets, uBucketCount);
+        if(uBucketCount == 0) {
+            return 0;
+        }
+        buckets++;
+    }
+
+    *puBuckets = buckets;
+    *puBucketCount = uBucketCount;
+    return 1;
+}
+
+/* Moves every binding of oSymTable into a new hash table of
+newBucketCount buckets, the bucket count at index newBuckets of the
+growth sequence, at once. Returns 1 (TRUE) if successful and 0 (FALSE)
+if there is insufficient memory, leaving oSymTable unchanged. */
+static int SymTable_rebuild(SymTable_T oSymTable, size_t newBuckets,
+size_t newBucketCount) {
+    struct Binding **psNewHashTable;
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    size_t bucket;
+    size_t KeyHash;
+
+    psNewHashTable = (struct Binding**)
+    calloc(sizeof(struct Binding*), newBucketCount);
+    if(psNewHashTable == NULL) {
+        return 0;
+    }
+    SymTable_count(oSymTable, mallocs);
+
+    /* A resize still in progress has to finish first. */
+    while(oSymTable->psOldHashTable != NULL) {
+        SymTable_migrate(oSymTable);
+    }
+
+    for(bucket = 0; bucket < oSymTable->bucketCount; bucket++) {
+        psCurrentBinding = oSymTable->psHashTable[bucket];
+        while(psCurrentBinding != NULL) {
+            psNextBinding = psCurrentBinding->psNextBinding;
+            KeyHash = SymTable_bucketOf(psCurrentBinding->uHash,
+            newBucketCount);
+            psCurrentBinding->psNextBinding = psNewHashTable[KeyHash];
+            psNewHashTable[KeyHash] = psCurrentBinding;
+            psCurrentBinding = psNextBinding;
+        }
+    }
+
+    free(oSymTable->psHashTable);
+    SymTable_count(oSymTable, frees);
+    oSymTable->bytes -= oSymTable->bucketCount
+    * sizeof(struct Binding*);
+    oSymTable->bytes += newBucketCount * sizeof(struct Binding*);
+    (oSymTable->resizes)++;
+    oSymTable->psHashTable = psNewHashTable;
+    oSymTable->bucketCount = newBucketCount;
+    oSymTable->buckets = newBuckets;
+
+    return 1;
+}
+
+/* Grows the hash table of oSymTable, if needed, so that it holds
+uCapacity bindings, and stores the index of the bucket count that
+does in *puBuckets. Behaves like SymTable_reserve otherwise, but
+reserves nothing. */
+static int SymTable_grow(SymTable_T oSymTable, size_t uCapacity,
+size_t *puBuckets) {
+    size_t newBucketCount;
+
+    if(!SymTable_bucketCountFor(uCapacity, puBuckets,
+    &newBucketCount)) {
+        return 0;
+    }
+
+    /* The caller asked for the space now, so every binding moves at
+    once instead of a few buckets per call. */
+    if(*puBuckets > oSymTable->buckets) {
+        return SymTable_rebuild(oSymTable, *puBuckets, newBucketCount);
+    }
+    return 1;
+}
+
+/* Reserves room for uCapacity bindings in oSymTable, for
+SymTable_reserve and SymTable_newWithCapacity. */
+static int SymTable_reserveCapacity(SymTable_T oSymTable,
+size_t uCapacity) {
+    size_t newBuckets;
+
+    if(!SymTable_grow(oSymTable, uCapacity, &newBuckets)) {
+        return 0;
+    }
+
+    /* removes do not shrink the table below the reserved size */
+    if(newBuckets > oSymTable->reservedBuckets) {
+        oSymTable->reservedBuckets = newBuckets;
+    }
+    return 1;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity) {
+    assert(oSymTable != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_RESERVE]);
+
+    return SymTable_reserveCapacity(oSymTable, uCapacity);
+}
+
+int SymTable_compact(SymTable_T oSymTable) {
+    size_t newBuckets;
+    size_t newBucketCount;
+
+    assert(oSymTable != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_COMPACT]);
+
+    if(!SymTable_bucketCountFor(oSymTable->bindings, &newBuckets,
+    &newBucketCount)) {
+        return 0;
+    }
+    oSymTable->reservedBuckets = 0;
+
+    if(newBuckets == oSymTable->buckets) {
+        /* frees the old hash table of a resize in progress */
+        while(oSymTable->psOldHashTable != NULL) {
+            SymTable_migrate(oSymTable);
+        }
+        return 1;
+    }
+    return SymTable_rebuild(oSymTable, newBuckets, newBucketCount);
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity) {
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if(oSymTable == NULL) {
+        return NULL;
+    }
+    if(!SymTable_reserveCapacity(oSymTable, uCapacity)) {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+int SymTable_putBulk(SymTable_T oSymTable, const char *const *ppcKeys,
+const void *const *ppvValues, size_t uCount, int iUnique) {
+    struct BulkBlock *psBlock;
+    struct Binding *psBinding;
+    char *pcSpill;
+    size_t uBlockSize;
+    size_t uSpillBytes = 0;
+    size_t uPut = 0;
+    size_t uLength;
+    size_t uHash;
+    size_t KeyHash;
+    size_t newBuckets;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL);
+    assert(ppvValues != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_PUT_BULK]);
+
+    if(uCount == 0) {
+        return 1;
+    }
+
+    /* adds up the bytes of the keys too long to be stored in their
+    bindings, which are packed after the bindings */
+    for(u = 0; u < uCount; u++) {
+        assert(ppcKeys[u] != NULL);
+        uLength = strlen(ppcKeys[u]);
+#if SYMTABLE_INLINE_KEY > 0
+        if(uLength < SYMTABLE_INLINE_KEY) {
+            continue;
+        }
+#endif
+        uSpillBytes += uLength + 1;
+    }
+
+    /* checks that the block is addressable */
+    if(uCount > ((size_t)-1 - offsetof(struct BulkBlock, asBindings))
+    / sizeof(struct Binding)) {
+        return 0;
+    }
+    uBlockSize = offsetof(struct BulkBlock, asBindings)
+    + uCount * sizeof(struct Binding);
+    if(uSpillBytes > (size_t)-1 - uBlockSize) {
+        return 0;
+    }
+    uBlockSize += uSpillBytes;
+
+    psBlock = (struct BulkBlock*)malloc(uBlockSize);
+    if(psBlock == NULL) {
+        return 0;
+    }
+    SymTable_count(oSymTable, mallocs);
+
+    /* sizes the hash table once for every key, so that none of the
+    puts below expands it */
+    if(oSymTable->bindings > (size_t)-1 - uCount
+    || !SymTable_grow(oSymTable, oSymTable->bindings + uCount,
+    &newBuckets)) {
+        free(psBlock);
+        SymTable_count(oSymTable, frees);
+        return 0;
+    }
+    pcSpill = (char *)&psBlock->asBindings[uCount];
+
+    SymTable_migrate(oSymTable);
+
+    for(u = 0; u < uCount; u++) {
+        /* unless the caller vouches for the keys, skips each one that
+        is already in oSymTable, including earlier ones of this call */
+        uHash = SymTable_tableHash(oSymTable, ppcKeys[u], &uLength);
+        if(!iUnique && SymTable_findLink(oSymTable, ppcKeys[u], uLength,
+        uHash) != NULL) {
+            continue;
+        }
+
+        psBinding = &psBlock->asBindings[uPut];
+        psBinding->ucInBlock = 1;
+#if SYMTABLE_INLINE_KEY > 0
+        if(uLength < SYMTABLE_INLINE_KEY) {
+            psBinding->pcKey = psBinding->acInlineKey;
+        }
+        else
+#endif
+        {
+            psBinding->pcKey = pcSpill;
+            pcSpill += uLength + 1;
+        }
+        memcpy(psBinding->pcKey, ppcKeys[u], uLength + 1);
+
+        KeyHash = SymTable_bucketOf(uHash, oSymTable->bucketCount);
+        psBinding->pvValue = (void *) ppvValues[u];
+        psBinding->uHash = uHash;
+        psBinding->psNextBinding = (oSymTable->psHashTable)[KeyHash];
+        (oSymTable->psHashTable)[KeyHash] = psBinding;
+        uPut++;
+    }
+    oSymTable->bindings += uPut;
+
+    /* keeps the block only if some binding landed in it */
+    if(uPut == 0) {
+        free(psBlock);
+        SymTable_count(oSymTable, frees);
+        return 1;
+    }
+    psBlock->psNextBlock = oSymTable->psBulkBlocks;
+    oSymTable->psBulkBlocks = psBlock;
+    oSymTable->bytes += uBlockSize;
+
+    return 1;
+}
+
+/* Returns 1 (TRUE) if psBinding of oSymTable can be relinked into
+another table as it is, and 0 (FALSE) if it has to be copied: its
+memory, or its key's, belongs to oSymTable's arena, to a block of
+SymTable_putBulk, or to an atom. */
+static int SymTable_isMovable(SymTable_T oSymTable,
+struct Binding *psBinding) {
+#ifdef SYMTABLE_ARENA
+    (void)oSymTable;
+    (void)psBinding;
+    return 0;
+#else
+    if(psBinding->ucInBlock) {
+        return 0;
+    }
+#if SYMTABLE_INLINE_KEY > 0
+    if(psBinding->pcKey == psBinding->acInlineKey) {
+        return 1;
+    }
+#endif
+    return SymTable_ownsKey(oSymTable, psBinding);
+#endif
+}
+
+#ifndef SYMTABLE_ARENA
+/* Moves the memory of psBinding, and of its key of uLength characters
+if it owns one, from the accounts of oSource to those of oDest, as
+SymTable_merge relinks the binding from one table into the other. */
+static void SymTable_transferBinding(SymTable_T oSource,
+SymTable_T oDest, struct Binding *psBinding, size_t uLength) {
+    if(SymTable_ownsKey(oSource, psBinding)) {
+        oSource->bytes -= uLength + 1;
+        oDest->bytes += uLength + 1;
+        SymTable_count(oSource, frees);
+        SymTable_count(oDest, mallocs);
+    }
+    oSource->bytes -= sizeof(struct Binding);
+    oDest->bytes += sizeof(struct Binding);
+    SymTable_count(oSource, frees);
+    SymTable_count(oDest, mallocs);
+}
+#endif
+
+int SymTable_merge(SymTable_T oDest, SymTable_T oSource,
+void *(*pfResolve)(const char *pcKey, void *pvDestValue,
+void *pvSourceValue, void *pvExtra),
+const void *pvExtra) {
+    struct Binding **ppsLink;
+    struct Binding *psBinding;
+    struct Binding *psCopy;
+    size_t uLength;
+    size_t uHash;
+    size_t newBuckets;
+    size_t bucket;
+    size_t KeyHash;
+    int iAlike;
+
+    assert(oDest != NULL);
+    assert(oSource != NULL);
+    assert(oDest != oSource);
+    SymTable_count(oDest, auCalls[CALL_MERGE]);
+
+    /* sizes oDest once for every binding of oSource, so that none of
+    the moves below expands it */
+    if(oDest->bindings > (size_t)-1 - oSource->bindings
+    || !SymTable_grow(oDest, oDest->bindings + oSource->bindings,
+    &newBuckets)) {
+        return 0;
+    }
+    while(oDest->psOldHashTable != NULL) {
+        SymTable_migrate(oDest);
+    }
+    while(oSource->psOldHashTable != NULL) {
+        SymTable_migrate(oSource);
+    }
+
+    /* takes each binding off the front of its bucket, so that oSource
+    stays whole if a copy fails. A key's hash code is only computed
+    again if the tables hash differently. */
+    iAlike = SymTable_hashesAlike(oDest, oSource);
+    for(bucket = 0; bucket < oSource->bucketCount; bucket++) {
+        while((psBinding = oSource->psHashTable[bucket]) != NULL) {
+            uLength = strlen(psBinding->pcKey);
+            uHash = iAlike ? psBinding->uHash
+            : SymTable_tableHashN(oDest, psBinding->pcKey, uLength);
+            ppsLink = SymTable_findLink(oDest, psBinding->pcKey,
+            uLength, uHash);
+
+            if(ppsLink != NULL) {
+                if(pfResolve != NULL) {
+                    (*ppsLink)->pvValue = (*pfResolve)(
+                    psBinding->pcKey, (*ppsLink)->pvValue,
+                    psBinding->pvValue, (void *) pvExtra);
+                }
+                oSource->psHashTable[bucket] = psBinding->psNextBinding;
+                SymTable_freeBinding(oSource, psBinding);
+                (oSource->bindings)--;
+                continue;
+            }
+
+            psCopy = psBinding;
+            if(!SymTable_isMovable(oSource, psBinding)) {
+                psCopy = SymTable_newBinding(oDest, psBinding->pcKey,
+                uLength, NULL);
+                if(psCopy == NULL) {
+                    return 0;
+                }
+                psCopy->pvValue = psBinding->pvValue;
+            }
+            psCopy->uHash = uHash;
+            oSource->psHashTable[bucket] = psBinding->psNextBinding;
+            (oSource->bindings)--;
+            if(psCopy != psBinding) {
+                SymTable_freeBinding(oSource, psBinding);
+            }
+#ifndef SYMTABLE_ARENA
+            else {
+                SymTable_transferBinding(oSource, oDest, psBinding,
+                uLength);
+            }
+#endif
+
+            KeyHash = SymTable_bucketOf(psCopy->uHash,
+            oDest->bucketCount);
+            psCopy->psNextBinding = oDest->psHashTable[KeyHash];
+            oDest->psHashTable[KeyHash] = psCopy;
+            (oDest->bindings)++;
+        }
+    }
+
+    return 1;
+}
+
+/* Moves every atom of oSymTable into a larger atom hash table. If not
+possible, will not change oSymTable. */
+static void SymTable_expandAtoms(SymTable_T oSymTable) {
+    struct SymAtom **psNewAtomTable;
+    struct SymAtom *psAtom;
+    struct SymAtom *psNextAtom;
+    size_t newBucketCount;
+    size_t bucket;
+    size_t KeyHash;
+
+    newBucketCount = SymTable_nextBucketCount(oSymTable->atomBuckets,
+    oSymTable->atomBucketCount);
+    if(newBucketCount == 0) {
+        return;
+    }
+    psNewAtomTable = (struct SymAtom**)
+    calloc(sizeof(struct SymAtom*), newBucketCount);
+    if(psNewAtomTable == NULL) {
+        return;
+    }
+    SymTable_count(oSymTable, mallocs);
+
+    /* interning is rare next to lookups, so the atoms move all at
+    once, relinked by their hash codes */
+    for(bucket = 0; bucket < oSymTable->atomBucketCount; bucket++) {
+        psAtom = oSymTable->psAtomTable[bucket];
+        while(psAtom != NULL) {
+            psNextAtom = psAtom->psNextAtom;
+            KeyHash = SymTable_bucketOf(psAtom->uHash, newBucketCount);
+            psAtom->psNextAtom = psNewAtomTable[KeyHash];
+            psNewAtomTable[KeyHash] = psAtom;
+            psAtom = psNextAtom;
+        }
+    }
+
+    free(oSymTable->psAtomTable);
+    SymTable_count(oSymTable, frees);
+    oSymTable->bytes -= oSymTable->atomBucketCount
+    * sizeof(struct SymAtom*);
+    oSymTable->bytes += newBucketCount * sizeof(struct SymAtom*);
+    oSymTable->psAtomTable = psNewAtomTable;
+    oSymTable->atomBucketCount = newBucketCount;
+    (oSymTable->atomBuckets)++;
+}
+
+SymAtom_T SymTable_intern(SymTable_T oSymTable, const char *pcKey) {
+    struct SymAtom *psAtom;
+    size_t uHash;
+    size_t uLength;
+    size_t KeyHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_INTERN]);
+
+    /* returns the existing atom if pcKey is already interned */
+    uHash = SymTable_tableHash(oSymTable, pcKey, &uLength);
+    psAtom = SymTable_findAtom(oSymTable, pcKey, uLength, uHash);
+    if(psAtom != NULL) {
+        return psAtom;
+    }
+
+    /* creates the atom hash table on first use, and grows it like the
+    binding hash table */
+    if(oSymTable->psAtomTable == NULL) {
+        oSymTable->psAtomTable = (struct SymAtom**)
+        calloc(sizeof(struct SymAtom*), auBucketCounts[0]);
+        if(oSymTable->psAtomTable == NULL) {
+            return NULL;
+        }
+        SymTable_count(oSymTable, mallocs);
+        oSymTable->atomBucketCount = auBucketCounts[0];
+        oSymTable->bytes += auBucketCounts[0] * sizeof(struct SymAtom*);
+    }
+    else if(oSymTable->atoms >= oSymTable->atomBucketCount) {
+        SymTable_expandAtoms(oSymTable);
+    }
+
+    psAtom = (struct SymAtom*)malloc(offsetof(struct SymAtom, acKey)
+    + uLength + 1);
+    if(psAtom == NULL) {
+        return NULL;
+    }
+    SymTable_count(oSymTable, mallocs);
+    oSymTable->bytes += offsetof(struct SymAtom, acKey) + uLength + 1;
+    psAtom->uHash = uHash;
+    psAtom->uLength = uLength;
+    memcpy(psAtom->acKey, pcKey, uLength + 1);
+
+    KeyHash = SymTable_bucketOf(uHash, oSymTable->atomBucketCount);
+    psAtom->psNextAtom = oSymTable->psAtomTable[KeyHash];
+    oSymTable->psAtomTable[KeyHash] = psAtom;
+    (oSymTable->atoms)++;
+
+    return psAtom;
+}
+
+const char *SymAtom_getKey(SymAtom_T oAtom) {
+    assert(oAtom != NULL);
+    return oAtom->acKey;
+}
+
+int SymTable_putAtom(SymTable_T oSymTable, SymAtom_T oAtom,
+const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oAtom != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_PUT_ATOM]);
+
+    return SymTable_putKey(oSymTable, oAtom->acKey, oAtom->uLength,
+    oAtom->uHash, oAtom, pvValue);
+}
+
+void *SymTable_replaceAtom(SymTable_T oSymTable, SymAtom_T oAtom,
+const void *pvValue) {
+    assert(oSymTable != NULL);
+    assert(oAtom != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REPLACE_ATOM]);
+
+    return SymTable_replaceKey(oSymTable, oAtom->acKey, oAtom->uLength,
+    oAtom->uHash, pvValue);
+}
+
+int SymTable_containsAtom(SymTable_T oSymTable, SymAtom_T oAtom) {
+    assert(oSymTable != NULL);
+    assert(oAtom != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_CONTAINS_ATOM]);
+
+    return SymTable_getKey(oSymTable, oAtom->acKey, oAtom->uLength,
+    oAtom->uHash) != NULL;
+}
+
+void *SymTable_getAtom(SymTable_T oSymTable, SymAtom_T oAtom) {
+    struct Binding *psBinding;
+
+    assert(oSymTable != NULL);
+    assert(oAtom != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_GET_ATOM]);
+
+    psBinding = SymTable_getKey(oSymTable, oAtom->acKey, oAtom->uLength,
+    oAtom->uHash);
+    if(psBinding == NULL) {
+        return NULL;
+    }
+
+    return psBinding->pvValue;
+}
+
+void *SymTable_removeAtom(SymTable_T oSymTable, SymAtom_T oAtom) {
+    assert(oSymTable != NULL);
+    assert(oAtom != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_REMOVE_ATOM]);
+
+    return SymTable_removeKey(oSymTable, oAtom->acKey, oAtom->uLength,
+    oAtom->uHash);
+}
+
+/* Applies function *pfApply to each binding in buckets uFirstBucket
+through uBucketCount - 1 of psHashTable. */
+static void SymTable_mapBuckets(struct Binding **psHashTable,
+size_t uFirstBucket, size_t uBucketCount,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    struct Binding *psCurrentBinding;
+    size_t bucket;
+
+    for(bucket = uFirstBucket; bucket < uBucketCount; bucket++) {
+        psCurrentBinding = psHashTable[bucket];
+        while(psCurrentBinding != NULL) {
+            (*pfApply)(psCurrentBinding->pcKey,
+            psCurrentBinding->pvValue, (void *) pvExtra);
+            psCurrentBinding = psCurrentBinding->psNextBinding;
+        }
+    }
+}
+
+void SymTable_map(SymTable_T oSymTable,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_MAP]);
+
+    /* applies pfApply to each binding in every bucket */
+    SymTable_mapBuckets(oSymTable->psHashTable, 0,
+    oSymTable->bucketCount, pfApply, pvExtra);
+    if(oSymTable->psOldHashTable != NULL) {
+        SymTable_mapBuckets(oSymTable->psOldHashTable,
+        oSymTable->migrated, oSymTable->oldBucketCount,
+        pfApply, pvExtra);
+    }
+
     return;
-}
\ No newline at end of file
+}
+
+/* Returns the number of slices of oSymTable, for SymTable_getSliceCount
+and the functions that take slices. */
+static size_t SymTable_countSlices(SymTable_T oSymTable) {
+    if(oSymTable->psOldHashTable == NULL) {
+        return oSymTable->bucketCount;
+    }
+    return oSymTable->bucketCount
+    + (oSymTable->oldBucketCount - oSymTable->migrated);
+}
+
+size_t SymTable_getSliceCount(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    return SymTable_countSlices(oSymTable);
+}
+
+void SymTable_mapSlice(SymTable_T oSymTable, size_t uFirst, size_t uEnd,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    size_t uOldFirst;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(uFirst <= uEnd);
+    assert(uEnd <= SymTable_countSlices(oSymTable));
+
+    /* slices number the buckets of the hash table, then the buckets of
+    the old hash table that have not moved yet */
+    if(uFirst < oSymTable->bucketCount) {
+        SymTable_mapBuckets(oSymTable->psHashTable, uFirst,
+        uEnd < oSymTable->bucketCount ? uEnd : oSymTable->bucketCount,
+        pfApply, pvExtra);
+    }
+    if(uEnd > oSymTable->bucketCount) {
+        uOldFirst = uFirst > oSymTable->bucketCount
+        ? uFirst - oSymTable->bucketCount : 0;
+        SymTable_mapBuckets(oSymTable->psOldHashTable,
+        oSymTable->migrated + uOldFirst,
+        oSymTable->migrated + (uEnd - oSymTable->bucketCount),
+        pfApply, pvExtra);
+    }
+}
+
+/* Returns the first binding of slice uSlice of oSymTable, numbered as
+SymTable_mapSlice numbers them, or NULL if the slice is empty. */
+static struct Binding *SymTable_sliceChain(SymTable_T oSymTable,
+size_t uSlice) {
+    if(uSlice < oSymTable->bucketCount) {
+        return oSymTable->psHashTable[uSlice];
+    }
+    return oSymTable->psOldHashTable[oSymTable->migrated
+    + (uSlice - oSymTable->bucketCount)];
+}
+
+void SymTable_getStats(SymTable_T oSymTable,
+struct SymTableStats *psStats, size_t uSample) {
+    struct Binding *psCurrentBinding;
+    size_t uSlices;
+    size_t uSlice;
+    size_t uChain;
+    size_t uInChains = 0;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_GET_STATS]);
+
+    memset(psStats, 0, sizeof(*psStats));
+    psStats->uBucketCount = oSymTable->bucketCount;
+    psStats->uGrowthIndex = oSymTable->buckets;
+    psStats->uBindings = oSymTable->bindings;
+    psStats->dLoadFactor = (double)oSymTable->bindings
+    / (double)oSymTable->bucketCount;
+    psStats->uResizes = oSymTable->resizes;
+    psStats->uBytes = oSymTable->bytes;
+#ifdef SYMTABLE_ARENA
+    psStats->uBytes += SymArena_getBytes(oSymTable->oArena);
+#endif
+
+    /* a sample is a run of slices, picking up where the last one
+    ended */
+    uSlices = SymTable_countSlices(oSymTable);
+    uSlice = 0;
+    if(uSample == 0 || uSample > uSlices) {
+        uSample = uSlices;
+    }
+    else {
+        uSlice = oSymTable->sampleStart % uSlices;
+        oSymTable->sampleStart = uSlice + uSample;
+    }
+
+    for(u = 0; u < uSample; u++) {
+        uChain = 0;
+        for(psCurrentBinding = SymTable_sliceChain(oSymTable, uSlice);
+        psCurrentBinding != NULL;
+        psCurrentBinding = psCurrentBinding->psNextBinding) {
+            uChain++;
+        }
+        if(uChain > psStats->uMaxChain) {
+            psStats->uMaxChain = uChain;
+        }
+        (psStats->auHistogram[uChain < SYMTABLE_STATS_CHAINS
+        ? uChain : SYMTABLE_STATS_CHAINS - 1])++;
+        uInChains += uChain;
+        if(++uSlice == uSlices) {
+            uSlice = 0;
+        }
+    }
+
+    psStats->uChains = uSample;
+    psStats->uEmptyChains = psStats->auHistogram[0];
+    if(uSample > psStats->uEmptyChains) {
+        psStats->dMeanChain = (double)uInChains
+        / (double)(uSample - psStats->uEmptyChains);
+    }
+}
+
+void SymTable_dumpCounters(SymTable_T oSymTable, FILE *psFile) {
+#ifdef SYMTABLE_INSTRUMENT
+    const struct Counters *psCounters;
+    int iCall;
+#endif
+
+    assert(oSymTable != NULL);
+    assert(psFile != NULL);
+
+#ifdef SYMTABLE_INSTRUMENT
+    psCounters = &oSymTable->sCounters;
+    for(iCall = 0; iCall < CALL_COUNT; iCall++) {
+        if(psCounters->auCalls[iCall] != 0) {
+            fprintf(psFile, "%-24s %12lu\n", apcCallNames[iCall],
+            (unsigned long)psCounters->auCalls[iCall]);
+        }
+    }
+    fprintf(psFile, "%-24s %12lu\n", "key compares",
+    (unsigned long)psCounters->keyCompares);
+    fprintf(psFile, "%-24s %12lu\n", "nodes visited",
+    (unsigned long)psCounters->nodesVisited);
+    fprintf(psFile, "%-24s %12lu\n", "hashes",
+    (unsigned long)psCounters->hashes);
+    fprintf(psFile, "%-24s %12lu\n", "mallocs",
+    (unsigned long)psCounters->mallocs);
+    fprintf(psFile, "%-24s %12lu\n", "frees",
+    (unsigned long)psCounters->frees);
+    fprintf(psFile, "%-24s %12lu\n", "expands",
+    (unsigned long)psCounters->expands);
+    fprintf(psFile, "%-24s %12.6f\n", "expand seconds",
+    (double)psCounters->expandTicks / CLOCKS_PER_SEC);
+#else
+    fprintf(psFile, "counters not compiled in; "
+    "compile symtablehash.c with -DSYMTABLE_INSTRUMENT\n");
+#endif
+}
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+    SymTable_count(oSymTable, auCalls[CALL_ITER_BEGIN]);
+
+    /* lookups move buckets while a resize is in progress, which would
+    make the cursor skip or repeat bindings, so the resize is finished
+    first */
+    while(oSymTable->psOldHashTable != NULL) {
+        SymTable_migrate(oSymTable);
+    }
+
+    psIter->oSymTable = oSymTable;
+    psIter->uPosition = 0;
+    psIter->pvNext = NULL;
+}
+
+int SymTable_iterNext(struct SymTableIter *psIter, const char **ppcKey,
+void **ppvValue) {
+    struct Binding *psCurrentBinding;
+    SymTable_T oSymTable;
+
+    assert(psIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+    SymTable_count(psIter->oSymTable, auCalls[CALL_ITER_NEXT]);
+
+    /* uPosition is the next bucket to look at, and pvNext the rest of
+    the chain of the bucket before it */
+    oSymTable = psIter->oSymTable;
+    psCurrentBinding = (struct Binding *)psIter->pvNext;
+    while(psCurrentBinding == NULL) {
+        if(psIter->uPosition >= oSymTable->bucketCount) {
+            return 0;
+        }
+        psCurrentBinding = oSymTable->psHashTable[psIter->uPosition];
+        (psIter->uPosition)++;
+    }
+
+    psIter->pvNext = psCurrentBinding->psNextBinding;
+    *ppcKey = psCurrentBinding->pcKey;
+    *ppvValue = psCurrentBinding->pvValue;
+    return 1;
+}
+
+void SymTable_iterEnd(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+
+    psIter->uPosition = (size_t)-1;
+    psIter->pvNext = NULL;
+}
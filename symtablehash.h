@@ -0,0 +1,275 @@
+/*--------------------------------------------------------------------*/
+/* symtablehash.h                                                     */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEHASH_INCLUDED
+#define SYMTABLEHASH_INCLUDED
+
+#include <stdio.h>
+#include "symtable.h"
+
+/* Functions that only the hash table implementation of symtable.h
+(symtablehash.c) provides. */
+
+/* Returns a new SymTable_T object whose hash table is already large
+enough for uCapacity bindings, or NULL if insufficient memory is
+available. */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/* Grows the hash table of oSymTable, if needed, so that it holds
+uCapacity bindings without expanding. Moves every binding at once.
+Removing bindings no longer shrinks the hash table below that size.
+Returns 1 (TRUE) if successful and 0 (FALSE) if insufficient memory is
+available, leaving oSymTable unchanged. oSymTable cannot be NULL. */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity);
+
+/* Shrinks the hash table of oSymTable to the smallest size that holds
+its bindings, moving every binding at once, and cancels any size
+reserved by SymTable_reserve. Removing bindings already shrinks the
+hash table a step at a time once it is a quarter full; this does it
+right away. Returns 1 (TRUE) if successful and 0 (FALSE) if
+insufficient memory is available, leaving oSymTable unchanged.
+oSymTable cannot be NULL. */
+int SymTable_compact(SymTable_T oSymTable);
+
+/* Puts the uCount pairs ppcKeys[i]/ppvValues[i] into oSymTable, like
+uCount calls of SymTable_put: a key already in oSymTable, or earlier
+in ppcKeys, is skipped. If iUnique is nonzero, the caller guarantees
+there are no such keys, and the check is skipped instead. Sizes the
+hash table once, and allocates the bindings and copies of the keys in
+a single block. Memory of a pair put this way that is later removed
+is only reclaimed by SymTable_free. Returns 1 (TRUE) if successful
+and 0 (FALSE) if insufficient memory is available, leaving oSymTable
+unchanged. oSymTable, ppcKeys, ppvValues, and each key cannot be
+NULL. */
+int SymTable_putBulk(SymTable_T oSymTable, const char *const *ppcKeys,
+const void *const *ppvValues, size_t uCount, int iUnique);
+
+/* Moves every binding of oSource into oDest, leaving oSource empty.
+A binding is relinked as it is, without copying its key, unless its
+memory belongs to oSource alone, as with atoms, SymTable_putBulk, or
+SYMTABLE_ARENA; then it is copied. For a key in both tables, calls
+(*pfResolve)(pcKey, pvDestValue, pvSourceValue, pvExtra) and keeps the
+value it returns in oDest; if pfResolve is NULL, keeps the value of
+oDest. The binding of oSource is freed either way, and the value left
+out is up to pfResolve. Returns 1 (TRUE) if successful and 0 (FALSE)
+if insufficient memory is available; the bindings moved by then stay
+in oDest and the others in oSource. oDest and oSource cannot be NULL
+or the same table. */
+int SymTable_merge(SymTable_T oDest, SymTable_T oSource,
+void *(*pfResolve)(const char *pcKey, void *pvDestValue,
+void *pvSourceValue, void *pvExtra),
+const void *pvExtra);
+
+/* A SymAtom_T object is a key interned in one SymTable_T object. Its
+hash code is computed once, when it is interned, and bindings put
+with it share its copy of the key, so lookups with it compare keys by
+address. It stays valid until the SymTable_T object that interned it
+is freed, and can only be used with that object. */
+typedef const struct SymAtom *SymAtom_T;
+
+/* Returns the atom for pcKey in oSymTable, creating it if pcKey has
+not been interned in oSymTable before. Interning the same key again
+returns the same atom. Returns NULL if insufficient memory is
+available. oSymTable and pcKey cannot be NULL. Creates a copy of
+pcKey. */
+SymAtom_T SymTable_intern(SymTable_T oSymTable, const char *pcKey);
+
+/* Returns the key that oAtom stands for. oAtom cannot be NULL. */
+const char *SymAtom_getKey(SymAtom_T oAtom);
+
+/* Same as SymTable_put, with the key that oAtom stands for. The new
+binding shares oAtom's copy of the key. oSymTable and oAtom cannot be
+NULL. */
+int SymTable_putAtom(SymTable_T oSymTable, SymAtom_T oAtom,
+const void *pvValue);
+
+/* Same as SymTable_replace, with the key that oAtom stands for.
+oSymTable and oAtom cannot be NULL. */
+void *SymTable_replaceAtom(SymTable_T oSymTable, SymAtom_T oAtom,
+const void *pvValue);
+
+/* Same as SymTable_contains, with the key that oAtom stands for.
+oSymTable and oAtom cannot be NULL. */
+int SymTable_containsAtom(SymTable_T oSymTable, SymAtom_T oAtom);
+
+/* Same as SymTable_get, with the key that oAtom stands for. oSymTable
+and oAtom cannot be NULL. */
+void *SymTable_getAtom(SymTable_T oSymTable, SymAtom_T oAtom);
+
+/* Same as SymTable_remove, with the key that oAtom stands for. oAtom
+stays valid. oSymTable and oAtom cannot be NULL. */
+void *SymTable_removeAtom(SymTable_T oSymTable, SymAtom_T oAtom);
+
+/* number of bytes in the seed of SymTable_seed */
+enum {SYMTABLE_SEED_LENGTH = 16};
+
+/* Makes oSymTable hash keys with SipHash-1-3 keyed by the
+SYMTABLE_SEED_LENGTH bytes at pucSeed, or by random bytes if pucSeed is
+NULL, instead of with the function symtablehash.c was compiled with.
+Under a fixed function, keys can be chosen to share one bucket, which
+turns every lookup of them into a walk of all of them; under a seed
+the caller keeps secret, they cannot. Hashing is slower. Keys given to
+the Hashed functions of oSymTable must then be hashed by
+SymTable_hashKey of oSymTable itself. Returns 1 (TRUE) if successful
+and 0 (FALSE) if oSymTable already holds bindings or atoms, leaving
+it unchanged. oSymTable cannot be NULL. */
+int SymTable_seed(SymTable_T oSymTable, const unsigned char *pucSeed);
+
+/* The functions below take a key as the uLength characters at pcKey,
+which need not be followed by '\0', so that a slice of a larger buffer
+can be used as a key without copying it. The slice must not contain
+'\0'. A binding put this way holds a '\0'-terminated copy of the
+key, which is what SymTable_map passes to its function. */
+
+/* Returns the hash code oSymTable uses for the key of uLength
+characters at pcKey. The code only fits the SymTable_T object that
+computed it. oSymTable and pcKey cannot be NULL. */
+size_t SymTable_hashKey(SymTable_T oSymTable, const char *pcKey,
+size_t uLength);
+
+/* Same as SymTable_put, with the key of uLength characters at pcKey.
+oSymTable and pcKey cannot be NULL. */
+int SymTable_putN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, const void *pvValue);
+
+/* Same as SymTable_replace, with the key of uLength characters at
+pcKey. oSymTable and pcKey cannot be NULL. */
+void *SymTable_replaceN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, const void *pvValue);
+
+/* Same as SymTable_contains, with the key of uLength characters at
+pcKey. oSymTable and pcKey cannot be NULL. */
+int SymTable_containsN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength);
+
+/* Same as SymTable_get, with the key of uLength characters at pcKey.
+oSymTable and pcKey cannot be NULL. */
+void *SymTable_getN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength);
+
+/* Same as SymTable_remove, with the key of uLength characters at
+pcKey. oSymTable and pcKey cannot be NULL. */
+void *SymTable_removeN(SymTable_T oSymTable, const char *pcKey,
+size_t uLength);
+
+/* The Hashed functions are the same as the N functions, but skip
+hashing the key. uHash must be SymTable_hashKey(oSymTable, pcKey,
+uLength); any other value makes their behavior undefined. */
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash, const void *pvValue);
+
+void *SymTable_replaceHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash, const void *pvValue);
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash);
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash);
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+size_t uLength, size_t uHash);
+
+/* Looks up the uCount keys ppcKeys[0] through ppcKeys[uCount - 1] in
+oSymTable and stores the value of each key at the same index of
+ppvValues, or NULL if oSymTable does not contain the key. Returns the
+number of keys found. Gives the same values as uCount calls of
+SymTable_get, but hashes a group of keys and prefetches their buckets
+and first bindings before comparing any of them, so that the cache
+misses of the group overlap. oSymTable, ppcKeys, ppvValues, and each
+key cannot be NULL. */
+size_t SymTable_getMany(SymTable_T oSymTable,
+const char *const *ppcKeys, size_t uCount, void **ppvValues);
+
+/* Returns the number of slices of oSymTable, the units into which
+SymTable_mapSlice divides it. Each slice is a bucket and holds a few
+bindings on average. oSymTable cannot be NULL. */
+size_t SymTable_getSliceCount(SymTable_T oSymTable);
+
+/* Applies function *pfApply to each key/value pair in slices uFirst
+through uEnd - 1 of oSymTable and passes pvExtra as an extra
+parameter. Mapping over slices 0 through SymTable_getSliceCount - 1
+visits each pair once. Only reads oSymTable, so several threads may
+map over slices of one table at once, as long as no thread changes
+the table meanwhile. oSymTable and pfApply cannot be NULL, and uFirst
+<= uEnd <= SymTable_getSliceCount(oSymTable). */
+void SymTable_mapSlice(SymTable_T oSymTable, size_t uFirst, size_t uEnd,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra);
+
+/* number of entries in the chain length histogram of a
+SymTableStats */
+enum {SYMTABLE_STATS_CHAINS = 8};
+
+/* How the hash table of a SymTable_T object is doing, as filled in by
+SymTable_getStats. While a resize is under way, the chains are those
+of every bucket plus those of the buckets of the old hash table that
+have not moved yet, as with SymTable_mapSlice. */
+struct SymTableStats
+{
+   /* number of buckets of the hash table */
+   size_t uBucketCount;
+
+   /* index of uBucketCount in the growth sequence, 0 for the bucket
+   count of a new table */
+   size_t uGrowthIndex;
+
+   /* number of bindings */
+   size_t uBindings;
+
+   /* bindings per bucket */
+   double dLoadFactor;
+
+   /* number of chains counted: all of them, or the sample */
+   size_t uChains;
+
+   /* number of the chains counted that are empty */
+   size_t uEmptyChains;
+
+   /* number of bindings in the longest chain counted */
+   size_t uMaxChain;
+
+   /* mean number of bindings in the chains counted that are not
+   empty, or 0 if all are */
+   double dMeanChain;
+
+   /* auHistogram[i] is the number of the chains counted that hold i
+   bindings; the last entry counts the chains of
+   SYMTABLE_STATS_CHAINS - 1 bindings or more */
+   size_t auHistogram[SYMTABLE_STATS_CHAINS];
+
+   /* number of resizes the table has started, growing or shrinking */
+   size_t uResizes;
+
+   /* bytes of memory the table holds, not counting the overhead of
+   malloc itself */
+   size_t uBytes;
+};
+
+/* Fills in *psStats for oSymTable. If uSample is 0, counts every
+chain, in time proportional to the number of buckets and bindings.
+Otherwise counts only uSample consecutive chains, starting where the
+previous sampling call on oSymTable stopped, so that calls made now
+and then, as for exporting metrics, cover the whole table over time
+for a small cost each. The fields other than the chain statistics are
+exact either way. oSymTable and psStats cannot be NULL. */
+void SymTable_getStats(SymTable_T oSymTable,
+struct SymTableStats *psStats, size_t uSample);
+
+/* Writes the counters of oSymTable to psFile, one per line, as a name
+followed by a number: the calls of each function of the table that
+were made at least once, the key comparisons, the bindings visited
+along chains, the hash codes computed, the allocations and frees, and
+the number of SymTable_expand calls with the processor time they
+took. SymTable_hashKey, SymTable_getSliceCount, and SymTable_mapSlice,
+which threads may call on one table at once, are not counted, and
+neither are the hashes they compute. The counters only exist when
+symtablehash.c is compiled with SYMTABLE_INSTRUMENT defined; otherwise
+the function writes a single line saying so, so that callers need not
+change between builds. oSymTable and psFile cannot be NULL. */
+void SymTable_dumpCounters(SymTable_T oSymTable, FILE *psFile);
+
+#endif
@@ -0,0 +1,579 @@
+/*--------------------------------------------------------------------*/
+/* symtablehybrid.c                                                   */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+
+/* A table of up to SMALL_CAPACITY bindings keeps them in an array
+inside the SymTable and finds a key by comparing it with each. A put
+past that moves the bindings into a chained hash table, and a remove
+that leaves DEMOTE_COUNT bindings moves them back, so most tables,
+which stay small, cost one allocation plus one per key, and no bucket
+array. The gap between the two counts keeps a table near the limit
+from switching layouts on every put and remove. */
+enum {SMALL_CAPACITY = 8};
+enum {DEMOTE_COUNT = SMALL_CAPACITY / 2};
+
+/* HASH_MULTIPLIER is the multiplier of the hash function. */
+enum {HASH_MULTIPLIER = 65599};
+
+/* bucket counts of the hash table, roughly doubling. A large table
+starts with the first and grows one step when its bindings outnumber
+its buckets. */
+static const size_t auBucketCounts[] = {17, 37, 79, 163, 331, 673,
+1361, 2729, 5471, 10949, 21911, 43853, 87719, 175447, 350899, 701819,
+1403641, 2807303, 5614657, 11229331, 22458671, 44917381};
+static const size_t uSizeCount =
+sizeof(auBucketCounts) / sizeof(auBucketCounts[0]);
+
+/* A Pair is a binding of a small table. */
+struct Pair
+{
+    /* key, in memory of its own */
+    char *pcKey;
+
+    /* value */
+    void *pvValue;
+};
+
+/* A Binding is a binding of a large table, in the chain of its
+bucket. */
+struct Binding
+{
+    /* key, in memory of its own, taken over from a Pair on
+    promotion */
+    char *pcKey;
+
+    /* value */
+    void *pvValue;
+
+    /* hash code of pcKey, so that resizing does not rehash keys and a
+    lookup compares keys only when the codes are equal */
+    size_t uHash;
+
+    /* address of next binding in the bucket */
+    struct Binding *psNextBinding;
+};
+
+/* SymTable is either small, with psHashTable NULL and its bindings in
+asPairs[0..bindings-1], or large, with its bindings in the chains of
+psHashTable. */
+struct SymTable
+{
+   /* number of bindings */
+   size_t bindings;
+
+   /* buckets of a large table, or NULL while the table is small */
+   struct Binding **psHashTable;
+
+   /* number of buckets in psHashTable */
+   size_t bucketCount;
+
+   /* index of bucketCount in auBucketCounts */
+   size_t uSizeIndex;
+
+   /* bindings of a small table */
+   struct Pair asPairs[SMALL_CAPACITY];
+};
+
+/* Returns the hash code of pcKey. */
+static size_t SymTable_hash(const char *pcKey) {
+    size_t u;
+    size_t uHash = 0;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++) {
+        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+    }
+
+    return uHash;
+}
+
+/* Returns a copy of pcKey in memory of its own, or NULL if there is
+insufficient memory. */
+static char *SymTable_copyKey(const char *pcKey) {
+    char *pcCopy;
+    size_t uSize = strlen(pcKey) + 1;
+
+    pcCopy = (char *)malloc(uSize);
+    if(pcCopy == NULL) {
+        return NULL;
+    }
+    memcpy(pcCopy, pcKey, uSize);
+    return pcCopy;
+}
+
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    /* Allocates memory for oSymTable. A new table is small, so there
+    are no buckets to allocate. */
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if(oSymTable == NULL) {
+        return NULL;
+    }
+    oSymTable->bindings = 0;
+    oSymTable->psHashTable = NULL;
+    oSymTable->bucketCount = 0;
+    oSymTable->uSizeIndex = 0;
+    return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable) {
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    size_t u;
+
+    assert(oSymTable != NULL);
+
+    if(oSymTable->psHashTable == NULL) {
+        for(u = 0; u < oSymTable->bindings; u++) {
+            free(oSymTable->asPairs[u].pcKey);
+        }
+        free(oSymTable);
+        return;
+    }
+
+    /* frees each binding in each bucket */
+    for(u = 0; u < oSymTable->bucketCount; u++) {
+        for(psCurrentBinding = oSymTable->psHashTable[u];
+        psCurrentBinding != NULL;
+        psCurrentBinding = psNextBinding) {
+            psNextBinding = psCurrentBinding->psNextBinding;
+            free(psCurrentBinding->pcKey);
+            free(psCurrentBinding);
+        }
+    }
+    free(oSymTable->psHashTable);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->bindings;
+}
+
+/* Moves the bindings of the large oSymTable into a hash table of
+auBucketCounts[uSizeIndex] buckets. Returns 1 (TRUE) if successful
+and 0 (FALSE) if there is insufficient memory, leaving oSymTable
+unchanged. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uSizeIndex) {
+    struct Binding **psNewHashTable;
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    size_t uNewCount = auBucketCounts[uSizeIndex];
+    size_t u;
+
+    psNewHashTable =
+    (struct Binding **)calloc(uNewCount, sizeof(struct Binding *));
+    if(psNewHashTable == NULL) {
+        return 0;
+    }
+
+    /* relinks each binding into the bucket of its stored hash code */
+    for(u = 0; u < oSymTable->bucketCount; u++) {
+        for(psCurrentBinding = oSymTable->psHashTable[u];
+        psCurrentBinding != NULL;
+        psCurrentBinding = psNextBinding) {
+            psNextBinding = psCurrentBinding->psNextBinding;
+            psCurrentBinding->psNextBinding =
+            psNewHashTable[psCurrentBinding->uHash % uNewCount];
+            psNewHashTable[psCurrentBinding->uHash % uNewCount] =
+            psCurrentBinding;
+        }
+    }
+
+    free(oSymTable->psHashTable);
+    oSymTable->psHashTable = psNewHashTable;
+    oSymTable->bucketCount = uNewCount;
+    oSymTable->uSizeIndex = uSizeIndex;
+    return 1;
+}
+
+/* Moves the bindings of the small, full oSymTable into a hash table
+of auBucketCounts[0] buckets. The keys stay where they are. Returns 1
+(TRUE) if successful and 0 (FALSE) if there is insufficient memory,
+leaving oSymTable unchanged. */
+static int SymTable_promote(SymTable_T oSymTable) {
+    struct Binding *apsBindings[SMALL_CAPACITY];
+    struct Binding **psHashTable;
+    size_t uHash;
+    size_t u;
+
+    /* allocates everything first, so that a failure changes
+    nothing */
+    psHashTable = (struct Binding **)calloc(auBucketCounts[0],
+    sizeof(struct Binding *));
+    if(psHashTable == NULL) {
+        return 0;
+    }
+    for(u = 0; u < SMALL_CAPACITY; u++) {
+        apsBindings[u] =
+        (struct Binding *)malloc(sizeof(struct Binding));
+        if(apsBindings[u] == NULL) {
+            while(u > 0) {
+                u--;
+                free(apsBindings[u]);
+            }
+            free(psHashTable);
+            return 0;
+        }
+    }
+
+    for(u = 0; u < SMALL_CAPACITY; u++) {
+        uHash = SymTable_hash(oSymTable->asPairs[u].pcKey);
+        apsBindings[u]->pcKey = oSymTable->asPairs[u].pcKey;
+        apsBindings[u]->pvValue = oSymTable->asPairs[u].pvValue;
+        apsBindings[u]->uHash = uHash;
+        apsBindings[u]->psNextBinding =
+        psHashTable[uHash % auBucketCounts[0]];
+        psHashTable[uHash % auBucketCounts[0]] = apsBindings[u];
+    }
+    oSymTable->psHashTable = psHashTable;
+    oSymTable->bucketCount = auBucketCounts[0];
+    oSymTable->uSizeIndex = 0;
+    return 1;
+}
+
+/* Moves the bindings of the large oSymTable, at most SMALL_CAPACITY of
+them, back into its array of pairs, and frees its hash table. */
+static void SymTable_demote(SymTable_T oSymTable) {
+    struct Binding *psCurrentBinding;
+    struct Binding *psNextBinding;
+    size_t uPairs = 0;
+    size_t u;
+
+    assert(oSymTable->bindings <= SMALL_CAPACITY);
+
+    for(u = 0; u < oSymTable->bucketCount; u++) {
+        for(psCurrentBinding = oSymTable->psHashTable[u];
+        psCurrentBinding != NULL;
+        psCurrentBinding = psNextBinding) {
+            psNextBinding = psCurrentBinding->psNextBinding;
+            oSymTable->asPairs[uPairs].pcKey = psCurrentBinding->pcKey;
+            oSymTable->asPairs[uPairs].pvValue =
+            psCurrentBinding->pvValue;
+            uPairs++;
+            free(psCurrentBinding);
+        }
+    }
+    free(oSymTable->psHashTable);
+    oSymTable->psHashTable = NULL;
+    oSymTable->bucketCount = 0;
+    oSymTable->uSizeIndex = 0;
+}
+
+/* Returns the address of the value bound to pcKey in oSymTable, or
+NULL if there is none. */
+static void **SymTable_findValue(SymTable_T oSymTable,
+const char *pcKey) {
+    struct Binding *psChecker;
+    size_t uHash;
+    size_t u;
+
+    if(oSymTable->psHashTable == NULL) {
+        for(u = 0; u < oSymTable->bindings; u++) {
+            if(!strcmp(oSymTable->asPairs[u].pcKey, pcKey)) {
+                return &oSymTable->asPairs[u].pvValue;
+            }
+        }
+        return NULL;
+    }
+
+    uHash = SymTable_hash(pcKey);
+    for(psChecker =
+    oSymTable->psHashTable[uHash % oSymTable->bucketCount];
+    psChecker != NULL; psChecker = psChecker->psNextBinding) {
+        if(psChecker->uHash == uHash
+        && !strcmp(psChecker->pcKey, pcKey)) {
+            return &psChecker->pvValue;
+        }
+    }
+    return NULL;
+}
+
+/* Returns the address of the value bound to pcKey in oSymTable, first
+adding a binding with value NULL if there is none, and sets
+*piInserted to 1 (TRUE) if it added one. Returns NULL if there is
+insufficient memory, leaving oSymTable unchanged. */
+static void **SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted) {
+    struct Binding *psNewBinding;
+    void **ppvValue;
+    char *pcCopy;
+    size_t uHash;
+    size_t uBucket;
+
+    *piInserted = 0;
+    ppvValue = SymTable_findValue(oSymTable, pcKey);
+    if(ppvValue != NULL) {
+        return ppvValue;
+    }
+
+    pcCopy = SymTable_copyKey(pcKey);
+    if(pcCopy == NULL) {
+        return NULL;
+    }
+
+    if(oSymTable->psHashTable == NULL) {
+        if(oSymTable->bindings < SMALL_CAPACITY) {
+            ppvValue = &oSymTable->asPairs[oSymTable->bindings].pvValue;
+            oSymTable->asPairs[oSymTable->bindings].pcKey = pcCopy;
+            *ppvValue = NULL;
+            (oSymTable->bindings)++;
+            *piInserted = 1;
+            return ppvValue;
+        }
+        if(!SymTable_promote(oSymTable)) {
+            free(pcCopy);
+            return NULL;
+        }
+    }
+
+    psNewBinding = (struct Binding *)malloc(sizeof(struct Binding));
+    if(psNewBinding == NULL) {
+        free(pcCopy);
+        return NULL;
+    }
+    uHash = SymTable_hash(pcKey);
+    uBucket = uHash % oSymTable->bucketCount;
+    psNewBinding->pcKey = pcCopy;
+    psNewBinding->pvValue = NULL;
+    psNewBinding->uHash = uHash;
+    psNewBinding->psNextBinding = oSymTable->psHashTable[uBucket];
+    oSymTable->psHashTable[uBucket] = psNewBinding;
+    (oSymTable->bindings)++;
+
+    /* Bindings do not move when the hash table grows, so ppvValue
+    stays valid. If there is no memory to grow, the chains only get
+    longer. */
+    if(oSymTable->bindings > oSymTable->bucketCount
+    && oSymTable->uSizeIndex + 1 < uSizeCount) {
+        (void)SymTable_resize(oSymTable, oSymTable->uSizeIndex + 1);
+    }
+
+    *piInserted = 1;
+    return &psNewBinding->pvValue;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_insert(oSymTable, pcKey, &iInserted);
+    if(ppvValue == NULL || !iInserted) {
+        return 0;
+    }
+    *ppvValue = (void *) pvValue;
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+    void *pvTempValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findValue(oSymTable, pcKey);
+    if(ppvValue == NULL) {
+        return NULL;
+    }
+    pvTempValue = *ppvValue;
+    *ppvValue = (void *) pvValue;
+    return pvTempValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_findValue(oSymTable, pcKey) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    void **ppvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findValue(oSymTable, pcKey);
+    return ppvValue == NULL ? NULL : *ppvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    struct Binding **ppsLink;
+    struct Binding *psCurrent;
+    void *pvTempValue;
+    size_t uHash;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* a small table fills the hole with its last pair */
+    if(oSymTable->psHashTable == NULL) {
+        for(u = 0; u < oSymTable->bindings; u++) {
+            if(!strcmp(oSymTable->asPairs[u].pcKey, pcKey)) {
+                pvTempValue = oSymTable->asPairs[u].pvValue;
+                free(oSymTable->asPairs[u].pcKey);
+                (oSymTable->bindings)--;
+                oSymTable->asPairs[u] =
+                oSymTable->asPairs[oSymTable->bindings];
+                return pvTempValue;
+            }
+        }
+        return NULL;
+    }
+
+    uHash = SymTable_hash(pcKey);
+    for(ppsLink =
+    &oSymTable->psHashTable[uHash % oSymTable->bucketCount];
+    *ppsLink != NULL; ppsLink = &(*ppsLink)->psNextBinding) {
+        psCurrent = *ppsLink;
+        if(psCurrent->uHash == uHash
+        && !strcmp(psCurrent->pcKey, pcKey)) {
+            *ppsLink = psCurrent->psNextBinding;
+            pvTempValue = psCurrent->pvValue;
+            free(psCurrent->pcKey);
+            free(psCurrent);
+            (oSymTable->bindings)--;
+
+            /* Shrinking needs memory, and a table that cannot get it
+            keeps its buckets; demoting needs none. */
+            if(oSymTable->bindings <= DEMOTE_COUNT) {
+                SymTable_demote(oSymTable);
+            }
+            else if(oSymTable->uSizeIndex > 0
+            && oSymTable->bindings < oSymTable->bucketCount / 8) {
+                (void)SymTable_resize(oSymTable,
+                oSymTable->uSizeIndex - 1);
+            }
+            return pvTempValue;
+        }
+    }
+    return NULL;
+}
+
+void **SymTable_findOrInsert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted) {
+    void **ppvValue;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_insert(oSymTable, pcKey, &iInserted);
+    if(ppvValue != NULL && piInserted != NULL) {
+        *piInserted = iInserted;
+    }
+    return ppvValue;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findOrInsert(oSymTable, pcKey, NULL);
+    if(ppvValue == NULL) {
+        return 0;
+    }
+    *ppvValue = (void *) pvValue;
+    return 1;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    struct Binding *psCurrentBinding;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if(oSymTable->psHashTable == NULL) {
+        for(u = 0; u < oSymTable->bindings; u++) {
+            (*pfApply)(oSymTable->asPairs[u].pcKey,
+            oSymTable->asPairs[u].pvValue, (void *) pvExtra);
+        }
+        return;
+    }
+
+    /* applies pfApply to every binding in each bucket */
+    for(u = 0; u < oSymTable->bucketCount; u++) {
+        for(psCurrentBinding = oSymTable->psHashTable[u];
+        psCurrentBinding != NULL;
+        psCurrentBinding = psCurrentBinding->psNextBinding) {
+            (*pfApply)(psCurrentBinding->pcKey,
+            psCurrentBinding->pvValue, (void *) pvExtra);
+        }
+    }
+}
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    /* uPosition is the next pair of a small table, or the next bucket
+    of a large one */
+    psIter->oSymTable = oSymTable;
+    psIter->uPosition = 0;
+    psIter->pvNext = NULL;
+}
+
+int SymTable_iterNext(struct SymTableIter *psIter, const char **ppcKey,
+void **ppvValue) {
+    SymTable_T oSymTable;
+    struct Binding *psCurrentBinding;
+
+    assert(psIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    oSymTable = psIter->oSymTable;
+    if(oSymTable->psHashTable == NULL) {
+        if(psIter->uPosition >= oSymTable->bindings) {
+            return 0;
+        }
+        *ppcKey = oSymTable->asPairs[psIter->uPosition].pcKey;
+        *ppvValue = oSymTable->asPairs[psIter->uPosition].pvValue;
+        (psIter->uPosition)++;
+        return 1;
+    }
+
+    while(psIter->pvNext == NULL
+    && psIter->uPosition < oSymTable->bucketCount) {
+        psIter->pvNext = oSymTable->psHashTable[psIter->uPosition];
+        (psIter->uPosition)++;
+    }
+    psCurrentBinding = (struct Binding *)psIter->pvNext;
+    if(psCurrentBinding == NULL) {
+        return 0;
+    }
+    psIter->pvNext = psCurrentBinding->psNextBinding;
+    *ppcKey = psCurrentBinding->pcKey;
+    *ppvValue = psCurrentBinding->pvValue;
+    return 1;
+}
+
+void SymTable_iterEnd(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+
+    /* past every pair and every bucket */
+    psIter->uPosition = (size_t)-1;
+    psIter->pvNext = NULL;
+}
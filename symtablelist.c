@@ -7,6 +7,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include "symtable.h"
+#include "symtablelist.h"
+#ifdef SYMTABLE_ARENA
+#include "symarena.h"
+#endif
+
+/* Keys shorter than SYMTABLE_INLINE_KEY bytes are stored inside their
+binding. Define it as 0 to store every key in memory of its own. */
+#ifndef SYMTABLE_INLINE_KEY
+#define SYMTABLE_INLINE_KEY 24
+#endif
 
 /* Each key/value pair is stored in a Binding. Bindings are linked to 
 form a linked list symbol table. */
@@ -19,6 +29,16 @@ struct Binding
 
     /* Address of next binding */
     struct Binding *psNextBinding; 
+
+    /* number of lookups that found the binding, kept under
+    SYMTABLE_ORDER_COUNT */
+    size_t uHits;
+
+#if SYMTABLE_INLINE_KEY > 0
+    /* pcKey points here when the key is short enough, so comparing it
+    touches no memory outside the binding */
+    char acInlineKey[SYMTABLE_INLINE_KEY];
+#endif
 };
 
 /* SymTable is a structure that points to the first Binding and tracks
@@ -30,6 +50,14 @@ struct SymTable
    
    /* number of bindings in the linked list. */
    size_t bindings; 
+
+   /* how successful lookups reorder the list */
+   enum SymTableOrder eOrder;
+
+#ifdef SYMTABLE_ARENA
+   /* arena holding every binding and key copy of the table */
+   SymArena_T oArena;
+#endif
 };
 
 SymTable_T SymTable_new(void) {
@@ -41,13 +69,103 @@ SymTable_T SymTable_new(void) {
         return NULL;
     }
 
+#ifdef SYMTABLE_ARENA
+    oSymTable->oArena = SymArena_new(sizeof(struct Binding));
+    if(oSymTable->oArena == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+#endif
+
     /* Initilizes oSymTable parameters. */
     oSymTable->psFirstBinding = NULL;
     oSymTable->bindings = 0;
+    oSymTable->eOrder = SYMTABLE_ORDER_NONE;
     return oSymTable;
 }
 
+void SymTable_setOrder(SymTable_T oSymTable,
+enum SymTableOrder eOrder) {
+    assert(oSymTable != NULL);
+    oSymTable->eOrder = eOrder;
+}
+
+/* Returns a new binding holding a copy of pcKey, or NULL if there is
+insufficient memory. A key shorter than SYMTABLE_INLINE_KEY bytes is
+copied into the binding itself. With SYMTABLE_ARENA, the binding and
+a longer key's copy come from the arena of oSymTable instead of from
+malloc. */
+static struct Binding *SymTable_newBinding(SymTable_T oSymTable,
+const char *pcKey) {
+    struct Binding *psNewBinding;
+    size_t uLength = strlen(pcKey);
+
+#ifdef SYMTABLE_ARENA
+    psNewBinding = (struct Binding*)SymArena_alloc(oSymTable->oArena);
+#else
+    (void)oSymTable;
+    psNewBinding = (struct Binding*)malloc(sizeof(struct Binding));
+#endif
+    if (psNewBinding == NULL) {
+        return NULL;
+    }
+    psNewBinding->uHits = 0;
+
+#if SYMTABLE_INLINE_KEY > 0
+    if(uLength < SYMTABLE_INLINE_KEY) {
+        psNewBinding->pcKey = psNewBinding->acInlineKey;
+        memcpy(psNewBinding->pcKey, pcKey, uLength + 1);
+        return psNewBinding;
+    }
+#endif
+
+    /* a longer key spills into memory of its own */
+#ifdef SYMTABLE_ARENA
+    psNewBinding->pcKey =
+    SymArena_copyString(oSymTable->oArena, pcKey, uLength);
+    if(psNewBinding->pcKey == NULL) {
+        SymArena_release(oSymTable->oArena, psNewBinding);
+        return NULL;
+    }
+#else
+    psNewBinding->pcKey = 
+    (char *)calloc(uLength + 1, sizeof(*pcKey));
+    if(psNewBinding->pcKey == NULL) {
+        free(psNewBinding);  
+        return NULL;
+    }
+    strcpy(psNewBinding->pcKey, pcKey);
+#endif
+
+    return psNewBinding;
+}
+
+/* Frees psBinding and its key. With SYMTABLE_ARENA, the binding goes
+back to the arena of oSymTable for reuse and the bytes of a spilled
+key are reclaimed only when oSymTable is freed. */
+static void SymTable_freeBinding(SymTable_T oSymTable,
+struct Binding *psBinding) {
+#ifdef SYMTABLE_ARENA
+    SymArena_release(oSymTable->oArena, psBinding);
+#else
+    (void)oSymTable;
+#if SYMTABLE_INLINE_KEY > 0
+    if(psBinding->pcKey != psBinding->acInlineKey)
+#endif
+    {
+        free(psBinding->pcKey);
+    }
+    free(psBinding);
+#endif
+}
+
 void SymTable_free(SymTable_T oSymTable) {
+#ifdef SYMTABLE_ARENA
+    assert(oSymTable != NULL);
+
+    /* frees every binding and key at once */
+    SymArena_free(oSymTable->oArena);
+#else
     struct Binding *psCurrentBinding;
     struct Binding *psNextBinding;
 
@@ -59,9 +177,9 @@ void SymTable_free(SymTable_T oSymTable) {
         psCurrentBinding = psNextBinding)
     {
         psNextBinding = psCurrentBinding->psNextBinding;
-        free(psCurrentBinding->pcKey);
-        free(psCurrentBinding);
+        SymTable_freeBinding(oSymTable, psCurrentBinding);
     }
+#endif
 
     free(oSymTable);
 }
@@ -73,29 +191,27 @@ size_t SymTable_getLength(SymTable_T oSymTable) {
 
 int SymTable_put(SymTable_T oSymTable, const char *pcKey, 
 const void *pvValue) {
+    struct Binding *psChecker;
     struct Binding *psNewBinding;
     
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    if(SymTable_contains(oSymTable, pcKey)) {
-        return 0;
+    /* a failed put is not a lookup, so it leaves the order alone */
+    for(psChecker = oSymTable->psFirstBinding; psChecker != NULL;
+    psChecker = psChecker->psNextBinding) {
+        if(!strcmp(psChecker->pcKey, pcKey)) {
+            return 0;
+        }
     }
     
     /* allocates memory for new binding and for copy of key */
-    psNewBinding = (struct Binding*)malloc(sizeof(struct Binding));
+    psNewBinding = SymTable_newBinding(oSymTable, pcKey);
     if (psNewBinding == NULL) {
         return 0;
     }
-    psNewBinding->pcKey = 
-    (char *)calloc(strlen(pcKey) + 1, sizeof(*pcKey));
-    if(psNewBinding->pcKey == NULL) {
-        free(psNewBinding);  
-        return 0;
-    }
 
     /* initializes values for paramters in the binding */
-    strcpy(psNewBinding->pcKey, pcKey);
     psNewBinding->pvValue = (void *) pvValue;
     psNewBinding->psNextBinding = oSymTable->psFirstBinding;
     
@@ -128,50 +244,100 @@ const void *pvValue) {
     return NULL;
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
-    struct Binding *psChecker;
-
-    assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+/* Returns the binding of oSymTable with key pcKey, or NULL if there is
+none. Moves the binding found toward the front of the list as the
+policy of oSymTable says. */
+static struct Binding *SymTable_lookup(SymTable_T oSymTable,
+const char *pcKey) {
+    struct Binding *psCurrent;
+    struct Binding *psPrevious = NULL;
+    struct Binding *psBeforePrevious = NULL;
+    struct Binding *psScan;
+    struct Binding *psBeforeScan = NULL;
 
-    /* Checks if oSymTable is empty. */
-    if(oSymTable->psFirstBinding == NULL) {
-        return 0;
+    /* checks for binding with pcKey in oSymTable, remembering the two
+    bindings before it for relinking */
+    psCurrent = oSymTable->psFirstBinding;
+    while(psCurrent != NULL && strcmp(psCurrent->pcKey, pcKey)) {
+        psBeforePrevious = psPrevious;
+        psPrevious = psCurrent;
+        psCurrent = psCurrent->psNextBinding;
     }
-    
-    /* checks for pcKey in oSYmTable */
-    psChecker = oSymTable->psFirstBinding;
-    while(psChecker != NULL) {
-        if(!strcmp(psChecker->pcKey, pcKey)) {
-            return 1;
-        }
-        psChecker = psChecker->psNextBinding;
+    if(psCurrent == NULL) {
+        return NULL;
+    }
+
+    switch(oSymTable->eOrder) {
+        case SYMTABLE_ORDER_MOVE_TO_FRONT:
+            if(psPrevious != NULL) {
+                psPrevious->psNextBinding = psCurrent->psNextBinding;
+                psCurrent->psNextBinding = oSymTable->psFirstBinding;
+                oSymTable->psFirstBinding = psCurrent;
+            }
+            break;
+
+        case SYMTABLE_ORDER_TRANSPOSE:
+            if(psPrevious != NULL) {
+                psPrevious->psNextBinding = psCurrent->psNextBinding;
+                psCurrent->psNextBinding = psPrevious;
+                if(psBeforePrevious != NULL) {
+                    psBeforePrevious->psNextBinding = psCurrent;
+                }
+                else {
+                    oSymTable->psFirstBinding = psCurrent;
+                }
+            }
+            break;
+
+        case SYMTABLE_ORDER_COUNT:
+            (psCurrent->uHits)++;
+            if(psPrevious == NULL
+            || psPrevious->uHits >= psCurrent->uHits) {
+                break;
+            }
+
+            /* the scan stops at psPrevious at the latest, since it was
+            found fewer times */
+            psScan = oSymTable->psFirstBinding;
+            while(psScan->uHits >= psCurrent->uHits) {
+                psBeforeScan = psScan;
+                psScan = psScan->psNextBinding;
+            }
+            psPrevious->psNextBinding = psCurrent->psNextBinding;
+            psCurrent->psNextBinding = psScan;
+            if(psBeforeScan != NULL) {
+                psBeforeScan->psNextBinding = psCurrent;
+            }
+            else {
+                oSymTable->psFirstBinding = psCurrent;
+            }
+            break;
+
+        default:
+            break;
     }
 
-    return 0;
+    return psCurrent;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_lookup(oSymTable, pcKey) != NULL;
 }
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
-    struct Binding *psChecker;
+    struct Binding *psBinding;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    /* checks for empty oSymTable */
-    if(oSymTable->psFirstBinding == NULL) {
+    psBinding = SymTable_lookup(oSymTable, pcKey);
+    if(psBinding == NULL) {
         return NULL;
     }
-
-    /* checks for binding with pcKey in oSymTable */
-    psChecker = oSymTable->psFirstBinding;
-    while(psChecker != NULL) {
-        if(!strcmp(psChecker->pcKey, pcKey)) {
-            return psChecker->pvValue;
-        }
-        psChecker = psChecker->psNextBinding;
-    }
-
-    return NULL;
+    return psBinding->pvValue;
 }
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
@@ -191,9 +357,8 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
     psCurrent = oSymTable->psFirstBinding;
     if(!strcmp(psCurrent->pcKey, pcKey)) {
         oSymTable->psFirstBinding = psCurrent->psNextBinding;
-        free(psCurrent->pcKey);
         pvTempValue = psCurrent->pvValue;
-        free(psCurrent);
+        SymTable_freeBinding(oSymTable, psCurrent);
         (oSymTable->bindings)--;
         return pvTempValue;
     }
@@ -205,9 +370,8 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
     while(psCurrent != NULL) {
         if(!strcmp(psCurrent->pcKey, pcKey)) {
             psPrevious->psNextBinding = psCurrent->psNextBinding;
-            free(psCurrent->pcKey);
             pvTempValue = psCurrent->pvValue;
-            free(psCurrent);
+            SymTable_freeBinding(oSymTable, psCurrent);
             (oSymTable->bindings)--;
             return pvTempValue;
         }
@@ -218,6 +382,58 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
     return NULL;
 }
 
+void **SymTable_findOrInsert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted) {
+    struct Binding *psChecker;
+    struct Binding *psNewBinding;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* returns the slot of the binding with pcKey if found */
+    psChecker = oSymTable->psFirstBinding;
+    while(psChecker != NULL) {
+        if(!strcmp(psChecker->pcKey, pcKey)) {
+            if(piInserted != NULL) {
+                *piInserted = 0;
+            }
+            return &psChecker->pvValue;
+        }
+        psChecker = psChecker->psNextBinding;
+    }
+
+    /* the walk above showed pcKey is missing, so the new binding goes
+    in front without walking the list again */
+    psNewBinding = SymTable_newBinding(oSymTable, pcKey);
+    if (psNewBinding == NULL) {
+        return NULL;
+    }
+    psNewBinding->pvValue = NULL;
+    psNewBinding->psNextBinding = oSymTable->psFirstBinding;
+    oSymTable->psFirstBinding = psNewBinding;
+    (oSymTable->bindings)++;
+
+    if(piInserted != NULL) {
+        *piInserted = 1;
+    }
+    return &psNewBinding->pvValue;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findOrInsert(oSymTable, pcKey, NULL);
+    if(ppvValue == NULL) {
+        return 0;
+    }
+    *ppvValue = (void *) pvValue;
+    return 1;
+}
+
 void SymTable_map(SymTable_T oSymTable,
 void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
 const void *pvExtra) {
@@ -235,4 +451,41 @@ const void *pvExtra) {
     }
 
     return;
-}
\ No newline at end of file
+}
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->uPosition = 0;
+    psIter->pvNext = oSymTable->psFirstBinding;
+}
+
+int SymTable_iterNext(struct SymTableIter *psIter, const char **ppcKey,
+void **ppvValue) {
+    struct Binding *psCurrentBinding;
+
+    assert(psIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    psCurrentBinding = (struct Binding *)psIter->pvNext;
+    if(psCurrentBinding == NULL) {
+        return 0;
+    }
+
+    /* moves on before returning, so the cursor never points at a
+    binding the caller has already seen */
+    psIter->pvNext = psCurrentBinding->psNextBinding;
+    *ppcKey = psCurrentBinding->pcKey;
+    *ppvValue = psCurrentBinding->pvValue;
+    return 1;
+}
+
+void SymTable_iterEnd(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+
+    psIter->pvNext = NULL;
+}
@@ -0,0 +1,39 @@
+/*--------------------------------------------------------------------*/
+/* symtablelist.h                                                     */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLELIST_INCLUDED
+#define SYMTABLELIST_INCLUDED
+
+#include "symtable.h"
+
+/* Functions that only the linked list implementation of symtable.h
+(symtablelist.c) provides. */
+
+/* How a list reorders itself when SymTable_get or SymTable_contains
+finds a key, so that keys looked up often end up near the front,
+where a lookup finds them sooner:
+
+   SYMTABLE_ORDER_NONE           never; the default
+   SYMTABLE_ORDER_MOVE_TO_FRONT  moves the binding found to the front
+   SYMTABLE_ORDER_TRANSPOSE      swaps it with the binding before it
+   SYMTABLE_ORDER_COUNT          counts the lookups that found it, and
+                                 moves it in front of the first
+                                 binding found fewer times */
+enum SymTableOrder
+{
+   SYMTABLE_ORDER_NONE,
+   SYMTABLE_ORDER_MOVE_TO_FRONT,
+   SYMTABLE_ORDER_TRANSPOSE,
+   SYMTABLE_ORDER_COUNT
+};
+
+/* Sets the policy by which oSymTable reorders itself on successful
+lookups to eOrder. Under any policy but SYMTABLE_ORDER_NONE, a
+successful SymTable_get or SymTable_contains changes the order of the
+pairs, so it ends a cursor's validity as a put or a remove does.
+oSymTable cannot be NULL. */
+void SymTable_setOrder(SymTable_T oSymTable, enum SymTableOrder eOrder);
+
+#endif
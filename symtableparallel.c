@@ -0,0 +1,159 @@
+/*--------------------------------------------------------------------*/
+/* symtableparallel.c                                                 */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include "symtableparallel.h"
+
+/* A MapJob is the share of one thread: slices uFirst through uEnd - 1
+of the table, and the extra parameter its pfApply calls get. */
+struct MapJob
+{
+    SymTable_T oSymTable;
+    size_t uFirst;
+    size_t uEnd;
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+/* Runs the MapJob pvJob. Returns NULL. */
+static void *SymTable_runMapJob(void *pvJob) {
+    struct MapJob *psJob = (struct MapJob *)pvJob;
+
+    SymTable_mapSlice(psJob->oSymTable, psJob->uFirst, psJob->uEnd,
+    psJob->pfApply, psJob->pvExtra);
+    return NULL;
+}
+
+/* Returns the first of the uSlices slices in range uRange of
+uRanges. The first uSlices % uRanges ranges get one slice more than
+the others. */
+static size_t SymTable_rangeStart(size_t uSlices, size_t uRanges,
+size_t uRange) {
+    size_t uLonger = uSlices % uRanges;
+
+    return uSlices / uRanges * uRange
+    + (uRange < uLonger ? uRange : uLonger);
+}
+
+/* Splits the slices of oSymTable into uThreads ranges of about equal
+size and applies *pfApply to each pair of range i, with extra parameter
+ppvExtras[i], on a thread of its own. The calling thread runs range 0,
+and any range whose thread cannot be started. Ranges without slices
+start no thread. If there is insufficient memory to plan the threads,
+runs every range on the calling thread. */
+static void SymTable_mapRanges(SymTable_T oSymTable, size_t uThreads,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+void *const *ppvExtras) {
+    struct MapJob *psJobs;
+    pthread_t *psThreads;
+    int *piStarted;
+    size_t uSlices;
+    size_t uThread;
+
+    uSlices = SymTable_getSliceCount(oSymTable);
+
+    /* more threads than slices would have nothing to do */
+    if(uThreads > uSlices) {
+        uThreads = uSlices;
+    }
+    if(uThreads == 0) {
+        return;
+    }
+
+    psJobs = (struct MapJob *)calloc(uThreads, sizeof(struct MapJob));
+    psThreads = (pthread_t *)calloc(uThreads, sizeof(pthread_t));
+    piStarted = (int *)calloc(uThreads, sizeof(int));
+    if(psJobs == NULL || psThreads == NULL || piStarted == NULL) {
+        free(psJobs);
+        free(psThreads);
+        free(piStarted);
+        for(uThread = 0; uThread < uThreads; uThread++) {
+            SymTable_mapSlice(oSymTable,
+            SymTable_rangeStart(uSlices, uThreads, uThread),
+            SymTable_rangeStart(uSlices, uThreads, uThread + 1),
+            pfApply, ppvExtras[uThread]);
+        }
+        return;
+    }
+
+    for(uThread = 0; uThread < uThreads; uThread++) {
+        psJobs[uThread].oSymTable = oSymTable;
+        psJobs[uThread].uFirst =
+        SymTable_rangeStart(uSlices, uThreads, uThread);
+        psJobs[uThread].uEnd =
+        SymTable_rangeStart(uSlices, uThreads, uThread + 1);
+        psJobs[uThread].pfApply = pfApply;
+        psJobs[uThread].pvExtra = ppvExtras[uThread];
+    }
+
+    /* the calling thread runs the first job itself, and any job whose
+    thread cannot be started */
+    for(uThread = 1; uThread < uThreads; uThread++) {
+        piStarted[uThread] = pthread_create(&psThreads[uThread], NULL,
+        SymTable_runMapJob, &psJobs[uThread]) == 0;
+    }
+    for(uThread = 0; uThread < uThreads; uThread++) {
+        if(!piStarted[uThread]) {
+            SymTable_runMapJob(&psJobs[uThread]);
+        }
+    }
+    for(uThread = 1; uThread < uThreads; uThread++) {
+        if(piStarted[uThread]) {
+            pthread_join(psThreads[uThread], NULL);
+        }
+    }
+
+    free(psJobs);
+    free(psThreads);
+    free(piStarted);
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable, size_t uThreads,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    void **ppvExtras;
+    size_t uThread;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(uThreads > 0);
+
+    if(uThreads == 1) {
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+
+    /* every range gets the same extra parameter */
+    ppvExtras = (void **)calloc(uThreads, sizeof(void *));
+    if(ppvExtras == NULL) {
+        SymTable_map(oSymTable, pfApply, pvExtra);
+        return;
+    }
+    for(uThread = 0; uThread < uThreads; uThread++) {
+        ppvExtras[uThread] = (void *)pvExtra;
+    }
+    SymTable_mapRanges(oSymTable, uThreads, pfApply, ppvExtras);
+    free(ppvExtras);
+}
+
+void SymTable_mapReduce(SymTable_T oSymTable, size_t uThreads,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvAccumulator),
+void (*pfCombine)(void *pvAccumulator, void *pvOther),
+void **ppvAccumulators) {
+    size_t uThread;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+    assert(pfCombine != NULL);
+    assert(ppvAccumulators != NULL);
+    assert(uThreads > 0);
+
+    SymTable_mapRanges(oSymTable, uThreads, pfApply, ppvAccumulators);
+    for(uThread = 1; uThread < uThreads; uThread++) {
+        (*pfCombine)(ppvAccumulators[0], ppvAccumulators[uThread]);
+    }
+}
@@ -0,0 +1,45 @@
+/*--------------------------------------------------------------------*/
+/* symtableparallel.h                                                 */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLEPARALLEL_INCLUDED
+#define SYMTABLEPARALLEL_INCLUDED
+
+#include "symtablehash.h"
+
+/* Functions that walk a SymTable_T object of the hash table
+implementation on several threads. The table is split into uThreads
+ranges of buckets, and each range is walked by a thread of its own,
+the calling thread included. No function may change the table while
+they run. *pfApply runs on several threads at once, and must not call
+any function on the table, not even SymTable_get, which moves bindings
+while the table is resizing. With one thread, or if threads cannot be
+started, the work runs on the calling thread. */
+
+/* Applies function *pfApply to each key/value pair in oSymTable and
+passes pvExtra as an extra parameter, like SymTable_map, using up to
+uThreads threads. *pfApply must be safe to call from several threads
+with the same pvExtra. oSymTable and pfApply cannot be NULL, and
+uThreads must be positive. */
+void SymTable_mapParallel(SymTable_T oSymTable, size_t uThreads,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra);
+
+/* Folds every key/value pair in oSymTable into ppvAccumulators[0],
+using uThreads threads. The caller provides uThreads accumulators,
+ppvAccumulators[0] through ppvAccumulators[uThreads - 1], each holding
+the empty result. Thread i calls
+(*pfApply)(pcKey, pvValue, ppvAccumulators[i]) for each pair in its
+range, with no accumulator shared between threads, so *pfApply needs
+no lock. Afterwards the calling thread calls
+(*pfCombine)(ppvAccumulators[0], ppvAccumulators[i]) for i = 1 through
+uThreads - 1, to fold each accumulator into the first. oSymTable,
+pfApply, pfCombine, and ppvAccumulators cannot be NULL, and uThreads
+must be positive. */
+void SymTable_mapReduce(SymTable_T oSymTable, size_t uThreads,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvAccumulator),
+void (*pfCombine)(void *pvAccumulator, void *pvOther),
+void **ppvAccumulators);
+
+#endif
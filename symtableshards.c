@@ -0,0 +1,319 @@
+/*--------------------------------------------------------------------*/
+/* symtableshards.c                                                   */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtableshards.h"
+
+/* SymTableShards is an array of shards. Every shard is created the
+same way, so they all compute the same hash code for a key, and the
+code computed for routing is passed on to the shard. */
+struct SymTableShards
+{
+    /* number of shards */
+    size_t uShardCount;
+
+    /* the shards */
+    SymTable_T aoShards[1];
+};
+
+/* A MergeJob is the share of one thread of SymTableShards_merge:
+shards uFirstShard, uFirstShard + uStride, ... of every source. */
+struct MergeJob
+{
+    SymTableShards_T oDest;
+    SymTableShards_T *poSources;
+    size_t uSourceCount;
+    size_t uFirstShard;
+    size_t uStride;
+    void *(*pfResolve)(const char *pcKey, void *pvDestValue,
+    void *pvSourceValue, void *pvExtra);
+    const void *pvExtra;
+
+    /* 1 (TRUE) if every merge of the job succeeded */
+    int iSuccessful;
+};
+
+SymTableShards_T SymTableShards_new(size_t uShardCount) {
+    SymTableShards_T oShards;
+    size_t uShard;
+
+    assert(uShardCount > 0);
+
+    if(uShardCount > ((size_t)-1 - offsetof(struct SymTableShards,
+    aoShards)) / sizeof(SymTable_T)) {
+        return NULL;
+    }
+    oShards = (SymTableShards_T)malloc(offsetof(struct SymTableShards,
+    aoShards) + uShardCount * sizeof(SymTable_T));
+    if(oShards == NULL) {
+        return NULL;
+    }
+
+    oShards->uShardCount = uShardCount;
+    for(uShard = 0; uShard < uShardCount; uShard++) {
+        oShards->aoShards[uShard] = SymTable_new();
+        if(oShards->aoShards[uShard] == NULL) {
+            while(uShard > 0) {
+                uShard--;
+                SymTable_free(oShards->aoShards[uShard]);
+            }
+            free(oShards);
+            return NULL;
+        }
+    }
+
+    return oShards;
+}
+
+void SymTableShards_free(SymTableShards_T oShards) {
+    size_t uShard;
+
+    assert(oShards != NULL);
+
+    for(uShard = 0; uShard < oShards->uShardCount; uShard++) {
+        SymTable_free(oShards->aoShards[uShard]);
+    }
+    free(oShards);
+}
+
+size_t SymTableShards_getShardCount(SymTableShards_T oShards) {
+    assert(oShards != NULL);
+    return oShards->uShardCount;
+}
+
+/* Returns the index of the shard of oShards for a key with hash code
+uHash. The shards' own bucket index comes from the unmixed code, so
+routing mixes the code and takes its high bits instead, keeping the
+keys of one shard spread over its buckets. */
+static size_t SymTableShards_route(SymTableShards_T oShards,
+size_t uHash) {
+    uint64_t uMixed = (uint64_t)uHash;
+
+    uMixed ^= uMixed >> 33;
+    uMixed *= 0xFF51AFD7ED558CCDULL;
+    uMixed ^= uMixed >> 33;
+
+    /* scales the high 32 bits to the shard count, without a
+    division */
+    return (size_t)(((uMixed >> 32) * (uint64_t)oShards->uShardCount)
+    >> 32);
+}
+
+/* Returns the hash code of pcKey in the shards of oShards, and stores
+the length of pcKey in *puLength. */
+static size_t SymTableShards_hash(SymTableShards_T oShards,
+const char *pcKey, size_t *puLength) {
+    *puLength = strlen(pcKey);
+    return SymTable_hashKey(oShards->aoShards[0], pcKey, *puLength);
+}
+
+size_t SymTableShards_shardOf(SymTableShards_T oShards,
+const char *pcKey) {
+    size_t uLength;
+
+    assert(oShards != NULL);
+    assert(pcKey != NULL);
+
+    return SymTableShards_route(oShards,
+    SymTableShards_hash(oShards, pcKey, &uLength));
+}
+
+SymTable_T SymTableShards_getShard(SymTableShards_T oShards,
+size_t uShard) {
+    assert(oShards != NULL);
+    assert(uShard < oShards->uShardCount);
+
+    return oShards->aoShards[uShard];
+}
+
+size_t SymTableShards_getLength(SymTableShards_T oShards) {
+    size_t uLength = 0;
+    size_t uShard;
+
+    assert(oShards != NULL);
+
+    for(uShard = 0; uShard < oShards->uShardCount; uShard++) {
+        uLength += SymTable_getLength(oShards->aoShards[uShard]);
+    }
+    return uLength;
+}
+
+int SymTableShards_put(SymTableShards_T oShards, const char *pcKey,
+const void *pvValue) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oShards != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableShards_hash(oShards, pcKey, &uLength);
+    return SymTable_putHashed(
+    oShards->aoShards[SymTableShards_route(oShards, uHash)], pcKey,
+    uLength, uHash, pvValue);
+}
+
+void *SymTableShards_replace(SymTableShards_T oShards,
+const char *pcKey, const void *pvValue) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oShards != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableShards_hash(oShards, pcKey, &uLength);
+    return SymTable_replaceHashed(
+    oShards->aoShards[SymTableShards_route(oShards, uHash)], pcKey,
+    uLength, uHash, pvValue);
+}
+
+int SymTableShards_contains(SymTableShards_T oShards,
+const char *pcKey) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oShards != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableShards_hash(oShards, pcKey, &uLength);
+    return SymTable_containsHashed(
+    oShards->aoShards[SymTableShards_route(oShards, uHash)], pcKey,
+    uLength, uHash);
+}
+
+void *SymTableShards_get(SymTableShards_T oShards, const char *pcKey) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oShards != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableShards_hash(oShards, pcKey, &uLength);
+    return SymTable_getHashed(
+    oShards->aoShards[SymTableShards_route(oShards, uHash)], pcKey,
+    uLength, uHash);
+}
+
+void *SymTableShards_remove(SymTableShards_T oShards,
+const char *pcKey) {
+    size_t uLength;
+    size_t uHash;
+
+    assert(oShards != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTableShards_hash(oShards, pcKey, &uLength);
+    return SymTable_removeHashed(
+    oShards->aoShards[SymTableShards_route(oShards, uHash)], pcKey,
+    uLength, uHash);
+}
+
+void SymTableShards_map(SymTableShards_T oShards,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    size_t uShard;
+
+    assert(oShards != NULL);
+    assert(pfApply != NULL);
+
+    for(uShard = 0; uShard < oShards->uShardCount; uShard++) {
+        SymTable_map(oShards->aoShards[uShard], pfApply, pvExtra);
+    }
+}
+
+/* Runs the MergeJob pvJob. Returns NULL. */
+static void *SymTableShards_runMerge(void *pvJob) {
+    struct MergeJob *psJob = (struct MergeJob *)pvJob;
+    size_t uShard;
+    size_t uSource;
+
+    for(uShard = psJob->uFirstShard;
+    uShard < psJob->oDest->uShardCount; uShard += psJob->uStride) {
+        for(uSource = 0; uSource < psJob->uSourceCount; uSource++) {
+            if(!SymTable_merge(psJob->oDest->aoShards[uShard],
+            psJob->poSources[uSource]->aoShards[uShard],
+            psJob->pfResolve, psJob->pvExtra)) {
+                psJob->iSuccessful = 0;
+            }
+        }
+    }
+    return NULL;
+}
+
+int SymTableShards_merge(SymTableShards_T oDest,
+SymTableShards_T *poSources, size_t uSourceCount, size_t uThreads,
+void *(*pfResolve)(const char *pcKey, void *pvDestValue,
+void *pvSourceValue, void *pvExtra),
+const void *pvExtra) {
+    struct MergeJob *psJobs;
+    pthread_t *psThreads;
+    int *piStarted;
+    size_t uThread;
+    size_t uSource;
+    int iSuccessful = 1;
+
+    assert(oDest != NULL);
+    assert(poSources != NULL);
+    assert(uThreads > 0);
+
+    for(uSource = 0; uSource < uSourceCount; uSource++) {
+        assert(poSources[uSource] != NULL);
+        assert(poSources[uSource] != oDest);
+        assert(poSources[uSource]->uShardCount == oDest->uShardCount);
+    }
+
+    /* more threads than shards would have nothing to do */
+    if(uThreads > oDest->uShardCount) {
+        uThreads = oDest->uShardCount;
+    }
+
+    psJobs = (struct MergeJob *)calloc(uThreads,
+    sizeof(struct MergeJob));
+    psThreads = (pthread_t *)calloc(uThreads, sizeof(pthread_t));
+    piStarted = (int *)calloc(uThreads, sizeof(int));
+    if(psJobs == NULL || psThreads == NULL || piStarted == NULL) {
+        free(psJobs);
+        free(psThreads);
+        free(piStarted);
+        return 0;
+    }
+
+    for(uThread = 0; uThread < uThreads; uThread++) {
+        psJobs[uThread].oDest = oDest;
+        psJobs[uThread].poSources = poSources;
+        psJobs[uThread].uSourceCount = uSourceCount;
+        psJobs[uThread].uFirstShard = uThread;
+        psJobs[uThread].uStride = uThreads;
+        psJobs[uThread].pfResolve = pfResolve;
+        psJobs[uThread].pvExtra = pvExtra;
+        psJobs[uThread].iSuccessful = 1;
+    }
+
+    /* the calling thread runs the first job itself, and any job whose
+    thread cannot be started */
+    for(uThread = 1; uThread < uThreads; uThread++) {
+        piStarted[uThread] = pthread_create(&psThreads[uThread], NULL,
+        SymTableShards_runMerge, &psJobs[uThread]) == 0;
+    }
+    for(uThread = 0; uThread < uThreads; uThread++) {
+        if(!piStarted[uThread]) {
+            SymTableShards_runMerge(&psJobs[uThread]);
+        }
+    }
+    for(uThread = 0; uThread < uThreads; uThread++) {
+        if(piStarted[uThread]) {
+            pthread_join(psThreads[uThread], NULL);
+        }
+        iSuccessful = iSuccessful && psJobs[uThread].iSuccessful;
+    }
+
+    free(psJobs);
+    free(psThreads);
+    free(piStarted);
+    return iSuccessful;
+}
@@ -0,0 +1,89 @@
+/*--------------------------------------------------------------------*/
+/* symtableshards.h                                                   */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLESHARDS_INCLUDED
+#define SYMTABLESHARDS_INCLUDED
+
+#include "symtablehash.h"
+
+/* A SymTableShards_T object stores a collection of key/value pairs
+split over a fixed number of independent SymTable_T objects, its
+shards. Each key belongs to the shard chosen by the high bits of its
+hash code. Different threads may use one SymTableShards_T object at
+once as long as no two of them touch the same shard; for parallel
+ingest, each thread can instead fill a SymTableShards_T object of its
+own, and SymTableShards_merge combines them, shard by shard, on
+several threads. */
+typedef struct SymTableShards *SymTableShards_T;
+
+/* Returns a new SymTableShards_T object of uShardCount empty shards,
+or NULL if insufficient memory is available. uShardCount must be
+positive. */
+SymTableShards_T SymTableShards_new(size_t uShardCount);
+
+/* Frees oShards and its shards. oShards cannot be NULL. */
+void SymTableShards_free(SymTableShards_T oShards);
+
+/* Returns the number of shards of oShards. oShards cannot be NULL. */
+size_t SymTableShards_getShardCount(SymTableShards_T oShards);
+
+/* Returns the index of the shard of oShards that pcKey belongs to.
+SymTableShards_T objects with the same number of shards agree on it.
+oShards and pcKey cannot be NULL. */
+size_t SymTableShards_shardOf(SymTableShards_T oShards,
+const char *pcKey);
+
+/* Returns shard uShard of oShards. A key may only be put into the
+shard that SymTableShards_shardOf chooses for it. oShards cannot be
+NULL, and uShard must be less than the number of shards. */
+SymTable_T SymTableShards_getShard(SymTableShards_T oShards,
+size_t uShard);
+
+/* Returns total number of key/value pairs in oShards. oShards cannot
+be NULL. */
+size_t SymTableShards_getLength(SymTableShards_T oShards);
+
+/* The functions below behave like those of symtable.h, on the shard
+of oShards that pcKey belongs to. oShards and pcKey cannot be NULL. */
+
+int SymTableShards_put(SymTableShards_T oShards, const char *pcKey,
+const void *pvValue);
+
+void *SymTableShards_replace(SymTableShards_T oShards,
+const char *pcKey, const void *pvValue);
+
+int SymTableShards_contains(SymTableShards_T oShards,
+const char *pcKey);
+
+void *SymTableShards_get(SymTableShards_T oShards, const char *pcKey);
+
+void *SymTableShards_remove(SymTableShards_T oShards,
+const char *pcKey);
+
+/* Applies function *pfApply to each key/value pair in oShards, shard
+by shard, and passes pvExtra as an extra parameter. oShards and
+pfApply cannot be NULL. */
+void SymTableShards_map(SymTableShards_T oShards,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra);
+
+/* Moves every pair of the uSourceCount objects poSources[0] through
+poSources[uSourceCount - 1] into oDest, leaving them empty, with
+SymTable_merge on each shard and the same pfResolve and pvExtra.
+Shard i of every source only merges into shard i of oDest, so up to
+uThreads threads merge different shards at once, each doing about
+1/uThreads of the work; *pfResolve must therefore be safe to call from
+several threads for different keys. Every source must have as many
+shards as oDest. Returns 1 (TRUE) if successful and 0 (FALSE) if
+insufficient memory is available, in which case some pairs may remain
+in the sources. oDest and poSources cannot be NULL, and uThreads must
+be positive. */
+int SymTableShards_merge(SymTableShards_T oDest,
+SymTableShards_T *poSources, size_t uSourceCount, size_t uThreads,
+void *(*pfResolve)(const char *pcKey, void *pvDestValue,
+void *pvSourceValue, void *pvExtra),
+const void *pvExtra);
+
+#endif
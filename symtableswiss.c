@@ -0,0 +1,565 @@
+/*--------------------------------------------------------------------*/
+/* symtableswiss.c                                                    */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symtable.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* Bindings live in flat slot arrays that are split into groups of
+GROUP_SIZE slots. Each slot has one control byte. A control byte is
+EMPTY, DELETED, or the low 7 bits of the hash of the key in the slot
+(a FULL slot), so one vector compare over a group's control bytes
+finds every candidate slot in that group. */
+enum {GROUP_SIZE = 16};
+
+/* control byte of a slot that has never held a binding */
+enum {CTRL_EMPTY = 0x80};
+
+/* control byte of a slot whose binding was removed (a tombstone) */
+enum {CTRL_DELETED = 0xFE};
+
+/* number of groups in a new symbol table */
+enum {INITIAL_GROUPS = 32};
+
+/* A bit mask with one entry per slot of a group. Entries are
+MASK_SHIFT bits apart, and only the highest bit of each entry is
+ever set. */
+typedef uint64_t Mask_T;
+
+#if defined(__SSE2__) || !defined(__ARM_NEON)
+enum {MASK_SHIFT = 0};
+#else
+enum {MASK_SHIFT = 2};
+#endif
+
+/* SymTable stores its bindings in open-addressed slot arrays. All
+three arrays are carved out of one allocation. */
+struct SymTable
+{
+   /* one control byte per slot */
+   unsigned char *pucCtrl;
+
+   /* key of each FULL slot */
+   char **ppcKeys;
+
+   /* value of each FULL slot */
+   void **ppvValues;
+
+   /* number of groups, always a power of two */
+   size_t groups;
+
+   /* number of bindings */
+   size_t bindings;
+
+   /* number of EMPTY slots that can still be filled before the slot
+   arrays must be rebuilt */
+   size_t growthLeft;
+};
+
+/* Returns a mask of the slots in the group at pucGroup whose control
+byte equals ucByte. */
+static Mask_T SymTable_matchByte(const unsigned char *pucGroup,
+unsigned char ucByte) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)pucGroup);
+    return (Mask_T)(unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)ucByte)));
+#elif defined(__ARM_NEON)
+    uint8x16_t cmp = vceqq_u8(vld1q_u8(pucGroup), vdupq_n_u8(ucByte));
+    return vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4)), 0)
+        & 0x8888888888888888ULL;
+#else
+    Mask_T mask = 0;
+    size_t u;
+    for(u = 0; u < GROUP_SIZE; u++) {
+        if(pucGroup[u] == ucByte) {
+            mask |= (Mask_T)1 << u;
+        }
+    }
+    return mask;
+#endif
+}
+
+/* Returns a mask of the slots in the group at pucGroup that are
+EMPTY or DELETED, that is, whose control byte has its high bit set. */
+static Mask_T SymTable_matchFree(const unsigned char *pucGroup) {
+#if defined(__SSE2__)
+    return (Mask_T)(unsigned)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)pucGroup));
+#elif defined(__ARM_NEON)
+    uint8x16_t cmp = vtstq_u8(vld1q_u8(pucGroup), vdupq_n_u8(0x80));
+    return vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4)), 0)
+        & 0x8888888888888888ULL;
+#else
+    Mask_T mask = 0;
+    size_t u;
+    for(u = 0; u < GROUP_SIZE; u++) {
+        if(pucGroup[u] & 0x80) {
+            mask |= (Mask_T)1 << u;
+        }
+    }
+    return mask;
+#endif
+}
+
+/* Returns the index within its group of the lowest slot set in mask.
+mask cannot be 0. */
+static size_t SymTable_lowestSlot(Mask_T mask) {
+    size_t u = 0;
+
+    assert(mask != 0);
+
+#if defined(__GNUC__)
+    u = (size_t)__builtin_ctzll((unsigned long long)mask);
+#else
+    while((mask & 1) == 0) {
+        mask >>= 1;
+        u++;
+    }
+#endif
+    return u >> MASK_SHIFT;
+}
+
+/* Return a hash code for pcKey. The low 7 bits become the control
+byte of the key's slot and the remaining bits choose the first group
+to probe, so the 65599 hash is mixed to spread short keys across all
+64 bits. */
+static uint64_t SymTable_hash(const char *pcKey) {
+    const uint64_t HASH_MULTIPLIER = 65599;
+    uint64_t uHash = 0;
+    size_t u;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++) {
+        uHash = uHash * HASH_MULTIPLIER + (uint64_t)pcKey[u];
+    }
+
+    uHash ^= uHash >> 33;
+    uHash *= 0xFF51AFD7ED558CCDULL;
+    uHash ^= uHash >> 33;
+    return uHash;
+}
+
+/* Returns the maximum number of bindings a table with uGroups groups
+may hold. At least one slot in eight stays EMPTY so that every probe
+sequence ends. */
+static size_t SymTable_capacity(size_t uGroups) {
+    return uGroups * GROUP_SIZE - (uGroups * GROUP_SIZE) / 8;
+}
+
+/* Allocates control bytes and slot arrays for uGroups groups and
+installs them in oSymTable, marking every slot EMPTY. Returns 1
+(TRUE) if successful and 0 (FALSE) if there is insufficient memory,
+in which case oSymTable is unchanged. */
+static int SymTable_allocSlots(SymTable_T oSymTable, size_t uGroups) {
+    size_t uSlots = uGroups * GROUP_SIZE;
+    unsigned char *pucBlock;
+
+    pucBlock = (unsigned char *)malloc(uSlots * (1 + sizeof(char *)
+    + sizeof(void *)));
+    if(pucBlock == NULL) {
+        return 0;
+    }
+
+    /* uSlots is a multiple of GROUP_SIZE, so the pointer arrays that
+    follow the control bytes stay aligned */
+    memset(pucBlock, CTRL_EMPTY, uSlots);
+    oSymTable->pucCtrl = pucBlock;
+    oSymTable->ppcKeys = (char **)(void *)(pucBlock + uSlots);
+    oSymTable->ppvValues = (void **)(void *)
+    (oSymTable->ppcKeys + uSlots);
+    oSymTable->groups = uGroups;
+    oSymTable->growthLeft = SymTable_capacity(uGroups);
+
+    return 1;
+}
+
+/* Returns the index of the first EMPTY or DELETED slot on the probe
+sequence of uHash in oSymTable. */
+static size_t SymTable_findFree(SymTable_T oSymTable, uint64_t uHash) {
+    size_t uMask = oSymTable->groups - 1;
+    size_t uGroup = (size_t)(uHash >> 7) & uMask;
+    size_t uStep = 0;
+    Mask_T mask;
+
+    /* triangular probing visits every group once when the number of
+    groups is a power of two */
+    for(;;) {
+        mask = SymTable_matchFree(oSymTable->pucCtrl
+        + uGroup * GROUP_SIZE);
+        if(mask != 0) {
+            return uGroup * GROUP_SIZE + SymTable_lowestSlot(mask);
+        }
+        uStep++;
+        uGroup = (uGroup + uStep) & uMask;
+    }
+}
+
+/* Returns the index of the slot holding pcKey in oSymTable, or the
+number of slots if pcKey is not in oSymTable. uHash must be the hash
+of pcKey. */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+uint64_t uHash) {
+    size_t uMask = oSymTable->groups - 1;
+    size_t uGroup = (size_t)(uHash >> 7) & uMask;
+    size_t uStep = 0;
+    size_t uSlot;
+    unsigned char *pucGroup;
+    Mask_T mask;
+
+    for(;;) {
+        pucGroup = oSymTable->pucCtrl + uGroup * GROUP_SIZE;
+
+        /* compares only the keys whose 7-bit hash matches */
+        mask = SymTable_matchByte(pucGroup,
+        (unsigned char)(uHash & 0x7F));
+        while(mask != 0) {
+            uSlot = uGroup * GROUP_SIZE + SymTable_lowestSlot(mask);
+            if(!strcmp(oSymTable->ppcKeys[uSlot], pcKey)) {
+                return uSlot;
+            }
+            mask &= mask - 1;
+        }
+
+        /* an EMPTY slot ends every probe sequence through this group */
+        if(SymTable_matchByte(pucGroup, CTRL_EMPTY) != 0) {
+            return oSymTable->groups * GROUP_SIZE;
+        }
+        uStep++;
+        uGroup = (uGroup + uStep) & uMask;
+    }
+}
+
+/* Rebuilds the slot arrays of oSymTable with uGroups groups, which
+also discards every tombstone. Returns 1 (TRUE) if successful and 0
+(FALSE) if there is insufficient memory, leaving oSymTable
+unchanged. */
+static int SymTable_rehash(SymTable_T oSymTable, size_t uGroups) {
+    unsigned char *pucOldCtrl = oSymTable->pucCtrl;
+    char **ppcOldKeys = oSymTable->ppcKeys;
+    void **ppvOldValues = oSymTable->ppvValues;
+    size_t uOldSlots = oSymTable->groups * GROUP_SIZE;
+    size_t u;
+    size_t uSlot;
+    uint64_t uHash;
+
+    if(!SymTable_allocSlots(oSymTable, uGroups)) {
+        return 0;
+    }
+
+    /* moves each binding into the new arrays; keys are known to be
+    distinct, so no key comparisons are needed */
+    for(u = 0; u < uOldSlots; u++) {
+        if((pucOldCtrl[u] & 0x80) == 0) {
+            uHash = SymTable_hash(ppcOldKeys[u]);
+            uSlot = SymTable_findFree(oSymTable, uHash);
+            oSymTable->pucCtrl[uSlot] = (unsigned char)(uHash & 0x7F);
+            oSymTable->ppcKeys[uSlot] = ppcOldKeys[u];
+            oSymTable->ppvValues[uSlot] = ppvOldValues[u];
+            (oSymTable->growthLeft)--;
+        }
+    }
+
+    free(pucOldCtrl);
+    return 1;
+}
+
+SymTable_T SymTable_new(void) {
+    SymTable_T oSymTable;
+
+    /* Allocates memory for oSymTable and its slot arrays */
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if(oSymTable == NULL) {
+        return NULL;
+    }
+    if(!SymTable_allocSlots(oSymTable, INITIAL_GROUPS)) {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->bindings = 0;
+    return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable) {
+    size_t uSlots;
+    size_t u;
+
+    assert(oSymTable != NULL);
+
+    /* frees the key of every FULL slot */
+    uSlots = oSymTable->groups * GROUP_SIZE;
+    for(u = 0; u < uSlots; u++) {
+        if((oSymTable->pucCtrl[u] & 0x80) == 0) {
+            free(oSymTable->ppcKeys[u]);
+        }
+    }
+
+    free(oSymTable->pucCtrl);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+    return oSymTable->bindings;
+}
+
+/* Puts a binding of pcKey, whose hash is uHash and which oSymTable
+does not contain, into oSymTable with a NULL value. Returns the index
+of its slot, or the number of slots if there is insufficient memory,
+leaving oSymTable unchanged. */
+static size_t SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+uint64_t uHash) {
+    size_t uSlot;
+    size_t uGroups;
+    char *pcKeyCopy;
+
+    pcKeyCopy = (char *)malloc(strlen(pcKey) + 1);
+    if(pcKeyCopy == NULL) {
+        return oSymTable->groups * GROUP_SIZE;
+    }
+    strcpy(pcKeyCopy, pcKey);
+
+    /* Filling an EMPTY slot uses up growth. When none is left, the
+    table doubles, or is rebuilt at the same size if tombstones are
+    what used it up. */
+    uSlot = SymTable_findFree(oSymTable, uHash);
+    if(oSymTable->pucCtrl[uSlot] == CTRL_EMPTY
+    && oSymTable->growthLeft == 0) {
+        uGroups = oSymTable->groups;
+        if(oSymTable->bindings >= SymTable_capacity(uGroups) / 2) {
+            uGroups *= 2;
+        }
+        if(!SymTable_rehash(oSymTable, uGroups)) {
+            free(pcKeyCopy);
+            return oSymTable->groups * GROUP_SIZE;
+        }
+        uSlot = SymTable_findFree(oSymTable, uHash);
+    }
+
+    if(oSymTable->pucCtrl[uSlot] == CTRL_EMPTY) {
+        (oSymTable->growthLeft)--;
+    }
+    oSymTable->pucCtrl[uSlot] = (unsigned char)(uHash & 0x7F);
+    oSymTable->ppcKeys[uSlot] = pcKeyCopy;
+    oSymTable->ppvValues[uSlot] = NULL;
+    (oSymTable->bindings)++;
+
+    return uSlot;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    size_t uSlot;
+    uint64_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* checks if the symbol table already contains the key */
+    uHash = SymTable_hash(pcKey);
+    if(SymTable_find(oSymTable, pcKey, uHash)
+    != oSymTable->groups * GROUP_SIZE) {
+        return 0;
+    }
+
+    uSlot = SymTable_insert(oSymTable, pcKey, uHash);
+    if(uSlot == oSymTable->groups * GROUP_SIZE) {
+        return 0;
+    }
+    oSymTable->ppvValues[uSlot] = (void *) pvValue;
+
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    size_t uSlot;
+    void *pvTempValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uSlot = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+    if(uSlot == oSymTable->groups * GROUP_SIZE) {
+        return NULL;
+    }
+
+    pvTempValue = oSymTable->ppvValues[uSlot];
+    oSymTable->ppvValues[uSlot] = (void *) pvValue;
+    return pvTempValue;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey) {
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey))
+    != oSymTable->groups * GROUP_SIZE;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey) {
+    size_t uSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uSlot = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+    if(uSlot == oSymTable->groups * GROUP_SIZE) {
+        return NULL;
+    }
+
+    return oSymTable->ppvValues[uSlot];
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey) {
+    size_t uSlot;
+    unsigned char *pucGroup;
+    void *pvTempValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uSlot = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+    if(uSlot == oSymTable->groups * GROUP_SIZE) {
+        return NULL;
+    }
+
+    free(oSymTable->ppcKeys[uSlot]);
+    pvTempValue = oSymTable->ppvValues[uSlot];
+
+    /* If the slot's group still has an EMPTY slot, no probe sequence
+    continues past this group, so the slot can become EMPTY again.
+    Otherwise it must stay a tombstone. */
+    pucGroup = oSymTable->pucCtrl + (uSlot - uSlot % GROUP_SIZE);
+    if(SymTable_matchByte(pucGroup, CTRL_EMPTY) != 0) {
+        oSymTable->pucCtrl[uSlot] = CTRL_EMPTY;
+        (oSymTable->growthLeft)++;
+    }
+    else {
+        oSymTable->pucCtrl[uSlot] = CTRL_DELETED;
+    }
+    (oSymTable->bindings)--;
+
+    return pvTempValue;
+}
+
+void **SymTable_findOrInsert(SymTable_T oSymTable, const char *pcKey,
+int *piInserted) {
+    size_t uSlot;
+    uint64_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* returns the slot of the binding with pcKey if found, without
+    hashing pcKey again to insert it otherwise */
+    uHash = SymTable_hash(pcKey);
+    uSlot = SymTable_find(oSymTable, pcKey, uHash);
+    if(uSlot != oSymTable->groups * GROUP_SIZE) {
+        if(piInserted != NULL) {
+            *piInserted = 0;
+        }
+        return &oSymTable->ppvValues[uSlot];
+    }
+
+    uSlot = SymTable_insert(oSymTable, pcKey, uHash);
+    if(uSlot == oSymTable->groups * GROUP_SIZE) {
+        return NULL;
+    }
+    if(piInserted != NULL) {
+        *piInserted = 1;
+    }
+    return &oSymTable->ppvValues[uSlot];
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+const void *pvValue) {
+    void **ppvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ppvValue = SymTable_findOrInsert(oSymTable, pcKey, NULL);
+    if(ppvValue == NULL) {
+        return 0;
+    }
+    *ppvValue = (void *) pvValue;
+    return 1;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+const void *pvExtra) {
+    size_t uSlots;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* applies pfApply to the binding in every FULL slot */
+    uSlots = oSymTable->groups * GROUP_SIZE;
+    for(u = 0; u < uSlots; u++) {
+        if((oSymTable->pucCtrl[u] & 0x80) == 0) {
+            (*pfApply)(oSymTable->ppcKeys[u], oSymTable->ppvValues[u],
+            (void *) pvExtra);
+        }
+    }
+
+    return;
+}
+
+void SymTable_iterBegin(SymTable_T oSymTable,
+struct SymTableIter *psIter) {
+    assert(oSymTable != NULL);
+    assert(psIter != NULL);
+
+    psIter->oSymTable = oSymTable;
+    psIter->uPosition = 0;
+    psIter->pvNext = NULL;
+}
+
+int SymTable_iterNext(struct SymTableIter *psIter, const char **ppcKey,
+void **ppvValue) {
+    SymTable_T oSymTable;
+    size_t uSlots;
+    size_t u;
+
+    assert(psIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    /* uPosition is the next slot to look at, and is past the last slot
+    once the scan has ended */
+    oSymTable = psIter->oSymTable;
+    uSlots = oSymTable->groups * GROUP_SIZE;
+    for(u = psIter->uPosition; u < uSlots; u++) {
+        if((oSymTable->pucCtrl[u] & 0x80) == 0) {
+            psIter->uPosition = u + 1;
+            *ppcKey = oSymTable->ppcKeys[u];
+            *ppvValue = oSymTable->ppvValues[u];
+            return 1;
+        }
+    }
+    psIter->uPosition = uSlots;
+    return 0;
+}
+
+void SymTable_iterEnd(struct SymTableIter *psIter) {
+    assert(psIter != NULL);
+
+    psIter->uPosition = (size_t)-1;
+}
@@ -431,6 +431,93 @@ static void testMap(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test the SymTable_iterBegin(), SymTable_iterNext(), and
+   SymTable_iterEnd() functions. */
+
+static void testIter(void)
+{
+   enum {BINDING_COUNT = 3000};
+   enum {MAX_KEY_LENGTH = 10};
+   enum {SLICE_LENGTH = 7};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   char acKeys[BINDING_COUNT][MAX_KEY_LENGTH];
+   int aiSeen[BINDING_COUNT];
+   const char *pcKey;
+   void *pvValue;
+   int iSuccessful;
+   int iFound;
+   int iPairs;
+   int iSlice;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable iterator functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has no pairs. */
+   SymTable_iterBegin(oSymTable, &sIter);
+   ASSURE(! SymTable_iterNext(&sIter, &pcKey, &pvValue));
+   ASSURE(! SymTable_iterNext(&sIter, &pcKey, &pvValue));
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i);
+      aiSeen[i] = 0;
+      iSuccessful = SymTable_put(oSymTable, acKeys[i], &aiSeen[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Scan in slices of SLICE_LENGTH pairs, with lookups and
+      replacements between the slices.  Every pair appears once. */
+   SymTable_iterBegin(oSymTable, &sIter);
+   iPairs = 0;
+   iSlice = SLICE_LENGTH;
+   while (iSlice == SLICE_LENGTH)
+   {
+      for (iSlice = 0; iSlice < SLICE_LENGTH; iSlice++)
+      {
+         if (! SymTable_iterNext(&sIter, &pcKey, &pvValue))
+            break;
+         ASSURE(pvValue == SymTable_get(oSymTable, pcKey));
+         (*(int*)pvValue)++;
+         iPairs++;
+      }
+      iFound = SymTable_contains(oSymTable, acKeys[iPairs % 100]);
+      ASSURE(iFound);
+      pvValue = SymTable_replace(oSymTable, "0", &aiSeen[0]);
+      ASSURE(pvValue == &aiSeen[0]);
+   }
+   ASSURE(iPairs == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(aiSeen[i] == 1);
+
+   /* Stop at the first match, and end the scan early. */
+   SymTable_iterBegin(oSymTable, &sIter);
+   iFound = 0;
+   while (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+   {
+      if (strcmp(pcKey, "1234") == 0)
+      {
+         iFound = 1;
+         break;
+      }
+   }
+   ASSURE(iFound);
+   ASSURE(pvValue == &aiSeen[1234]);
+   SymTable_iterEnd(&sIter);
+   ASSURE(! SymTable_iterNext(&sIter, &pcKey, &pvValue));
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test a SymTable object that contains no bindings. */
 
 static void testEmptyTable(void)
@@ -572,6 +659,88 @@ static void testNullValue(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test SymTable_findOrInsert() and SymTable_upsert(). */
+
+static void testFindOrInsert(void)
+{
+   enum {WORD_COUNT = 8};
+
+   SymTable_T oSymTable;
+   const char *apcWords[WORD_COUNT] =
+      {"Ruth", "Gehrig", "Ruth", "Mantle", "Ruth", "Gehrig", "", ""};
+   int aiCounts[WORD_COUNT];
+   int iDistinct = 0;
+   void **ppvValue;
+   char *pcValue;
+   int iInserted;
+   int iSuccessful;
+   size_t uLength;
+   int i;
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_findOrInsert() and SymTable_upsert().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Count the words with one call per word. */
+   for (i = 0; i < WORD_COUNT; i++)
+   {
+      ppvValue = SymTable_findOrInsert(oSymTable, apcWords[i],
+         &iInserted);
+      ASSURE(ppvValue != NULL);
+      if (iInserted)
+      {
+         ASSURE(*ppvValue == NULL);
+         aiCounts[iDistinct] = 0;
+         *ppvValue = &aiCounts[iDistinct];
+         iDistinct++;
+      }
+      (*(int*)*ppvValue)++;
+   }
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 4);
+   ASSURE(iDistinct == 4);
+   ASSURE(*(int*)SymTable_get(oSymTable, "Ruth") == 3);
+   ASSURE(*(int*)SymTable_get(oSymTable, "Gehrig") == 2);
+   ASSURE(*(int*)SymTable_get(oSymTable, "Mantle") == 1);
+   ASSURE(*(int*)SymTable_get(oSymTable, "") == 2);
+
+   /* An existing pair is found, not put again. */
+   ppvValue = SymTable_findOrInsert(oSymTable, "Mantle", NULL);
+   ASSURE(ppvValue != NULL);
+   ASSURE(*(int*)*ppvValue == 1);
+   *ppvValue = acCenterField;
+   pcValue = (char*)SymTable_get(oSymTable, "Mantle");
+   ASSURE(pcValue == acCenterField);
+
+   /* SymTable_upsert() puts new pairs and replaces old values. */
+   iSuccessful = SymTable_upsert(oSymTable, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   iSuccessful = SymTable_upsert(oSymTable, "Jeter", acCenterField);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acCenterField);
+   iSuccessful = SymTable_upsert(oSymTable, "Jeter", NULL);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_contains(oSymTable, "Jeter"));
+   ASSURE(SymTable_get(oSymTable, "Jeter") == NULL);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 5);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to contain long keys. */
 
 static void testLongKey(void)
@@ -636,6 +805,118 @@ static void testLongKey(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Store in pcKey iPrefixLength tildes, then the byte iFirst, then the
+   byte iSecond unless it is 0. */
+
+static void makeByteKey(char *pcKey, int iPrefixLength, int iFirst,
+   int iSecond)
+{
+   memset(pcKey, '~', (size_t)iPrefixLength);
+   pcKey[iPrefixLength] = (char)iFirst;
+   pcKey[iPrefixLength + 1] = (char)iSecond;
+   pcKey[iPrefixLength + 2] = '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ability of a SymTable object to contain keys made of any
+   nonzero bytes, many of them sharing each byte value at the same
+   position, with and without a long common prefix. */
+
+static void testKeyBytes(void)
+{
+   enum {PREFIX_LENGTH = 40};
+
+   /* the value of the key with bytes i and j is &acValues[256*i+j] */
+   static char acValues[256 * 256];
+
+   SymTable_T oSymTable;
+   char acKey[PREFIX_LENGTH + 3];
+   char *pcValue;
+   size_t uCount;
+   int iPrefixLength;
+   int iFirst;
+   int iSecond;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with keys of all byte values.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iPrefixLength = 0; iPrefixLength <= PREFIX_LENGTH;
+      iPrefixLength += PREFIX_LENGTH)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         exit(EXIT_FAILURE);
+
+      /* Every one-byte key, and every two-byte key for some first
+         bytes. */
+      uCount = 0;
+      for (iFirst = 1; iFirst < 256; iFirst++)
+         for (iSecond = 0; iSecond < 256; iSecond++)
+         {
+            if (iSecond != 0 && iFirst % 32 != 1)
+               break;
+            makeByteKey(acKey, iPrefixLength, iFirst, iSecond);
+            iSuccessful = SymTable_put(oSymTable, acKey,
+               &acValues[256 * iFirst + iSecond]);
+            ASSURE(iSuccessful);
+            uCount++;
+         }
+      ASSURE(SymTable_getLength(oSymTable) == uCount);
+
+      /* Remove the keys with an odd last byte, then check all. */
+      for (iFirst = 1; iFirst < 256; iFirst++)
+         for (iSecond = 0; iSecond < 256; iSecond++)
+         {
+            if (iSecond != 0 && iFirst % 32 != 1)
+               break;
+            makeByteKey(acKey, iPrefixLength, iFirst, iSecond);
+            if ((iSecond == 0 ? iFirst : iSecond) % 2 == 1)
+            {
+               pcValue = (char*)SymTable_remove(oSymTable, acKey);
+               ASSURE(pcValue == &acValues[256 * iFirst + iSecond]);
+               uCount--;
+            }
+         }
+      ASSURE(SymTable_getLength(oSymTable) == uCount);
+      for (iFirst = 1; iFirst < 256; iFirst++)
+         for (iSecond = 0; iSecond < 256; iSecond++)
+         {
+            if (iSecond != 0 && iFirst % 32 != 1)
+               break;
+            makeByteKey(acKey, iPrefixLength, iFirst, iSecond);
+            pcValue = (char*)SymTable_get(oSymTable, acKey);
+            if ((iSecond == 0 ? iFirst : iSecond) % 2 == 1)
+               ASSURE(pcValue == NULL);
+            else
+               ASSURE(pcValue == &acValues[256 * iFirst + iSecond]);
+         }
+
+      /* Remove the rest. */
+      for (iFirst = 1; iFirst < 256; iFirst++)
+         for (iSecond = 0; iSecond < 256; iSecond++)
+         {
+            if (iSecond != 0 && iFirst % 32 != 1)
+               break;
+            makeByteKey(acKey, iPrefixLength, iFirst, iSecond);
+            if ((iSecond == 0 ? iFirst : iSecond) % 2 == 0)
+            {
+               pcValue = (char*)SymTable_remove(oSymTable, acKey);
+               ASSURE(pcValue == &acValues[256 * iFirst + iSecond]);
+            }
+         }
+      ASSURE(SymTable_getLength(oSymTable) == 0);
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of SymTable object to have values that are
    other SymTable objects. */
 
@@ -954,10 +1235,13 @@ int main(int argc, char *argv[])
    testKeyOwnership();
    testRemove();
    testMap();
+   testIter();
    testEmptyTable();
    testEmptyKey();
    testNullValue();
+   testFindOrInsert();
    testLongKey();
+   testKeyBytes();
    testTableOfTables();
    testCollisions();
    testLargeTable(iBindingCount);
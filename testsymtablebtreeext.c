@@ -0,0 +1,323 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablebtreeext.c                                             */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtablebtree.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {KEY_COUNT = 20000};
+enum {MAX_KEY_LENGTH = 24};
+
+/* the keys, with long shared prefixes so that comparisons go past
+   the bytes kept in the nodes */
+static char acKeys[KEY_COUNT][MAX_KEY_LENGTH];
+
+/* aiPresent[i] is 1 if key i is in the table under test, else 0 */
+static int aiPresent[KEY_COUNT];
+
+/* The state of checkBinding: the key it saw last, and the number of
+   keys it saw. */
+
+struct Check
+{
+   const char *pcLastKey;
+   size_t uCount;
+   int iInOrder;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next value of the pseudo-random sequence whose state is
+   *puState. */
+
+static size_t nextRandom(size_t *puState)
+{
+   *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+   return *puState >> 16;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pcKey comes after the last key seen by the Check
+   pvExtra, and that pvValue is the value put for it.  Count it. */
+
+static void checkBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct Check *psCheck = (struct Check*)pvExtra;
+
+   if (psCheck->pcLastKey != NULL
+      && strcmp(psCheck->pcLastKey, pcKey) >= 0)
+      psCheck->iInOrder = 0;
+   if (strcmp((char*)pvValue, pcKey) != 0)
+      psCheck->iInOrder = 0;
+   psCheck->pcLastKey = pcKey;
+   psCheck->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of keys in the table under test that are not
+   less than pcLow and, unless pcHigh is NULL, less than pcHigh. */
+
+static size_t countRange(const char *pcLow, const char *pcHigh)
+{
+   size_t uCount = 0;
+   int i;
+
+   for (i = 0; i < KEY_COUNT; i++)
+      if (aiPresent[i] && strcmp(acKeys[i], pcLow) >= 0
+         && (pcHigh == NULL || strcmp(acKeys[i], pcHigh) < 0))
+         uCount++;
+   return uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTable holds exactly the present keys, in order. */
+
+static void checkTable(SymTable_T oSymTable)
+{
+   struct Check sCheck;
+   size_t uPresent = 0;
+   int i;
+
+   for (i = 0; i < KEY_COUNT; i++)
+      uPresent += (size_t)aiPresent[i];
+   ASSURE(SymTable_getLength(oSymTable) == uPresent);
+
+   sCheck.pcLastKey = NULL;
+   sCheck.uCount = 0;
+   sCheck.iInOrder = 1;
+   SymTable_map(oSymTable, checkBinding, &sCheck);
+   ASSURE(sCheck.iInOrder);
+   ASSURE(sCheck.uCount == uPresent);
+
+   for (i = 0; i < KEY_COUNT; i += 97)
+      ASSURE(SymTable_contains(oSymTable, acKeys[i]) == aiPresent[i]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test random puts and removes, which split, merge, and rebalance the
+   nodes of the tree, against a record of the keys that should be in
+   it. */
+
+static void testOrder(void)
+{
+   SymTable_T oSymTable;
+   size_t uState = 217;
+   size_t uStep;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of a B+-tree under puts and removes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   for (uStep = 0; uStep < 8 * KEY_COUNT; uStep++)
+   {
+      i = (int)(nextRandom(&uState) % KEY_COUNT);
+      /* Grow for the first half and shrink for the second. */
+      if ((nextRandom(&uState) % 4 != 0) == (uStep < 4 * KEY_COUNT))
+      {
+         iSuccessful = SymTable_put(oSymTable, acKeys[i], acKeys[i]);
+         ASSURE(iSuccessful == ! aiPresent[i]);
+         aiPresent[i] = 1;
+      }
+      else
+      {
+         ASSURE(SymTable_remove(oSymTable, acKeys[i])
+            == (aiPresent[i] ? acKeys[i] : NULL));
+         aiPresent[i] = 0;
+      }
+      if (uStep % 9973 == 0)
+         checkTable(oSymTable);
+   }
+   checkTable(oSymTable);
+
+   /* Remove the rest in key order, then in reverse order after
+      filling the table again. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      if (aiPresent[i])
+         ASSURE(SymTable_remove(oSymTable, acKeys[i]) == acKeys[i]);
+      aiPresent[i] = 0;
+   }
+   checkTable(oSymTable);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, acKeys[i], acKeys[i]);
+      ASSURE(iSuccessful);
+      aiPresent[i] = 1;
+   }
+   checkTable(oSymTable);
+   for (i = KEY_COUNT - 1; i >= 0; i--)
+   {
+      ASSURE(SymTable_remove(oSymTable, acKeys[i]) == acKeys[i]);
+      aiPresent[i] = 0;
+   }
+   checkTable(oSymTable);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_lowerBound(), SymTable_mapRange(), and
+   SymTable_mapPrefix(). */
+
+static void testRanges(void)
+{
+   /* prefixes, and the first key after all the keys with each */
+   static const char *apcPrefixes[] = {"ns::", "ns::detail::1",
+      "ns::detail::123", "other::"};
+   static const char *apcEnds[] = {"ns:;", "ns::detail::2",
+      "ns::detail::124", "other:;"};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   struct Check sCheck;
+   const char *pcKey;
+   void *pvValue;
+   size_t uState = 1;
+   size_t uCount;
+   int iSuccessful;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_lowerBound() and the range scans.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   /* Put every other key. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      aiPresent[i] = i % 2;
+      if (aiPresent[i])
+      {
+         iSuccessful = SymTable_put(oSymTable, acKeys[i], acKeys[i]);
+         ASSURE(iSuccessful);
+      }
+   }
+
+   /* The lower bound of a key is the key itself if present, and
+      otherwise the next larger key. */
+   for (i = 0; i < KEY_COUNT; i += 7)
+   {
+      SymTable_lowerBound(oSymTable, acKeys[i], &sIter);
+      if (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+      {
+         ASSURE(strcmp(pcKey, acKeys[i]) >= 0);
+         ASSURE(! aiPresent[i] || strcmp(pcKey, acKeys[i]) == 0);
+         ASSURE(countRange(acKeys[i], pcKey) == 0);
+         ASSURE(strcmp((char*)pvValue, pcKey) == 0);
+      }
+      else
+         ASSURE(countRange(acKeys[i], NULL) == 0);
+   }
+   SymTable_lowerBound(oSymTable, "", &sIter);
+   uCount = 0;
+   while (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+      uCount++;
+   ASSURE(uCount == KEY_COUNT / 2);
+   SymTable_lowerBound(oSymTable, "\177", &sIter);
+   ASSURE(! SymTable_iterNext(&sIter, &pcKey, &pvValue));
+
+   /* Random ranges, open and closed. */
+   for (j = 0; j < 200; j++)
+   {
+      i = (int)(nextRandom(&uState) % KEY_COUNT);
+      sCheck.pcLastKey = NULL;
+      sCheck.uCount = 0;
+      sCheck.iInOrder = 1;
+      if (j % 10 == 0)
+      {
+         uCount = SymTable_mapRange(oSymTable, acKeys[i], NULL,
+            checkBinding, &sCheck);
+         ASSURE(uCount == countRange(acKeys[i], NULL));
+      }
+      else
+      {
+         pcKey = acKeys[nextRandom(&uState) % KEY_COUNT];
+         uCount = SymTable_mapRange(oSymTable, acKeys[i], pcKey,
+            checkBinding, &sCheck);
+         ASSURE(uCount == countRange(acKeys[i], pcKey));
+      }
+      ASSURE(sCheck.uCount == uCount);
+      ASSURE(sCheck.iInOrder);
+   }
+
+   /* Prefixes of several lengths, including one that no key has. */
+   for (j = 0; j < 4; j++)
+   {
+      sCheck.pcLastKey = NULL;
+      sCheck.uCount = 0;
+      sCheck.iInOrder = 1;
+      uCount = SymTable_mapPrefix(oSymTable, apcPrefixes[j],
+         checkBinding, &sCheck);
+      ASSURE(uCount == countRange(apcPrefixes[j], apcEnds[j]));
+      ASSURE(sCheck.uCount == uCount);
+      ASSURE(sCheck.iInOrder);
+   }
+   ASSURE(countRange("ns::", "ns:;") == KEY_COUNT / 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that only the B+-tree implementation of the
+   SymTable ADT provides. Write the output of the tests to stdout.
+   Return 0. */
+
+int main(void)
+{
+   int i;
+
+   for (i = 0; i < KEY_COUNT; i++)
+      sprintf(acKeys[i], "ns::detail::%d", i);
+
+   testOrder();
+   testRanges();
+
+   printf("------------------------------------------------------\n");
+   printf("End of testsymtablebtreeext.\n");
+   return 0;
+}
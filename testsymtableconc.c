@@ -0,0 +1,371 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableconc.c                                                 */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtableconc.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the count *pvExtra.  pcKey and pvValue are unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTableConc functions from a single thread, on a table
+   from *pfNew, described by pcKind. */
+
+static void testBasics(SymTableConc_T (*pfNew)(void),
+   const char *pcKind)
+{
+   enum {BINDING_COUNT = 5000};
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTableConc_T oSymTable;
+   char acKeys[BINDING_COUNT][MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   size_t uCount;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTableConc functions in one thread,\n");
+   printf("%s.\n", pcKind);
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = (*pfNew)();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableConc_getLength(oSymTable) == 0);
+
+   iSuccessful = SymTableConc_put(oSymTable, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableConc_put(oSymTable, "Jeter", acCenterField);
+   ASSURE(! iSuccessful);
+   ASSURE(SymTableConc_contains(oSymTable, "Jeter"));
+   ASSURE(! SymTableConc_contains(oSymTable, "Mantle"));
+   ASSURE(SymTableConc_get(oSymTable, "Jeter") == acShortstop);
+   ASSURE(SymTableConc_get(oSymTable, "Mantle") == NULL);
+   ASSURE(SymTableConc_replace(oSymTable, "Jeter", acCenterField)
+      == acShortstop);
+   ASSURE(SymTableConc_replace(oSymTable, "Mantle", acShortstop)
+      == NULL);
+   ASSURE(SymTableConc_get(oSymTable, "Jeter") == acCenterField);
+   ASSURE(SymTableConc_remove(oSymTable, "Jeter") == acCenterField);
+   ASSURE(SymTableConc_remove(oSymTable, "Jeter") == NULL);
+   ASSURE(SymTableConc_getLength(oSymTable) == 0);
+
+   /* Enough bindings to expand the table several times. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i);
+      iSuccessful = SymTableConc_put(oSymTable, acKeys[i], acKeys[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTableConc_getLength(oSymTable) == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(SymTableConc_get(oSymTable, acKeys[i]) == acKeys[i]);
+
+   uCount = 0;
+   SymTableConc_map(oSymTable, countBinding, &uCount);
+   ASSURE(uCount == BINDING_COUNT);
+
+   for (i = 0; i < BINDING_COUNT; i += 2)
+      ASSURE(SymTableConc_remove(oSymTable, acKeys[i]) == acKeys[i]);
+   ASSURE(SymTableConc_getLength(oSymTable) == BINDING_COUNT / 2);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(SymTableConc_contains(oSymTable, acKeys[i]) == (i % 2));
+
+   SymTableConc_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {THREAD_COUNT = 8};
+enum {KEYS_PER_THREAD = 4000};
+enum {THREAD_KEY_LENGTH = 16};
+
+/* A Worker is the work of one thread of testThreads: its own range of
+   keys, and the number of checks that failed. */
+
+struct Worker
+{
+   SymTableConc_T oSymTable;
+   int iThread;
+   char acKeys[KEYS_PER_THREAD][THREAD_KEY_LENGTH];
+   int iFailures;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Put the keys of the Worker pvWorker, check them while other
+   threads put theirs, replace half of them, and remove the other
+   half.  Return NULL. */
+
+static void *runWorker(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   SymTableConc_T oSymTable = psWorker->oSymTable;
+   int i;
+
+   for (i = 0; i < KEYS_PER_THREAD; i++)
+   {
+      sprintf(psWorker->acKeys[i], "%d.%d", psWorker->iThread, i);
+      if (! SymTableConc_put(oSymTable, psWorker->acKeys[i],
+         psWorker->acKeys[i]))
+         psWorker->iFailures++;
+   }
+   for (i = 0; i < KEYS_PER_THREAD; i++)
+      if (SymTableConc_get(oSymTable, psWorker->acKeys[i])
+         != psWorker->acKeys[i])
+         psWorker->iFailures++;
+   for (i = 0; i < KEYS_PER_THREAD; i++)
+   {
+      if (i % 2 == 0)
+      {
+         if (SymTableConc_remove(oSymTable, psWorker->acKeys[i])
+            != psWorker->acKeys[i])
+            psWorker->iFailures++;
+      }
+      else if (SymTableConc_replace(oSymTable, psWorker->acKeys[i],
+         psWorker) != psWorker->acKeys[i])
+         psWorker->iFailures++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test THREAD_COUNT threads changing one table from *pfNew,
+   described by pcKind, at once, each with keys of its own, while the
+   table expands. */
+
+static void testThreads(SymTableConc_T (*pfNew)(void),
+   const char *pcKind)
+{
+   SymTableConc_T oSymTable;
+   struct Worker *psWorkers;
+   pthread_t aThreads[THREAD_COUNT];
+   char acKey[THREAD_KEY_LENGTH];
+   int iThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTableConc functions in %d threads,\n",
+      THREAD_COUNT);
+   printf("%s.\n", pcKind);
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = (*pfNew)();
+   ASSURE(oSymTable != NULL);
+   psWorkers = (struct Worker*)
+      calloc(THREAD_COUNT, sizeof(struct Worker));
+   ASSURE(psWorkers != NULL);
+   if (oSymTable == NULL || psWorkers == NULL)
+      exit(EXIT_FAILURE);
+
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+   {
+      psWorkers[iThread].oSymTable = oSymTable;
+      psWorkers[iThread].iThread = iThread;
+      ASSURE(pthread_create(&aThreads[iThread], NULL, runWorker,
+         &psWorkers[iThread]) == 0);
+   }
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+   {
+      ASSURE(pthread_join(aThreads[iThread], NULL) == 0);
+      ASSURE(psWorkers[iThread].iFailures == 0);
+   }
+
+   /* Each thread left the odd half of its keys, replaced. */
+   ASSURE(SymTableConc_getLength(oSymTable)
+      == THREAD_COUNT * KEYS_PER_THREAD / 2);
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+      for (i = 0; i < KEYS_PER_THREAD; i++)
+      {
+         sprintf(acKey, "%d.%d", iThread, i);
+         ASSURE(SymTableConc_get(oSymTable, acKey)
+            == (i % 2 ? &psWorkers[iThread] : NULL));
+      }
+
+   free(psWorkers);
+   SymTableConc_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {STABLE_KEY_COUNT = 1000};
+enum {READ_ROUNDS = 200};
+enum {CHURN_ROUNDS = 20};
+
+/* A Churn is the work of one thread of testReaders, which either
+   reads the stable keys or puts and removes keys of its own. */
+
+struct Churn
+{
+   SymTableConc_T oSymTable;
+   char (*pacStableKeys)[THREAD_KEY_LENGTH];
+   int iThread;
+   int iFailures;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Get every stable key of the Churn pvChurn READ_ROUNDS times,
+   checking that each is found with its value.  Return NULL. */
+
+static void *readStable(void *pvChurn)
+{
+   struct Churn *psChurn = (struct Churn*)pvChurn;
+   int iRound;
+   int i;
+
+   for (iRound = 0; iRound < READ_ROUNDS; iRound++)
+      for (i = 0; i < STABLE_KEY_COUNT; i++)
+         if (SymTableConc_get(psChurn->oSymTable,
+            psChurn->pacStableKeys[i]) != psChurn->pacStableKeys[i])
+            psChurn->iFailures++;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put KEYS_PER_THREAD keys of the Churn pvChurn's own and remove them
+   again, CHURN_ROUNDS times.  Return NULL. */
+
+static void *churnKeys(void *pvChurn)
+{
+   struct Churn *psChurn = (struct Churn*)pvChurn;
+   char acKey[THREAD_KEY_LENGTH];
+   int iRound;
+   int i;
+
+   for (iRound = 0; iRound < CHURN_ROUNDS; iRound++)
+   {
+      for (i = 0; i < KEYS_PER_THREAD; i++)
+      {
+         sprintf(acKey, "c%d.%d", psChurn->iThread, i);
+         if (! SymTableConc_put(psChurn->oSymTable, acKey, psChurn))
+            psChurn->iFailures++;
+      }
+      for (i = 0; i < KEYS_PER_THREAD; i++)
+      {
+         sprintf(acKey, "c%d.%d", psChurn->iThread, i);
+         if (SymTableConc_remove(psChurn->oSymTable, acKey) != psChurn)
+            psChurn->iFailures++;
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test threads that only get keys of a table from
+   SymTableConc_newLockFreeReads while other threads put and remove
+   other keys, so that bindings and bucket arrays are retired under
+   the readers. */
+
+static void testReaders(void)
+{
+   SymTableConc_T oSymTable;
+   char (*pacStableKeys)[THREAD_KEY_LENGTH];
+   struct Churn asChurns[THREAD_COUNT];
+   pthread_t aThreads[THREAD_COUNT];
+   int iThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lock-free readers while other threads write.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTableConc_newLockFreeReads();
+   ASSURE(oSymTable != NULL);
+   pacStableKeys = (char (*)[THREAD_KEY_LENGTH])
+      malloc(STABLE_KEY_COUNT * THREAD_KEY_LENGTH);
+   ASSURE(pacStableKeys != NULL);
+   if (oSymTable == NULL || pacStableKeys == NULL)
+      exit(EXIT_FAILURE);
+
+   for (i = 0; i < STABLE_KEY_COUNT; i++)
+   {
+      sprintf(pacStableKeys[i], "s%d", i);
+      ASSURE(SymTableConc_put(oSymTable, pacStableKeys[i],
+         pacStableKeys[i]));
+   }
+
+   /* Half the threads read, half write. */
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+   {
+      asChurns[iThread].oSymTable = oSymTable;
+      asChurns[iThread].pacStableKeys = pacStableKeys;
+      asChurns[iThread].iThread = iThread;
+      asChurns[iThread].iFailures = 0;
+      ASSURE(pthread_create(&aThreads[iThread], NULL,
+         iThread % 2 ? churnKeys : readStable, &asChurns[iThread])
+         == 0);
+   }
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+   {
+      ASSURE(pthread_join(aThreads[iThread], NULL) == 0);
+      ASSURE(asChurns[iThread].iFailures == 0);
+   }
+
+   ASSURE(SymTableConc_getLength(oSymTable) == STABLE_KEY_COUNT);
+   for (i = 0; i < STABLE_KEY_COUNT; i++)
+      ASSURE(SymTableConc_get(oSymTable, pacStableKeys[i])
+         == pacStableKeys[i]);
+
+   SymTableConc_free(oSymTable);
+   free(pacStableKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the concurrent hash table implementation of the SymTable ADT.
+   Write the output of the tests to stdout. Return 0. */
+
+int main(void)
+{
+   testBasics(SymTableConc_new, "with locked reads");
+   testBasics(SymTableConc_newLockFreeReads, "with lock-free reads");
+   testThreads(SymTableConc_new, "with locked reads");
+   testThreads(SymTableConc_newLockFreeReads, "with lock-free reads");
+   testReaders();
+
+   printf("------------------------------------------------------\n");
+   printf("End of testsymtableconc.\n");
+   return 0;
+}
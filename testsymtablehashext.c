@@ -0,0 +1,1136 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablehashext.c                                              */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test interning keys and using the resulting atoms. */
+
+static void testAtoms(void)
+{
+   enum {ATOM_COUNT = 3000};
+   enum {MAX_KEY_LENGTH = 64};
+
+   SymTable_T oSymTable;
+   SymAtom_T oJeter;
+   SymAtom_T oJeter2;
+   SymAtom_T oLong;
+   SymAtom_T aoAtoms[ATOM_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   char acLongKey[] = "a key much too long to be stored in a binding";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char *pcValue;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_intern() and the atom functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Interning the same key twice yields the same atom. */
+   strcpy(acKey, "Jeter");
+   oJeter = SymTable_intern(oSymTable, acKey);
+   ASSURE(oJeter != NULL);
+   strcpy(acKey, "xxx");
+   oJeter2 = SymTable_intern(oSymTable, "Jeter");
+   ASSURE(oJeter2 == oJeter);
+   ASSURE(strcmp(SymAtom_getKey(oJeter), "Jeter") == 0);
+
+   /* Interning does not put a binding. */
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(! SymTable_containsAtom(oSymTable, oJeter));
+
+   /* Atoms and plain keys find the same bindings. */
+   iSuccessful = SymTable_putAtom(oSymTable, oJeter, acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acCenterField);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+
+   iSuccessful = SymTable_put(oSymTable, acLongKey, acShortstop);
+   ASSURE(iSuccessful);
+   oLong = SymTable_intern(oSymTable, acLongKey);
+   ASSURE(oLong != NULL);
+   iSuccessful = SymTable_putAtom(oSymTable, oLong, acCenterField);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_getAtom(oSymTable, oLong);
+   ASSURE(pcValue == acShortstop);
+
+   pcValue = (char*)
+      SymTable_replaceAtom(oSymTable, oJeter, acCenterField);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_getAtom(oSymTable, oJeter);
+   ASSURE(pcValue == acCenterField);
+
+   /* An atom outlives the removal of its binding. */
+   pcValue = (char*)SymTable_removeAtom(oSymTable, oJeter);
+   ASSURE(pcValue == acCenterField);
+   ASSURE(! SymTable_containsAtom(oSymTable, oJeter));
+   ASSURE(strcmp(SymAtom_getKey(oJeter), "Jeter") == 0);
+   pcValue = (char*)SymTable_removeAtom(oSymTable, oJeter);
+   ASSURE(pcValue == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   /* Enough atoms and bindings to grow both hash tables. Odd atoms
+      stand for long keys. */
+   for (i = 0; i < ATOM_COUNT; i++)
+   {
+      sprintf(acKey, (i % 2) ? "%d: %s" : "%d", i, acLongKey);
+      aoAtoms[i] = SymTable_intern(oSymTable, acKey);
+      ASSURE(aoAtoms[i] != NULL);
+      iSuccessful = SymTable_putAtom(oSymTable, aoAtoms[i],
+         aoAtoms[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == ATOM_COUNT + 1);
+   for (i = 0; i < ATOM_COUNT; i++)
+   {
+      sprintf(acKey, (i % 2) ? "%d: %s" : "%d", i, acLongKey);
+      ASSURE(SymTable_intern(oSymTable, acKey) == aoAtoms[i]);
+      ASSURE(SymTable_get(oSymTable, acKey) == aoAtoms[i]);
+   }
+   for (i = 0; i < ATOM_COUNT; i += 3)
+   {
+      pcValue = (char*)SymTable_removeAtom(oSymTable, aoAtoms[i]);
+      ASSURE(pcValue == (char*)aoAtoms[i]);
+   }
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that take keys as slices of a buffer, with and
+   without a precomputed hash code. */
+
+static void testSlices(void)
+{
+   enum {SLICE_COUNT = 2000};
+   enum {MAX_KEY_LENGTH = 64};
+
+   SymTable_T oSymTable;
+   /* no '\0' between the keys, so every key must be a slice */
+   const char acSource[] = "Ruth Gehrig RuthlessGehrigJeter"
+      "a key much too long to be stored in a binding";
+   char acKey[MAX_KEY_LENGTH];
+   char *pcBuffer;
+   char *pcValue;
+   size_t uHash;
+   size_t uOffset;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the N and Hashed functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* A slice matches the '\0'-terminated key with the same
+      characters, and no key that it is a prefix of. */
+   iSuccessful = SymTable_putN(oSymTable, acSource, 4, "Ruth");
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(! SymTable_containsN(oSymTable, acSource, 3));
+   ASSURE(! SymTable_containsN(oSymTable, acSource + 12, 8));
+   pcValue = (char*)SymTable_getN(oSymTable, acSource + 12, 4);
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Ruth") == 0);
+
+   iSuccessful = SymTable_put(oSymTable, "Ruthless", "Ruthless");
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_getN(oSymTable, acSource + 12, 8);
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Ruthless") == 0);
+   iSuccessful = SymTable_putN(oSymTable, acSource + 12, 8, "x");
+   ASSURE(! iSuccessful);
+
+   /* The empty key is a key like any other. */
+   iSuccessful = SymTable_putN(oSymTable, acSource, 0, "empty");
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "empty") == 0);
+
+   /* A long slice gets a '\0'-terminated copy of its own. */
+   iSuccessful = SymTable_putN(oSymTable, acSource + 31, 45, "long");
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable,
+      "a key much too long to be stored in a binding");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "long") == 0);
+
+   /* The Hashed functions agree with the N functions. */
+   uHash = SymTable_hashKey(oSymTable, acSource + 5, 6);
+   ASSURE(uHash == SymTable_hashKey(oSymTable, "Gehrig", 6));
+   iSuccessful = SymTable_putHashed(oSymTable, acSource + 5, 6, uHash,
+      "Gehrig");
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_containsN(oSymTable, acSource + 20, 6));
+   ASSURE(SymTable_containsHashed(oSymTable, acSource + 20, 6, uHash));
+   pcValue = (char*)SymTable_replaceHashed(oSymTable, acSource + 20,
+      6, uHash, "Lou");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Gehrig") == 0);
+   pcValue = (char*)SymTable_getHashed(oSymTable, acSource + 5, 6,
+      uHash);
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Lou") == 0);
+   pcValue = (char*)SymTable_replaceN(oSymTable, "Gehrig", 6, "Gehrig");
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Lou") == 0);
+   pcValue = (char*)SymTable_removeHashed(oSymTable, acSource + 5, 6,
+      uHash);
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Gehrig") == 0);
+   ASSURE(! SymTable_contains(oSymTable, "Gehrig"));
+   pcValue = (char*)SymTable_removeN(oSymTable, acSource, 4);
+   ASSURE(pcValue != NULL && strcmp(pcValue, "Ruth") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+
+   /* Enough slices of one buffer to grow the hash table. */
+   pcBuffer = (char*)malloc((size_t)SLICE_COUNT * MAX_KEY_LENGTH);
+   ASSURE(pcBuffer != NULL);
+   if (pcBuffer == NULL)
+   {
+      SymTable_free(oSymTable);
+      return;
+   }
+   uOffset = 0;
+   for (i = 0; i < SLICE_COUNT; i++)
+   {
+      sprintf(acKey, (i % 2) ? "%d:%s" : "%d", i, acSource + 31);
+      memcpy(pcBuffer + uOffset, acKey, strlen(acKey));
+      iSuccessful = SymTable_putN(oSymTable, pcBuffer + uOffset,
+         strlen(acKey), pcBuffer + uOffset);
+      ASSURE(iSuccessful);
+      uOffset += strlen(acKey);
+   }
+   uOffset = 0;
+   for (i = 0; i < SLICE_COUNT; i++)
+   {
+      sprintf(acKey, (i % 2) ? "%d:%s" : "%d", i, acSource + 31);
+      ASSURE(SymTable_get(oSymTable, acKey) == pcBuffer + uOffset);
+      ASSURE(SymTable_getN(oSymTable, pcBuffer + uOffset,
+         strlen(acKey)) == pcBuffer + uOffset);
+      uOffset += strlen(acKey);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == SLICE_COUNT + 3);
+
+   SymTable_free(oSymTable);
+   free(pcBuffer);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_getMany(), with batches that span several groups and
+   a table that is in the middle of resizing. */
+
+static void testGetMany(void)
+{
+   enum {BINDING_COUNT = 780};
+   enum {KEY_COUNT = 300};
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTable_T oSymTable;
+   char acKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   const char *apcKeys[KEY_COUNT];
+   void *apvValues[KEY_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   char acValue[] = "value";
+   size_t uFound;
+   size_t uExpected;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_getMany().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty batch finds nothing. */
+   uFound = SymTable_getMany(oSymTable, apcKeys, 0, apvValues);
+   ASSURE(uFound == 0);
+
+   /* Every third key is missing from the table. The last put leaves
+      the table resizing, with bindings in both hash tables. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % 3 == 0)
+         continue;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &acValue[i % 5]);
+      ASSURE(iSuccessful);
+   }
+
+   uExpected = 0;
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", (i * 7) % BINDING_COUNT);
+      apcKeys[i] = acKeys[i];
+      if (((i * 7) % BINDING_COUNT) % 3 != 0)
+         uExpected++;
+   }
+
+   uFound = SymTable_getMany(oSymTable, apcKeys, KEY_COUNT, apvValues);
+   ASSURE(uFound == uExpected);
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(apvValues[i] == SymTable_get(oSymTable, apcKeys[i]));
+
+   /* A batch smaller than a group, with a key repeated. */
+   apcKeys[0] = "1";
+   apcKeys[1] = "3";
+   apcKeys[2] = "1";
+   uFound = SymTable_getMany(oSymTable, apcKeys, 3, apvValues);
+   ASSURE(uFound == 2);
+   ASSURE(apvValues[0] == &acValue[1]);
+   ASSURE(apvValues[1] == NULL);
+   ASSURE(apvValues[2] == &acValue[1]);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newWithCapacity(), SymTable_reserve(), and
+   SymTable_putBulk(). */
+
+static void testBulk(void)
+{
+   enum {BULK_COUNT = 3000};
+   enum {MAX_KEY_LENGTH = 64};
+
+   SymTable_T oSymTable;
+   char (*pacKeys)[MAX_KEY_LENGTH];
+   const char *apcKeys[BULK_COUNT];
+   const void *apvValues[BULK_COUNT];
+   char acLongKey[] = "a key much too long to be stored in a binding";
+   char *pcValue;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_putBulk() and presized tables.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pacKeys = (char (*)[MAX_KEY_LENGTH])
+      malloc(BULK_COUNT * sizeof(*pacKeys));
+   ASSURE(pacKeys != NULL);
+   if (pacKeys == NULL)
+      return;
+
+   /* Odd keys are too long to be stored in their bindings. */
+   for (i = 0; i < BULK_COUNT; i++)
+   {
+      sprintf(pacKeys[i], (i % 2) ? "%d: %s" : "%d", i, acLongKey);
+      apcKeys[i] = pacKeys[i];
+      apvValues[i] = pacKeys[i];
+   }
+
+   /* A presized table behaves like any other. */
+   oSymTable = SymTable_newWithCapacity(BULK_COUNT);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   iSuccessful = SymTable_reserve(oSymTable, 10);
+   ASSURE(iSuccessful);
+
+   /* Bulk loading unique keys into an empty table. */
+   iSuccessful = SymTable_putBulk(oSymTable, apcKeys, apvValues,
+      BULK_COUNT / 2, 1);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BULK_COUNT / 2);
+
+   /* Bulk loading keys that overlap the table, with the duplicate
+      check. The first copy of a key wins, as with SymTable_put(). */
+   apcKeys[BULK_COUNT - 1] = apcKeys[BULK_COUNT - 2];
+   iSuccessful = SymTable_putBulk(oSymTable, apcKeys, apvValues,
+      BULK_COUNT, 0);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BULK_COUNT - 1);
+   for (i = 0; i < BULK_COUNT - 1; i++)
+      ASSURE(SymTable_get(oSymTable, pacKeys[i]) == pacKeys[i]);
+   ASSURE(! SymTable_contains(oSymTable, pacKeys[BULK_COUNT - 1]));
+
+   /* Bulk-loaded bindings can be removed and put again. */
+   for (i = 0; i < BULK_COUNT - 1; i += 2)
+   {
+      pcValue = (char*)SymTable_remove(oSymTable, pacKeys[i]);
+      ASSURE(pcValue == pacKeys[i]);
+   }
+   iSuccessful = SymTable_put(oSymTable, pacKeys[0], acLongKey);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, pacKeys[0]);
+   ASSURE(pcValue == acLongKey);
+
+   /* Keys that are all present leave the table unchanged. */
+   iSuccessful = SymTable_putBulk(oSymTable, apcKeys + 1, apvValues,
+      1, 0);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BULK_COUNT / 2);
+
+   /* Growing a table that holds bindings keeps them all. */
+   iSuccessful = SymTable_reserve(oSymTable, 10 * BULK_COUNT);
+   ASSURE(iSuccessful);
+   for (i = 1; i < BULK_COUNT - 1; i += 2)
+      ASSURE(SymTable_get(oSymTable, pacKeys[i]) == pacKeys[i]);
+   ASSURE(SymTable_getLength(oSymTable) == BULK_COUNT / 2);
+
+   SymTable_free(oSymTable);
+   free(pacKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a table shrinks as bindings are removed, and
+   SymTable_compact(). */
+
+static void testShrink(void)
+{
+   enum {BINDING_COUNT = 20000};
+   enum {MAX_KEY_LENGTH = 16};
+
+   struct SymTableStats sStats;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uResizes;
+   size_t uUnmoved;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing shrinking and SymTable_compact().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Drain a large table down to a few bindings and fill it again,
+      twice, so that it shrinks and grows in both directions while
+      it is resizing. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &acKey[i % 2]);
+      ASSURE(iSuccessful);
+   }
+   /* A shrink does not start while buckets of the last resize are
+      still to move, beyond the 4 the remove itself moves. */
+   for (i = 0; i < BINDING_COUNT - 10; i++)
+   {
+      sprintf(acKey, "%d", i);
+      SymTable_getStats(oSymTable, &sStats, 1);
+      uResizes = sStats.uResizes;
+      uUnmoved = SymTable_getSliceCount(oSymTable)
+         - sStats.uBucketCount;
+      ASSURE(SymTable_remove(oSymTable, acKey) == &acKey[i % 2]);
+      SymTable_getStats(oSymTable, &sStats, 1);
+      if (sStats.uResizes != uResizes)
+         ASSURE(uUnmoved <= 4);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 10);
+   for (i = BINDING_COUNT - 10; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == &acKey[i % 2]);
+   }
+   for (i = 0; i < BINDING_COUNT - 10; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &acKey[i % 2]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+
+   /* Compacting a full table keeps every binding. */
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == &acKey[i % 2]);
+   }
+
+   /* A reserved table keeps its size until it is compacted. */
+   iSuccessful = SymTable_reserve(oSymTable, 4 * BINDING_COUNT);
+   ASSURE(iSuccessful);
+   for (i = 1; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &acKey[i % 2]);
+   }
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   ASSURE(SymTable_get(oSymTable, "0") == &acKey[0]);
+
+   /* Compacting an empty table leaves a usable table. */
+   ASSURE(SymTable_remove(oSymTable, "0") == &acKey[0]);
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", acKey);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "Ruth") == acKey);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a cursor started while the table is resizing, with lookups
+   moving buckets between the pairs it returns. */
+
+static void testIterResize(void)
+{
+   enum {MAX_BINDING_COUNT = 5000};
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTable_T oSymTable;
+   struct SymTableIter sIter;
+   char acKeys[MAX_BINDING_COUNT][MAX_KEY_LENGTH];
+   int aiSeen[MAX_BINDING_COUNT];
+   const char *pcKey;
+   void *pvValue;
+   size_t uSlices;
+   int iSuccessful;
+   int iBindingCount;
+   int iPairs;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a cursor on a resizing table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Put keys until a put starts a resize, which adds the buckets of
+      the new hash table to the slices. */
+   iBindingCount = 0;
+   uSlices = SymTable_getSliceCount(oSymTable);
+   while (iBindingCount < MAX_BINDING_COUNT
+      && SymTable_getSliceCount(oSymTable) <= uSlices)
+   {
+      uSlices = SymTable_getSliceCount(oSymTable);
+      sprintf(acKeys[iBindingCount], "%d", iBindingCount);
+      aiSeen[iBindingCount] = 0;
+      iSuccessful = SymTable_put(oSymTable, acKeys[iBindingCount],
+         &aiSeen[iBindingCount]);
+      ASSURE(iSuccessful);
+      iBindingCount++;
+   }
+   ASSURE(iBindingCount < MAX_BINDING_COUNT);
+
+   SymTable_iterBegin(oSymTable, &sIter);
+   iPairs = 0;
+   while (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+   {
+      (*(int*)pvValue)++;
+      iPairs++;
+      ASSURE(SymTable_get(oSymTable, acKeys[iPairs % iBindingCount])
+         == &aiSeen[iPairs % iBindingCount]);
+   }
+   ASSURE(iPairs == iBindingCount);
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(aiSeen[i] == 1);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the call in the int *pvExtra and return pvSourceValue, so
+   that a merged key takes the value of the source table.  pcKey and
+   pvDestValue are unused. */
+
+static void *takeSource(const char *pcKey, void *pvDestValue,
+   void *pvSourceValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvDestValue;
+   (*(int*)pvExtra)++;
+   return pvSourceValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_merge() with bindings of every kind: short and long
+   keys, keys shared with atoms, and bulk-loaded keys. */
+
+static void testMerge(void)
+{
+   enum {MERGE_COUNT = 2000};
+   enum {MAX_KEY_LENGTH = 64};
+
+   SymTable_T oDest;
+   SymTable_T oSource;
+   char (*pacKeys)[MAX_KEY_LENGTH];
+   const char *apcKeys[MERGE_COUNT / 4];
+   const void *apvValues[MERGE_COUNT / 4];
+   char acLongKey[] = "a key much too long to be stored in a binding";
+   char acDest[] = "dest";
+   SymAtom_T oAtom;
+   int iResolved;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_merge().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pacKeys = (char (*)[MAX_KEY_LENGTH])
+      malloc(MERGE_COUNT * sizeof(*pacKeys));
+   ASSURE(pacKeys != NULL);
+   if (pacKeys == NULL)
+      return;
+   for (i = 0; i < MERGE_COUNT; i++)
+      sprintf(pacKeys[i], (i % 3) ? "%d" : "%d: %s", i, acLongKey);
+
+   oDest = SymTable_new();
+   oSource = SymTable_new();
+   ASSURE(oDest != NULL);
+   ASSURE(oSource != NULL);
+
+   /* The first quarter is bulk-loaded, the second put with atoms, and
+      the rest put one by one. */
+   for (i = 0; i < MERGE_COUNT / 4; i++)
+   {
+      apcKeys[i] = pacKeys[i];
+      apvValues[i] = pacKeys[i];
+   }
+   iSuccessful = SymTable_putBulk(oSource, apcKeys, apvValues,
+      MERGE_COUNT / 4, 1);
+   ASSURE(iSuccessful);
+   for (i = MERGE_COUNT / 4; i < MERGE_COUNT / 2; i++)
+   {
+      oAtom = SymTable_intern(oSource, pacKeys[i]);
+      ASSURE(oAtom != NULL);
+      iSuccessful = SymTable_putAtom(oSource, oAtom, pacKeys[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = MERGE_COUNT / 2; i < MERGE_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSource, pacKeys[i], pacKeys[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Every tenth key is in both tables. */
+   for (i = 0; i < MERGE_COUNT; i += 10)
+   {
+      iSuccessful = SymTable_put(oDest, pacKeys[i], acDest);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oDest, "only in dest", acDest);
+   ASSURE(iSuccessful);
+
+   iResolved = 0;
+   iSuccessful = SymTable_merge(oDest, oSource, takeSource, &iResolved);
+   ASSURE(iSuccessful);
+   ASSURE(iResolved == MERGE_COUNT / 10);
+   ASSURE(SymTable_getLength(oSource) == 0);
+   ASSURE(SymTable_getLength(oDest) == MERGE_COUNT + 1);
+
+   /* The merged bindings outlive the source table. */
+   SymTable_free(oSource);
+   for (i = 0; i < MERGE_COUNT; i++)
+      ASSURE(SymTable_get(oDest, pacKeys[i]) == pacKeys[i]);
+   ASSURE(SymTable_get(oDest, "only in dest") == acDest);
+   for (i = 0; i < MERGE_COUNT; i += 2)
+      ASSURE(SymTable_remove(oDest, pacKeys[i]) == pacKeys[i]);
+
+   /* Without a callback, the destination keeps its value, and the
+      emptied source can be used again. */
+   oSource = SymTable_new();
+   ASSURE(oSource != NULL);
+   iSuccessful = SymTable_put(oSource, "only in dest", acLongKey);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_merge(oDest, oSource, NULL, NULL);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oDest, "only in dest") == acDest);
+   iSuccessful = SymTable_put(oSource, "only in dest", acLongKey);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSource) == 1);
+
+   SymTable_free(oSource);
+   SymTable_free(oDest);
+   free(pacKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_seed(), and that the other functions of a seeded
+   table agree with it. */
+
+static void testSeed(void)
+{
+   enum {SEED_COUNT = 3000};
+
+   static const char *apcColliding[] = {"250", "469", "947", "1303",
+      "2016"};
+   unsigned char aucSeed[SYMTABLE_SEED_LENGTH];
+   SymTable_T oSymTable;
+   SymTable_T oOther;
+   char acKey[16];
+   const char *apcKeys[5];
+   void *apvValues[5];
+   SymAtom_T oAtom;
+   size_t uHash;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_seed().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < SYMTABLE_SEED_LENGTH; i++)
+      aucSeed[i] = (unsigned char)(i * 37 + 11);
+
+   /* Only an empty table can be seeded. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "250", "250");
+   ASSURE(iSuccessful);
+   ASSURE(! SymTable_seed(oSymTable, aucSeed));
+   ASSURE(SymTable_remove(oSymTable, "250") != NULL);
+   oAtom = SymTable_intern(oSymTable, "250");
+   ASSURE(oAtom != NULL);
+   ASSURE(! SymTable_seed(oSymTable, aucSeed));
+   SymTable_free(oSymTable);
+
+   /* Tables with the same seed hash alike; tables with random seeds
+      do not. */
+   oSymTable = SymTable_new();
+   oOther = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(oOther != NULL);
+   ASSURE(SymTable_seed(oSymTable, aucSeed));
+   ASSURE(SymTable_seed(oOther, aucSeed));
+   ASSURE(SymTable_hashKey(oSymTable, "250", 3)
+      == SymTable_hashKey(oOther, "250", 3));
+   SymTable_free(oOther);
+   oOther = SymTable_new();
+   ASSURE(oOther != NULL);
+   ASSURE(SymTable_seed(oOther, NULL));
+   ASSURE(SymTable_hashKey(oSymTable, "250", 3)
+      != SymTable_hashKey(oOther, "250", 3));
+
+   /* The keys that share a bucket in testCollisions, and enough more
+      to resize the table, behave as in any table. */
+   for (i = 0; i < 5; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcColliding[i],
+         apcColliding[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < SEED_COUNT; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < 5; i++)
+      ASSURE(SymTable_get(oSymTable, apcColliding[i])
+         == apcColliding[i]);
+   for (i = 0; i < SEED_COUNT; i += 2)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == oSymTable);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 5 + SEED_COUNT / 2);
+
+   /* The N, Hashed, atom, and batch functions use the seed too. */
+   uHash = SymTable_hashKey(oSymTable, "Gehrig!", 6);
+   iSuccessful = SymTable_putHashed(oSymTable, "Gehrig", 6, uHash,
+      "Gehrig");
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_containsN(oSymTable, "Gehrig!", 6));
+   oAtom = SymTable_intern(oSymTable, "Gehrig");
+   ASSURE(oAtom != NULL);
+   ASSURE(SymTable_getAtom(oSymTable, oAtom) != NULL);
+   for (i = 0; i < 5; i++)
+      apcKeys[i] = apcColliding[i];
+   ASSURE(SymTable_getMany(oSymTable, apcKeys, 5, apvValues) == 5);
+   ASSURE(apvValues[2] == apcColliding[2]);
+
+   /* Merging rehashes the keys of a table that hashes differently. */
+   iSuccessful = SymTable_merge(oOther, oSymTable, NULL, NULL);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oOther) == 6 + SEED_COUNT / 2);
+   for (i = 0; i < 5; i++)
+      ASSURE(SymTable_get(oOther, apcColliding[i]) == apcColliding[i]);
+   ASSURE(SymTable_contains(oOther, "Gehrig"));
+   ASSURE(SymTable_contains(oOther, "k1"));
+   ASSURE(! SymTable_contains(oOther, "k0"));
+
+   SymTable_free(oSymTable);
+   SymTable_free(oOther);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bindings in the chains *psStats counted,
+   assuming none holds SYMTABLE_STATS_CHAINS - 1 or more. */
+
+static size_t countedBindings(const struct SymTableStats *psStats)
+{
+   size_t uBindings = 0;
+   size_t u;
+
+   for (u = 0; u < SYMTABLE_STATS_CHAINS; u++)
+      uBindings += u * psStats->auHistogram[u];
+   return uBindings;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_getStats(), whole and sampled. */
+
+static void testStats(void)
+{
+   enum {STATS_COUNT = 2000};
+
+   struct SymTableStats sStats;
+   struct SymTableIter sIter;
+   SymTable_T oSymTable;
+   char acKey[16];
+   size_t uEmptyBytes;
+   size_t uSlices;
+   size_t uSampled;
+   size_t u;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_getStats().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A new table. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_getStats(oSymTable, &sStats, 0);
+   ASSURE(sStats.uBucketCount == 509);
+   ASSURE(sStats.uGrowthIndex == 0);
+   ASSURE(sStats.uBindings == 0);
+   ASSURE(sStats.dLoadFactor == 0.0);
+   ASSURE(sStats.uChains == 509);
+   ASSURE(sStats.uEmptyChains == 509);
+   ASSURE(sStats.auHistogram[0] == 509);
+   ASSURE(sStats.uMaxChain == 0);
+   ASSURE(sStats.dMeanChain == 0.0);
+   ASSURE(sStats.uResizes == 0);
+   ASSURE(sStats.uBytes >= 509 * sizeof(void *));
+   uEmptyBytes = sStats.uBytes;
+
+   /* The keys of testCollisions, and the memory they take. */
+   iSuccessful = SymTable_put(oSymTable, "250", "250");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "469", "469");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "947", "947");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable,
+      "a key much too long to be stored in a binding", "long");
+   ASSURE(iSuccessful);
+   SymTable_getStats(oSymTable, &sStats, 0);
+   ASSURE(sStats.uBindings == 4);
+   ASSURE(sStats.uEmptyChains + sStats.auHistogram[1]
+      + sStats.auHistogram[2] + sStats.auHistogram[3]
+      + sStats.auHistogram[4] == 509);
+   ASSURE(countedBindings(&sStats) == 4);
+   ASSURE(sStats.uMaxChain >= 1);
+   ASSURE(sStats.dMeanChain
+      == 4.0 / (double)(sStats.uChains - sStats.uEmptyChains));
+   ASSURE(sStats.uBytes > uEmptyBytes + 3 * sizeof(void *));
+   ASSURE(SymTable_remove(oSymTable, "250") != NULL);
+   ASSURE(SymTable_remove(oSymTable, "469") != NULL);
+   ASSURE(SymTable_remove(oSymTable, "947") != NULL);
+   ASSURE(SymTable_remove(oSymTable,
+      "a key much too long to be stored in a binding") != NULL);
+   SymTable_getStats(oSymTable, &sStats, 0);
+   ASSURE(sStats.uBytes == uEmptyBytes);
+
+   /* Growing counts resizes, and the chains stay whole while a
+      resize is under way. */
+   for (i = 0; i < STATS_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, oSymTable);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getStats(oSymTable, &sStats, 0);
+   ASSURE(sStats.uBindings == STATS_COUNT);
+   ASSURE(sStats.uResizes == sStats.uGrowthIndex);
+   ASSURE(sStats.uGrowthIndex >= 2);
+   ASSURE(sStats.uChains == SymTable_getSliceCount(oSymTable));
+   ASSURE(sStats.dLoadFactor
+      == (double)STATS_COUNT / (double)sStats.uBucketCount);
+   ASSURE(sStats.uMaxChain < SYMTABLE_STATS_CHAINS - 1);
+   ASSURE(countedBindings(&sStats) == STATS_COUNT);
+
+   /* A cursor finishes the resize. Two samples that make up the whole
+      table count every binding once. */
+   SymTable_iterBegin(oSymTable, &sIter);
+   SymTable_iterEnd(&sIter);
+   uSlices = SymTable_getSliceCount(oSymTable);
+   ASSURE(uSlices == sStats.uBucketCount);
+   SymTable_getStats(oSymTable, &sStats, uSlices / 3);
+   ASSURE(sStats.uChains == uSlices / 3);
+   uSampled = countedBindings(&sStats);
+   SymTable_getStats(oSymTable, &sStats, uSlices - uSlices / 3);
+   ASSURE(sStats.uChains == uSlices - uSlices / 3);
+   uSampled += countedBindings(&sStats);
+   ASSURE(uSampled == STATS_COUNT);
+   SymTable_getStats(oSymTable, &sStats, 2 * uSlices);
+   ASSURE(sStats.uChains == uSlices);
+
+   /* Shrinking counts too. */
+   u = sStats.uResizes;
+   for (i = 0; i < STATS_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == oSymTable);
+   }
+   SymTable_getStats(oSymTable, &sStats, 0);
+   ASSURE(sStats.uResizes > u);
+   ASSURE(sStats.uBindings == 0);
+   ASSURE(countedBindings(&sStats) == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_merge() moves the memory of the bindings it
+   relinks from the source's stats to the destination's. */
+
+static void testStatsMerge(void)
+{
+   enum {MERGE_COUNT = 100};
+
+   struct SymTableStats sStats;
+   SymTable_T oDest;
+   SymTable_T oSource;
+   char acKey[64];
+   size_t uDestBytes;
+   size_t uSourceBytes;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_getStats() across SymTable_merge().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oDest = SymTable_new();
+   ASSURE(oDest != NULL);
+   oSource = SymTable_new();
+   ASSURE(oSource != NULL);
+   iSuccessful = SymTable_put(oDest, "Ruth", "Ruth");
+   ASSURE(iSuccessful);
+   SymTable_getStats(oDest, &sStats, 0);
+   uDestBytes = sStats.uBytes;
+   SymTable_getStats(oSource, &sStats, 0);
+   uSourceBytes = sStats.uBytes;
+
+   /* Short keys stay in their bindings, and long keys own their
+      memory; both are relinked as they are. */
+   for (i = 0; i < MERGE_COUNT; i++)
+   {
+      sprintf(acKey, (i % 2) ? "%d" : "%d: a key much too long to be "
+         "stored in a binding", i);
+      iSuccessful = SymTable_put(oSource, acKey, oSource);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getStats(oSource, &sStats, 0);
+   ASSURE(sStats.uBytes > uSourceBytes);
+
+   iSuccessful = SymTable_merge(oDest, oSource, NULL, NULL);
+   ASSURE(iSuccessful);
+   SymTable_getStats(oSource, &sStats, 0);
+   ASSURE(sStats.uBindings == 0);
+   ASSURE(sStats.uBytes == uSourceBytes);
+   SymTable_getStats(oDest, &sStats, 0);
+   ASSURE(sStats.uBindings == MERGE_COUNT + 1);
+   ASSURE(sStats.uBytes > uDestBytes);
+
+   /* Removing the merged keys gives back all they took. */
+   for (i = 0; i < MERGE_COUNT; i++)
+   {
+      sprintf(acKey, (i % 2) ? "%d" : "%d: a key much too long to be "
+         "stored in a binding", i);
+      ASSURE(SymTable_remove(oDest, acKey) == oSource);
+   }
+   SymTable_getStats(oDest, &sStats, 0);
+   ASSURE(sStats.uBindings == 1);
+   ASSURE(sStats.uBytes == uDestBytes);
+
+   SymTable_free(oDest);
+   SymTable_free(oSource);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the counter named pcName that SymTable_dumpCounters()
+   writes for oSymTable, or 0 if it writes none of that name. */
+
+static unsigned long counterOf(SymTable_T oSymTable, const char *pcName)
+{
+   char acLine[128];
+   FILE *psFile;
+   size_t uLength = strlen(pcName);
+   unsigned long ulCounter = 0;
+
+   psFile = tmpfile();
+   ASSURE(psFile != NULL);
+   SymTable_dumpCounters(oSymTable, psFile);
+   rewind(psFile);
+   while (fgets(acLine, (int)sizeof(acLine), psFile) != NULL)
+      if (strncmp(acLine, pcName, uLength) == 0
+         && acLine[uLength] == ' ')
+         ASSURE(sscanf(acLine + uLength, "%lu", &ulCounter) == 1);
+   fclose(psFile);
+   return ulCounter;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_dumpCounters(), whose counters only count when
+   symtablehash.c is compiled with SYMTABLE_INSTRUMENT. */
+
+static void testCounters(void)
+{
+   enum {GROW_COUNT = 600};
+
+   SymTable_T oSymTable;
+   char acLine[128];
+   char acKey[16];
+   FILE *psFile;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_dumpCounters().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Without the counters, the dump says so and nothing else. */
+   psFile = tmpfile();
+   ASSURE(psFile != NULL);
+   SymTable_dumpCounters(oSymTable, psFile);
+   rewind(psFile);
+   ASSURE(fgets(acLine, (int)sizeof(acLine), psFile) != NULL);
+   if (strncmp(acLine, "counters not compiled in", 24) == 0)
+   {
+      ASSURE(fgets(acLine, (int)sizeof(acLine), psFile) == NULL);
+      fclose(psFile);
+      SymTable_free(oSymTable);
+      return;
+   }
+   fclose(psFile);
+
+   /* A new table has allocated itself and its hash table. */
+   ASSURE(counterOf(oSymTable, "SymTable_put") == 0);
+   ASSURE(counterOf(oSymTable, "hashes") == 0);
+   ASSURE(counterOf(oSymTable, "mallocs") == 2);
+   ASSURE(counterOf(oSymTable, "frees") == 0);
+
+   /* The keys of testCollisions share a bucket but not a hash code,
+      so only the keys found are compared. */
+   iSuccessful = SymTable_put(oSymTable, "250", "250");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "469", "469");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "947", "947");
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "250") != NULL);
+   ASSURE(SymTable_get(oSymTable, "947") != NULL);
+   ASSURE(counterOf(oSymTable, "SymTable_put") == 3);
+   ASSURE(counterOf(oSymTable, "SymTable_get") == 2);
+   ASSURE(counterOf(oSymTable, "hashes") == 5);
+   ASSURE(counterOf(oSymTable, "key compares") == 2);
+   ASSURE(counterOf(oSymTable, "nodes visited") >= 2);
+   ASSURE(counterOf(oSymTable, "mallocs") == 5);
+
+   /* A function counts once even where it calls another. */
+   ASSURE(counterOf(oSymTable, "SymTable_getHashed") == 0);
+   iSuccessful = SymTable_upsert(oSymTable, "250", "again");
+   ASSURE(iSuccessful);
+   ASSURE(counterOf(oSymTable, "SymTable_upsert") == 1);
+   ASSURE(counterOf(oSymTable, "SymTable_findOrInsert") == 0);
+
+   /* Removes free, and growing expands. */
+   ASSURE(SymTable_remove(oSymTable, "469") != NULL);
+   ASSURE(counterOf(oSymTable, "frees") == 1);
+   ASSURE(counterOf(oSymTable, "expands") == 0);
+   for (i = 0; i < GROW_COUNT; i++)
+   {
+      sprintf(acKey, "key%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acKey);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(counterOf(oSymTable, "SymTable_put") == 3 + GROW_COUNT);
+   ASSURE(counterOf(oSymTable, "expands") == 1);
+   ASSURE(counterOf(oSymTable, "mallocs") == 6 + GROW_COUNT);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the extensions of the hash table implementation of the
+   SymTable ADT.  Write the output of the tests to stdout. Return 0. */
+
+int main(void)
+{
+   testAtoms();
+   testSlices();
+   testGetMany();
+   testBulk();
+   testShrink();
+   testIterResize();
+   testMerge();
+   testSeed();
+   testStats();
+   testStatsMerge();
+   testCounters();
+
+   printf("------------------------------------------------------\n");
+   printf("End of testsymtablehashext.\n");
+   return 0;
+}
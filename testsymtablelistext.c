@@ -0,0 +1,265 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablelistext.c                                              */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtablelist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {KEY_COUNT = 500};
+enum {MAX_KEY_LENGTH = 8};
+enum {MAX_ORDER_LENGTH = 64};
+
+/* the keys, "0" through "KEY_COUNT - 1" */
+static char acKeys[KEY_COUNT][MAX_KEY_LENGTH];
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next value of the pseudo-random sequence whose state is
+   *puState. */
+
+static size_t nextRandom(size_t *puState)
+{
+   *puState = *puState * 6364136223846793005U + 1442695040888963407U;
+   return *puState >> 16;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if a cursor over oSymTable returns the keys in the
+   order of pcOrder, a list of keys separated by commas, and 0 (FALSE)
+   if not. */
+
+static int hasOrder(SymTable_T oSymTable, const char *pcOrder)
+{
+   struct SymTableIter sIter;
+   char acOrder[MAX_ORDER_LENGTH];
+   const char *pcKey;
+   void *pvValue;
+
+   acOrder[0] = '\0';
+   SymTable_iterBegin(oSymTable, &sIter);
+   while (SymTable_iterNext(&sIter, &pcKey, &pvValue))
+   {
+      if (strlen(acOrder) + strlen(pcKey) + 2 > MAX_ORDER_LENGTH)
+         return 0;
+      if (acOrder[0] != '\0')
+         strcat(acOrder, ",");
+      strcat(acOrder, pcKey);
+   }
+   return strcmp(acOrder, pcOrder) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object with policy eOrder, holding the keys
+   "0" through "9" put in that order, so that the list holds them from
+   "9" down to "0". */
+
+static SymTable_T newDigitTable(enum SymTableOrder eOrder)
+{
+   SymTable_T oSymTable;
+   int iSuccessful;
+   int i;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      exit(EXIT_FAILURE);
+   SymTable_setOrder(oSymTable, eOrder);
+
+   for (i = 0; i < 10; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, acKeys[i], acKeys[i]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(hasOrder(oSymTable, "9,8,7,6,5,4,3,2,1,0"));
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test how each policy reorders the list on successful lookups, and
+   that other calls leave the order alone. */
+
+static void testPolicies(void)
+{
+   SymTable_T oSymTable;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the reordering policies.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* With no policy, lookups leave the order alone. */
+   oSymTable = newDigitTable(SYMTABLE_ORDER_NONE);
+   ASSURE(SymTable_get(oSymTable, "3") == acKeys[3]);
+   ASSURE(SymTable_contains(oSymTable, "0"));
+   ASSURE(hasOrder(oSymTable, "9,8,7,6,5,4,3,2,1,0"));
+   SymTable_free(oSymTable);
+
+   /* Move-to-front.  Failed lookups, failed puts, and replacements
+      leave the order alone. */
+   oSymTable = newDigitTable(SYMTABLE_ORDER_MOVE_TO_FRONT);
+   ASSURE(SymTable_get(oSymTable, "3") == acKeys[3]);
+   ASSURE(hasOrder(oSymTable, "3,9,8,7,6,5,4,2,1,0"));
+   ASSURE(SymTable_contains(oSymTable, "0"));
+   ASSURE(hasOrder(oSymTable, "0,3,9,8,7,6,5,4,2,1"));
+   ASSURE(SymTable_get(oSymTable, "0") == acKeys[0]);
+   ASSURE(SymTable_get(oSymTable, "10") == NULL);
+   iSuccessful = SymTable_put(oSymTable, "5", acKeys[5]);
+   ASSURE(! iSuccessful);
+   ASSURE(SymTable_replace(oSymTable, "4", acKeys[4]) == acKeys[4]);
+   ASSURE(hasOrder(oSymTable, "0,3,9,8,7,6,5,4,2,1"));
+   SymTable_free(oSymTable);
+
+   /* Transpose. */
+   oSymTable = newDigitTable(SYMTABLE_ORDER_TRANSPOSE);
+   ASSURE(SymTable_get(oSymTable, "3") == acKeys[3]);
+   ASSURE(hasOrder(oSymTable, "9,8,7,6,5,3,4,2,1,0"));
+   ASSURE(SymTable_get(oSymTable, "3") == acKeys[3]);
+   ASSURE(SymTable_contains(oSymTable, "8"));
+   ASSURE(hasOrder(oSymTable, "8,9,7,6,3,5,4,2,1,0"));
+   ASSURE(SymTable_get(oSymTable, "8") == acKeys[8]);
+   ASSURE(hasOrder(oSymTable, "8,9,7,6,3,5,4,2,1,0"));
+   SymTable_free(oSymTable);
+
+   /* Count.  A key moves in front of the first key found fewer
+      times. */
+   oSymTable = newDigitTable(SYMTABLE_ORDER_COUNT);
+   ASSURE(SymTable_get(oSymTable, "3") == acKeys[3]);
+   ASSURE(SymTable_get(oSymTable, "3") == acKeys[3]);
+   ASSURE(hasOrder(oSymTable, "3,9,8,7,6,5,4,2,1,0"));
+   ASSURE(SymTable_contains(oSymTable, "5"));
+   ASSURE(hasOrder(oSymTable, "3,5,9,8,7,6,4,2,1,0"));
+   ASSURE(SymTable_get(oSymTable, "5") == acKeys[5]);
+   ASSURE(hasOrder(oSymTable, "3,5,9,8,7,6,4,2,1,0"));
+   ASSURE(SymTable_get(oSymTable, "5") == acKeys[5]);
+   ASSURE(hasOrder(oSymTable, "5,3,9,8,7,6,4,2,1,0"));
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test random puts, lookups, and removes under each policy against a
+   record of the keys that should be in the table. */
+
+static void testRandom(void)
+{
+   static const enum SymTableOrder aeOrders[] = {SYMTABLE_ORDER_NONE,
+      SYMTABLE_ORDER_MOVE_TO_FRONT, SYMTABLE_ORDER_TRANSPOSE,
+      SYMTABLE_ORDER_COUNT};
+
+   SymTable_T oSymTable;
+   int aiPresent[KEY_COUNT];
+   size_t uState = 217;
+   size_t uPresent;
+   size_t uStep;
+   int iSuccessful;
+   int iOrder;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing random calls under each reordering policy.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iOrder = 0; iOrder < 4; iOrder++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         exit(EXIT_FAILURE);
+      SymTable_setOrder(oSymTable, aeOrders[iOrder]);
+      for (i = 0; i < KEY_COUNT; i++)
+         aiPresent[i] = 0;
+      uPresent = 0;
+
+      for (uStep = 0; uStep < 20 * KEY_COUNT; uStep++)
+      {
+         /* Skew the lookups toward the low keys. */
+         i = (int)(nextRandom(&uState) % KEY_COUNT);
+         if (nextRandom(&uState) % 2 == 0)
+            i %= 10;
+         switch (nextRandom(&uState) % 4)
+         {
+            case 0:
+               iSuccessful = SymTable_put(oSymTable, acKeys[i],
+                  acKeys[i]);
+               ASSURE(iSuccessful == ! aiPresent[i]);
+               if (! aiPresent[i])
+                  uPresent++;
+               aiPresent[i] = 1;
+               break;
+            case 1:
+               ASSURE(SymTable_get(oSymTable, acKeys[i])
+                  == (aiPresent[i] ? acKeys[i] : NULL));
+               break;
+            case 2:
+               ASSURE(SymTable_contains(oSymTable, acKeys[i])
+                  == aiPresent[i]);
+               break;
+            default:
+               if (nextRandom(&uState) % 3 != 0)
+                  break;
+               ASSURE(SymTable_remove(oSymTable, acKeys[i])
+                  == (aiPresent[i] ? acKeys[i] : NULL));
+               if (aiPresent[i])
+                  uPresent--;
+               aiPresent[i] = 0;
+               break;
+         }
+      }
+
+      ASSURE(SymTable_getLength(oSymTable) == uPresent);
+      for (i = 0; i < KEY_COUNT; i++)
+         ASSURE(SymTable_contains(oSymTable, acKeys[i])
+            == aiPresent[i]);
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the functions that only the linked list implementation of the
+   SymTable ADT provides. Write the output of the tests to stdout.
+   Return 0. */
+
+int main(void)
+{
+   int i;
+
+   for (i = 0; i < KEY_COUNT; i++)
+      sprintf(acKeys[i], "%d", i);
+
+   testPolicies();
+   testRandom();
+
+   printf("------------------------------------------------------\n");
+   printf("End of testsymtablelistext.\n");
+   return 0;
+}
@@ -0,0 +1,207 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableparallel.c                                             */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtableparallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {KEY_COUNT = 40000};
+enum {MAX_KEY_LENGTH = 16};
+enum {MAX_THREADS = 7};
+
+/* the keys, "0" through "KEY_COUNT - 1" */
+static char acKeys[KEY_COUNT][MAX_KEY_LENGTH];
+
+/* aiNumbers[i] is i, and is the value of key i */
+static int aiNumbers[KEY_COUNT];
+
+/* number of times each key was visited */
+static int aiVisits[KEY_COUNT];
+
+/* A Sum is the accumulator of sumBinding: the number of bindings seen
+   and the total of their values. */
+
+struct Sum
+{
+   size_t uCount;
+   long lTotal;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the visits of the key whose number is *pvValue.  Each key
+   is visited by one thread only, so no lock is needed.  pcKey and
+   pvExtra are unused. */
+
+static void visitBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvExtra;
+   aiVisits[*(int*)pvValue]++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the binding whose value is pvValue to the Sum pvAccumulator.
+   pcKey is unused. */
+
+static void sumBinding(const char *pcKey, void *pvValue,
+   void *pvAccumulator)
+{
+   struct Sum *psSum = (struct Sum*)pvAccumulator;
+
+   (void)pcKey;
+   psSum->uCount++;
+   psSum->lTotal += *(int*)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the Sum pvOther to the Sum pvAccumulator. */
+
+static void combineSums(void *pvAccumulator, void *pvOther)
+{
+   struct Sum *psSum = (struct Sum*)pvAccumulator;
+   struct Sum *psOther = (struct Sum*)pvOther;
+
+   psSum->uCount += psOther->uCount;
+   psSum->lTotal += psOther->lTotal;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that SymTable_mapParallel and SymTable_mapReduce with
+   uThreads threads visit each of the first uKeyCount keys, which are
+   the contents of oSymTable, exactly once. */
+
+static void checkTable(SymTable_T oSymTable, size_t uKeyCount,
+   size_t uThreads)
+{
+   struct Sum asSums[MAX_THREADS];
+   void *apvSums[MAX_THREADS];
+   size_t u;
+   int iVisitedOnce;
+
+   assert(uThreads <= MAX_THREADS);
+
+   memset(aiVisits, 0, sizeof(aiVisits));
+   SymTable_mapParallel(oSymTable, uThreads, visitBinding, NULL);
+   iVisitedOnce = 1;
+   for (u = 0; u < KEY_COUNT; u++)
+      if (aiVisits[u] != (u < uKeyCount))
+         iVisitedOnce = 0;
+   ASSURE(iVisitedOnce);
+
+   for (u = 0; u < uThreads; u++)
+   {
+      asSums[u].uCount = 0;
+      asSums[u].lTotal = 0;
+      apvSums[u] = &asSums[u];
+   }
+   SymTable_mapReduce(oSymTable, uThreads, sumBinding, combineSums,
+      apvSums);
+   ASSURE(asSums[0].uCount == uKeyCount);
+   ASSURE(asSums[0].lTotal ==
+      (long)uKeyCount * ((long)uKeyCount - 1) / 2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_mapParallel and SymTable_mapReduce on tables of many
+   sizes, including tables in the middle of a resize. */
+
+static void testParallel(void)
+{
+   SymTable_T oSymTable;
+   size_t uThreads;
+   size_t uSlices;
+   size_t uPreviousSlices;
+   int iSawResize;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable_mapParallel() and SymTable_mapReduce().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i);
+      aiNumbers[i] = i;
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      exit(EXIT_FAILURE);
+
+   /* An empty table, and more threads than slices. */
+   for (uThreads = 1; uThreads <= MAX_THREADS; uThreads++)
+      checkTable(oSymTable, 0, uThreads);
+
+   /* Check after every put while the table is small, so that the
+      checks see every step of several resizes.  While a resize is
+      under way, the table has the slices of both bucket arrays, and
+      their number falls as buckets move to the new array. */
+   iSawResize = 0;
+   uPreviousSlices = SymTable_getSliceCount(oSymTable);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, acKeys[i], &aiNumbers[i]);
+      ASSURE(iSuccessful);
+      uSlices = SymTable_getSliceCount(oSymTable);
+      if (uSlices < uPreviousSlices)
+         iSawResize = 1;
+      uPreviousSlices = uSlices;
+      if (i < 3000 || i % 4999 == 0)
+         checkTable(oSymTable, (size_t)i + 1,
+            (size_t)i % MAX_THREADS + 1);
+   }
+   ASSURE(iSawResize);
+
+   for (uThreads = 1; uThreads <= MAX_THREADS; uThreads++)
+      checkTable(oSymTable, KEY_COUNT, uThreads);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the parallel map functions of the hash table implementation of
+   the SymTable ADT. Write the output of the tests to stdout.
+   Return 0. */
+
+int main(void)
+{
+   testParallel();
+
+   printf("------------------------------------------------------\n");
+   printf("End of testsymtableparallel.\n");
+   return 0;
+}
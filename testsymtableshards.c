@@ -0,0 +1,275 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableshards.c                                               */
+/* Author: Jacob Penstein                                             */
+/*--------------------------------------------------------------------*/
+
+#include "symtableshards.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the count *pvExtra.  pcKey and pvValue are unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTableShards functions from a single thread. */
+
+static void testBasics(void)
+{
+   enum {SHARD_COUNT = 7};
+   enum {BINDING_COUNT = 3000};
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTableShards_T oShards;
+   SymTableShards_T oOther;
+   char acKeys[BINDING_COUNT][MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   size_t auPerShard[SHARD_COUNT];
+   size_t uShard;
+   size_t uCount;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTableShards functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oShards = SymTableShards_new(SHARD_COUNT);
+   oOther = SymTableShards_new(SHARD_COUNT);
+   ASSURE(oShards != NULL);
+   ASSURE(oOther != NULL);
+   ASSURE(SymTableShards_getShardCount(oShards) == SHARD_COUNT);
+   ASSURE(SymTableShards_getLength(oShards) == 0);
+
+   iSuccessful = SymTableShards_put(oShards, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableShards_put(oShards, "Jeter", acCenterField);
+   ASSURE(! iSuccessful);
+   ASSURE(SymTableShards_contains(oShards, "Jeter"));
+   ASSURE(! SymTableShards_contains(oShards, "Mantle"));
+   ASSURE(SymTableShards_get(oShards, "Jeter") == acShortstop);
+   ASSURE(SymTableShards_replace(oShards, "Jeter", acCenterField)
+      == acShortstop);
+   ASSURE(SymTableShards_remove(oShards, "Jeter") == acCenterField);
+   ASSURE(SymTableShards_remove(oShards, "Jeter") == NULL);
+
+   /* Each key lands in the shard chosen for it, the same one in
+      every object with as many shards, and the keys spread over all
+      the shards. */
+   for (uShard = 0; uShard < SHARD_COUNT; uShard++)
+      auPerShard[uShard] = 0;
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i);
+      iSuccessful = SymTableShards_put(oShards, acKeys[i], acKeys[i]);
+      ASSURE(iSuccessful);
+      uShard = SymTableShards_shardOf(oShards, acKeys[i]);
+      ASSURE(uShard < SHARD_COUNT);
+      ASSURE(uShard == SymTableShards_shardOf(oOther, acKeys[i]));
+      ASSURE(SymTable_get(SymTableShards_getShard(oShards, uShard),
+         acKeys[i]) == acKeys[i]);
+      auPerShard[uShard]++;
+   }
+   for (uShard = 0; uShard < SHARD_COUNT; uShard++)
+      ASSURE(auPerShard[uShard] > BINDING_COUNT / SHARD_COUNT / 2);
+   ASSURE(SymTableShards_getLength(oShards) == BINDING_COUNT);
+
+   uCount = 0;
+   SymTableShards_map(oShards, countBinding, &uCount);
+   ASSURE(uCount == BINDING_COUNT);
+
+   SymTableShards_free(oOther);
+   SymTableShards_free(oShards);
+}
+
+/*--------------------------------------------------------------------*/
+
+enum {THREAD_COUNT = 4};
+enum {SHARD_COUNT = 16};
+enum {KEYS_PER_THREAD = 6000};
+enum {KEY_COUNT = KEYS_PER_THREAD * (THREAD_COUNT + 1) / 2};
+enum {THREAD_KEY_LENGTH = 16};
+
+/* number of tables that hold each key, counting the first one */
+static int aiCounts[KEY_COUNT];
+
+/* the keys, "0" through "KEY_COUNT - 1" */
+static char acKeys[KEY_COUNT][THREAD_KEY_LENGTH];
+
+/* A Filler is the work of one thread of testMerge: it puts keys
+   uFirstKey through uFirstKey + KEYS_PER_THREAD - 1 into a
+   SymTableShards_T object of its own. */
+
+struct Filler
+{
+   SymTableShards_T oShards;
+   size_t uFirstKey;
+   int iFailures;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Fill the table of the Filler pvFiller.  Return NULL. */
+
+static void *fill(void *pvFiller)
+{
+   struct Filler *psFiller = (struct Filler*)pvFiller;
+   size_t u;
+
+   for (u = psFiller->uFirstKey;
+      u < psFiller->uFirstKey + KEYS_PER_THREAD; u++)
+      if (! SymTableShards_put(psFiller->oShards, acKeys[u],
+         &aiCounts[u]))
+         psFiller->iFailures++;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count one more table holding the key of the count pvDestValue, and
+   keep that count as the value.  Only the thread merging the key's
+   shard calls this for the key.  pcKey, pvSourceValue, and pvExtra
+   are unused. */
+
+static void *addCount(const char *pcKey, void *pvDestValue,
+   void *pvSourceValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvSourceValue;
+   (void)pvExtra;
+   (*(int*)pvDestValue)++;
+   return pvDestValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test THREAD_COUNT threads each filling a table of their own with
+   overlapping keys, and merging the tables on several threads. */
+
+static void testMerge(void)
+{
+   SymTableShards_T oDest;
+   SymTableShards_T aoSources[THREAD_COUNT];
+   struct Filler asFillers[THREAD_COUNT];
+   pthread_t aThreads[THREAD_COUNT];
+   int iSuccessful;
+   int iThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableShards_merge().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKeys[i], "%d", i);
+      aiCounts[i] = 1;
+   }
+
+   /* Thread t puts keys t * KEYS_PER_THREAD / 2 and up, so each key
+      but the first and last few thousand is put by two threads. */
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+   {
+      aoSources[iThread] = SymTableShards_new(SHARD_COUNT);
+      ASSURE(aoSources[iThread] != NULL);
+      if (aoSources[iThread] == NULL)
+         exit(EXIT_FAILURE);
+      asFillers[iThread].oShards = aoSources[iThread];
+      asFillers[iThread].uFirstKey =
+         (size_t)iThread * KEYS_PER_THREAD / 2;
+      asFillers[iThread].iFailures = 0;
+      ASSURE(pthread_create(&aThreads[iThread], NULL, fill,
+         &asFillers[iThread]) == 0);
+   }
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+   {
+      ASSURE(pthread_join(aThreads[iThread], NULL) == 0);
+      ASSURE(asFillers[iThread].iFailures == 0);
+   }
+
+   oDest = SymTableShards_new(SHARD_COUNT);
+   ASSURE(oDest != NULL);
+   if (oDest == NULL)
+      exit(EXIT_FAILURE);
+   iSuccessful = SymTableShards_merge(oDest, aoSources, THREAD_COUNT,
+      THREAD_COUNT, addCount, NULL);
+   ASSURE(iSuccessful);
+
+   ASSURE(SymTableShards_getLength(oDest) == KEY_COUNT);
+   for (iThread = 0; iThread < THREAD_COUNT; iThread++)
+   {
+      ASSURE(SymTableShards_getLength(aoSources[iThread]) == 0);
+      SymTableShards_free(aoSources[iThread]);
+   }
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      ASSURE(SymTableShards_get(oDest, acKeys[i]) == &aiCounts[i]);
+      ASSURE(aiCounts[i] == ((i < KEYS_PER_THREAD / 2
+         || i >= KEY_COUNT - KEYS_PER_THREAD / 2) ? 1 : 2));
+   }
+
+   /* More threads than shards is fine too. */
+   aoSources[0] = SymTableShards_new(SHARD_COUNT);
+   ASSURE(aoSources[0] != NULL);
+   if (aoSources[0] == NULL)
+      exit(EXIT_FAILURE);
+   iSuccessful = SymTableShards_put(aoSources[0], "new", acKeys[0]);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableShards_merge(oDest, aoSources, 1,
+      2 * SHARD_COUNT, NULL, NULL);
+   ASSURE(iSuccessful);
+   ASSURE(SymTableShards_get(oDest, "new") == acKeys[0]);
+   ASSURE(SymTableShards_getLength(oDest) == KEY_COUNT + 1);
+
+   SymTableShards_free(aoSources[0]);
+   SymTableShards_free(oDest);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the sharded tables built on the hash table implementation of
+   the SymTable ADT. Write the output of the tests to stdout.
+   Return 0. */
+
+int main(void)
+{
+   testBasics();
+   testMerge();
+
+   printf("------------------------------------------------------\n");
+   printf("End of testsymtableshards.\n");
+   return 0;
+}